@@ -0,0 +1,324 @@
+/*
+* Línea de tiempo de la animación.
+*/
+#include "Animacion.h"
+#include "Penrose.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Generador xorshift32: regresa un número en [0, 1].
+static float aleatorio(uint32_t& estado) {
+    estado ^= estado << 13;
+    estado ^= estado >> 17;
+    estado ^= estado << 5;
+    return (float)(estado >> 8) / (float)0xFFFFFF;
+}
+
+static uint32_t semillaDeTiempo(double t) {
+    uint64_t bits;
+    memcpy(&bits, &t, sizeof(bits));
+    uint32_t s = (uint32_t)(bits ^ (bits >> 32)) * 2654435761u;
+    return s != 0 ? s : 1;
+}
+
+void EstadoCuadro::tablaColores(float tabla[NUM_CLASES][3]) const {
+    const float* porClase[NUM_CLASES];
+    porClase[CLASE_CEROS] = color1;
+    porClase[CLASE_UNOS] = color2;
+    porClase[CLASE_CEROS_PROTAG] = color_cero_protag;
+    porClase[CLASE_UNOS_PROTAG] = color_uno_protag;
+    porClase[CLASE_OJOS_BLANCOS] = color_ojos_blancos;
+    porClase[CLASE_OJOS_NEGROS] = color_ojos_negros;
+    for (int c = 0; c < NUM_CLASES; c++)
+        memcpy(tabla[c], porClase[c], 3 * sizeof(float));
+}
+
+void evaluarFase(int fase, double t, EstadoCuadro& estado) {
+    // Variables
+    float scaleAmount = 1.0f;
+    float aux;
+    float rotAux = 0.0f;
+    glm::mat4& transform = estado.transform;
+    glm::mat4& transform_protag = estado.transform_protag;
+    float* color_cero_protag = estado.color_cero_protag;
+    float* color_uno_protag = estado.color_uno_protag;
+
+    switch (fase) {
+    case 0:                    
+        // ### Inicio
+        // Tiempo: 2 segundos
+        
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));                    
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // El triángulo protagonista va a estar fuera de la escena
+        transform_protag = glm::translate(transform_protag, glm::vec3(1.0f, 0.0f, 0.0f));                    
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
+        break;
+    case 1:
+        // ### Triángulo entra en escena
+        // Tiempo: 1 segundos
+        
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // Triángulo protagonista                            
+        // El triángulo protagonista va a empezar en 1.0 y queremos que llegue a 0
+        transform_protag = glm::translate(transform_protag, glm::vec3(1 - t, 0.0f, 0.0f));                    
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
+        break;
+    case 2:                   
+        // ### Triángulo se para un momento
+        // Tiempo: 1.5 segundos
+         
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        break;
+    case 3:          
+        // ### Triángulo se mueve hacia la trselación y choca.
+        // Tiempo: 1.5 segundos
+        
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // Triángulo protagonista                                        
+        // 0.25\sin\left(\pi\left(\frac{4}{3}x + 0.5\right)\right) - 0.25
+        aux = 0.25 * sin(pi * (((float)4 / (float)3) * t + 0.5)) - 0.25;
+        transform_protag = glm::translate(transform_protag, glm::vec3(aux, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
+        break;
+    case 4:
+        // ### Triángulo se para un momento
+        // Tiempo: 0.5 segundos
+        
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+                            
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        break;
+    case 5: 
+        // ### Triángulo choca varias veces más.
+        // Tiempo: 2 segundos
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // Triángulo protagonista                                        
+        // y\ =\ 0.25\sin\left(\pi\left(3x+\frac{1}{2}\right)\right)-0.25
+        aux = 0.25 * sin(pi * (3 * t + 0.5)) - 0.25;
+        transform_protag = glm::translate(transform_protag, glm::vec3(aux, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        //Cambiamos los colores de los triangulos
+        if (t < .67) {
+            color_cero_protag[0] = 1.0f; color_cero_protag[1] = 0.2f; color_cero_protag[2] = 0.2f;
+            color_uno_protag[0] = 1.0f; color_uno_protag[1] = 0.2f; color_uno_protag[2] = 0.2f;
+        }
+        else if (t < 1.33) {
+            color_cero_protag[0] = 0.0f; color_cero_protag[1] = 0.5f; color_cero_protag[2] = 0.3f;
+            color_uno_protag[0] = 0.0f; color_uno_protag[1] = 0.5f; color_uno_protag[2] = 0.3f;
+        }
+        else {
+            color_cero_protag[0] = 0.2f; color_cero_protag[1] = 0.2f; color_cero_protag[2] = 1.0f;
+            color_uno_protag[0] = 0.2f; color_uno_protag[1] = 0.2f; color_uno_protag[2] = 1.0f;
+        }
+
+        break;
+    case 6:                   
+        // ### Triángulo rota hasta quedar paralelo al suelo
+        // Tiempo: 0.5 segundos
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        rotAux = (float)1 / (float)5 * pi * (float)t;
+        transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        break;                    
+    case 7:
+        // ### Triángulo se cae
+        // Tiempo: 0.5 segundos
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        transform_protag = glm::translate(transform_protag, glm::vec3(0.0f, -2 * (float)t, 0.0f));
+        rotAux = (float)1 / (float)10 * pi;
+        transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
+        break;                    
+    case 8:
+        // Triángulo caído se cambia de color
+        // Tiempo: 4 segundos
+        
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        
+        transform_protag = glm::translate(transform_protag, glm::vec3(0.0f, -1.0f, 0.0f));
+        rotAux = (float)1 / (float)10 * pi;
+        transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // Cambiamos los colores aleatoriamente. La semilla sale del tiempo para que el
+        // mismo instante siempre dé los mismos colores.
+        if (t < 3) {
+            uint32_t semilla = semillaDeTiempo(t);
+            color_cero_protag[0] = aleatorio(semilla);
+            color_cero_protag[1] = aleatorio(semilla);
+            color_cero_protag[2] = aleatorio(semilla);
+            color_uno_protag[0] = aleatorio(semilla);
+            color_uno_protag[1] = aleatorio(semilla);
+            color_uno_protag[2] = aleatorio(semilla);
+        }
+        //Hasta que llegamos al que encaja con la teselación
+        else {
+            color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
+            color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
+        }
+        break;
+    case 9: 
+        // Nuevo triángulo sube
+        // Tiempo: 2 segundos
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        transform_protag = glm::translate(transform_protag, glm::vec3(0.0f, 0.5 * (float)t - 1, 0.0f));
+        rotAux = (float)1 / (float)10 * pi;
+        transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // Cambiamos los colores
+        color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
+        color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
+        break;
+    case 10:
+        // ### Triángulo rota hasta quedar como estaba antes
+        // Tiempo: 2 segundos
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // y=-\frac{\pi}{20}x+\frac{\pi}{10}
+        rotAux = - 0.05 * pi * (float)t + pi / (float)10;
+        transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        // Cambiamos los colores
+        color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
+        color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
+        break;
+    case 11:
+        // ### Triángulo nuevo se para un momento
+        // Tiempo: 1 segundo
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        // Cambiamos los colores
+        color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
+        color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
+
+        break;
+    case 12:
+        // ### Triángulo nuevo se incorpora a la teselación
+        // Tiempo: 2 segundos
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        transform_protag = glm::translate(transform_protag, glm::vec3(-0.25*(float)t, 0.0f, 0.0f));
+        scaleAmount = 0.5f;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
+        // Cambiamos los colores
+        color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
+        color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
+
+        break;
+    case 13:
+        // ### La teselación completa se hace grande
+        // Tiempo:  segundos
+
+        // Teselación principal
+        transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));                    
+        transform_protag = glm::translate(transform_protag, glm::vec3(-0.5f, 0.0f, 0.0f));
+
+        rotAux = 0.5 * (float)t;
+        transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
+        transform = glm::rotate(transform, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
+
+        scaleAmount = 0.5*(float)t + 0.5;
+        transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+        transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
+
+        // Cambiamos los colores
+        color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
+        color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
+        break;
+    default:
+        std::cout << "Índice de tiempo inválido" << std::endl;
+        break;
+    }
+}
+
+double duracionTotal() {
+    double total = 0.0;
+    for (int i = 0; i < NUM_FASES; i++)
+        total += tiempos[i];
+    return total;
+}
+
+bool faseEnTiempo(double T, int& fase, double& t) {
+    double inicio = 0.0;
+    for (int i = 0; i < NUM_FASES; i++) {
+        if (T <= inicio + tiempos[i]) {
+            fase = i;
+            t = T - inicio;
+            return true;
+        }
+        inicio += tiempos[i];
+    }
+    return false;
+}
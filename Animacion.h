@@ -0,0 +1,67 @@
+/*
+* Línea de tiempo de la animación: qué transformaciones y colores tiene cada fase.
+* Se separó de main() para poder evaluarla sin ventana (por ejemplo, desde el
+* rasterizador por software).
+*/
+#ifndef ANIMACION_H
+#define ANIMACION_H
+
+#include <glm/glm.hpp>
+
+#include "Vertice.h"
+
+// Fases de la animación
+/* 0: ### Inicio
+*  1: ### Triángulo entra en escena
+*  2: ### Triángulo se para un momento
+*  3: ### Triángulo se mueve hacia la trselación y choca.
+*  4: ### Triángulo se para un momento
+*  5: ### Triángulo choca varias veces más.
+*  6: ### Triángulo rota hasta quedar paralelo al suelo
+*  7: ### Triángulo se cae
+*  8: ### Triángulo caído se cambia de color
+*  9: ### Nuevo triángulo sube
+* 10: ### Triángulo rota hasta quedar como estaba antes
+* 11: ### Triángulo nuevo se para un momento
+* 12: ### Triángulo nuevo se incorpora a la teselación
+* 13: ### La teselación completa se hace grande
+*/
+const int NUM_FASES = 14;
+//                                 0     1     2     3     4     5     6     7     8     9     10    11    12    13
+const float tiempos[NUM_FASES] = { 2.0f, 1.0f, 1.5f, 1.5f, 0.5f, 2.0f, 0.5f, 0.5f, 4.0f, 2.0f, 2.0f, 1.0f, 2.0f, 3.5f };
+
+// Todo lo que cambia de un cuadro a otro. Por default las matrices son la identidad y
+// los colores son los del inicio de la animación.
+struct EstadoCuadro {
+    glm::mat4 transform = glm::mat4(1.0f);          // Matriz para transformar la teselación principal
+    glm::mat4 transform_protag = glm::mat4(1.0f);   // Matriz para transformar al triángulo protagonista
+
+    float color1[3] = { 0.043f, 0.145f, 0.271f };                  // Color 1 de la teselación principal
+    float color2[3] = { 0.698f, 0.761f, 0.929f };                  // Color 2 de la teselación principal
+    float color_cero_protag[3] = { 0.8705f, 0.7686f, 0.2509f };    // Color cero del triángulo protagonista
+    float color_uno_protag[3] = { 0.8705f, 0.7686f, 0.2509f };     // Color uno del triángulo protagonista
+    float color_ojos_blancos[3] = { 1.0f, 1.0f, 1.0f };            // Color blanco de los ojos del protagonista
+    float color_ojos_negros[3] = { 0.0f, 0.0f, 0.0f };             // Color negro de los ojos del protagonista
+
+    // Tabla de colores indexada por ClaseColor y las dos transformaciones en el orden
+    // que usa transformacionDeClase(), tal como las recibe proyecto1.vs.
+    void tablaColores(float tabla[NUM_CLASES][3]) const;
+    void transformaciones(glm::mat4 t[2]) const { t[0] = transform; t[1] = transform_protag; }
+};
+
+// Ajusta 'estado' para la fase indicada, 't' segundos después de que empezó la fase.
+void evaluarFase(int fase, double t, EstadoCuadro& estado);
+
+// Duración de toda la animación en segundos.
+double duracionTotal();
+
+// Traduce un tiempo 'T' contado desde el inicio de la animación a la fase en la que cae
+// y los segundos 't' transcurridos dentro de esa fase. Cada fase incluye su último
+// instante, igual que en el ciclo de render. Regresa false si T ya pasó del final.
+bool faseEnTiempo(double T, int& fase, double& t);
+
+// En qué fases se dibujan los ojos y el foco.
+inline bool faseDibujaOjos(int fase) { return fase != 13 && fase != 7 && fase != 8; }
+inline bool faseDibujaFoco(int fase) { return fase >= 6 && fase <= 8; }
+
+#endif
@@ -0,0 +1,651 @@
+/*
+* Benchmark del pipeline de geometría (sin ventana).
+*
+* Mide, para cada profundidad de 1 a --max-profundidad (14 por default):
+*   - rueda:       construir la arena y agregar los 9 triángulos de la rueda inicial
+*   - subdividir:  la última generación (de profundidad - 1 a profundidad), en serie
+*   - paralelo:    la misma generación con el grupo de hilos
+*   - soldadura:   soldar y empacar los vértices con su buffer de índices
+*   - rombos:      juntar las mitades de rombo de ese buffer (Rombos.h)
+*   - exacto:      la última generación con coordenadas exactas (Exacto.h), en serie
+*   - sold. exacta: la soldadura de esa generación con llaves exactas
+*   - profundidad: todos los triángulos finales generados en profundidad (Generador.h),
+*                  sin arena; su memoria de trabajo se reporta aparte (bytes_profundidad)
+* y aparte lo que tarda crearCirc() por círculo. Cada medición se repite varias veces y
+* se reporta la mediana; además se cuentan las asignaciones de memoria de cada etapa y
+* el pico de memoria residente del proceso.
+*
+* Al final compara los tipos de coordenada de la subdivisión (double, float y punto
+* fijo) a --error-profundidad (10 por default): memoria por triángulo, tiempo de la
+* última generación en serie, vértices después de soldar y error de cada vértice contra
+* la referencia en double. A esa misma profundidad mide la codificación por direcciones
+* (Direcciones.h) de la rueda completa: bytes por triángulo y tiempo de codificar y de
+* decodificar en lotes. También genera con la pentarrejilla (Pentarrejilla.h), con
+* triángulos de ese mismo tamaño, un cartel rectangular de 2 x 1 que cabe en la rueda,
+* en serie y con los hilos. Por último compara los kernels de las reglas de sustitución
+* (Sustitucion.h) con subdividir(): la última generación en serie, en double, desde un
+* triángulo y a la profundidad a la que cada teselación tiene tantos triángulos como la
+* rueda a --error-profundidad. Y une las regiones del mismo color de esa rueda soldada
+* (Regiones.h), en serie y con los hilos, y compara el SVG de regiones con el de un
+* polígono por rombo o triángulo. Sobre la misma rueda construye la topología
+* (Topologia.h) y la recorre: cuenta las regiones con un relleno por vecinos.
+*
+* Uso: Benchmark [--max-profundidad N] [--repeticiones N] [--hilos N] [--error-profundidad N]
+*                [--json archivo]
+*/
+#include "../Penrose.h"
+#include "../Hilos.h"
+#include "../Soldadura.h"
+#include "../Circulos.h"
+#include "../Exacto.h"
+#include "../Generador.h"
+#include "../Pentarrejilla.h"
+#include "../Direcciones.h"
+#include "../Sustitucion.h"
+#include "../Rombos.h"
+#include "../Regiones.h"
+#include "../Topologia.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+// ------------------------------------------------------------------------------------
+// Conteo de asignaciones: se reemplaza el operator new global. Los dos buffers
+// alineados de ArenaTriangulos se piden con _mm_malloc y no pasan por aquí; su tamaño
+// se reporta aparte (bytes_arena).
+static atomic<size_t> numAsignaciones(0);
+static atomic<size_t> bytesAsignados(0);
+
+// Todas las variantes pasan por asignar() y liberar(), que no se expanden en línea: si
+// el compilador viera el free() de un delete junto a la llamada al operator new, lo
+// reportaría como par mal emparejado (-Wmismatched-new-delete).
+#ifdef _MSC_VER
+#define SIN_EN_LINEA __declspec(noinline)
+#else
+#define SIN_EN_LINEA __attribute__((noinline))
+#endif
+
+SIN_EN_LINEA static void* asignar(size_t n) {
+    numAsignaciones++;
+    bytesAsignados += n;
+    return malloc(n ? n : 1);
+}
+SIN_EN_LINEA static void liberar(void* p) {
+    free(p);
+}
+
+void* operator new(size_t n) {
+    void* p = asignar(n);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+void* operator new[](size_t n) {
+    void* p = asignar(n);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+void* operator new(size_t n, const nothrow_t&) noexcept {
+    return asignar(n);
+}
+void* operator new[](size_t n, const nothrow_t&) noexcept {
+    return asignar(n);
+}
+void operator delete(void* p) noexcept {
+    liberar(p);
+}
+void operator delete[](void* p) noexcept {
+    liberar(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    liberar(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+    liberar(p);
+}
+void operator delete(void* p, const nothrow_t&) noexcept {
+    liberar(p);
+}
+void operator delete[](void* p, const nothrow_t&) noexcept {
+    liberar(p);
+}
+
+// Pico de memoria residente del proceso en bytes.
+static size_t picoMemoria() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return pmc.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+#ifdef __APPLE__
+    return (size_t)uso.ru_maxrss;
+#else
+    return (size_t)uso.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+typedef chrono::steady_clock reloj;
+
+static double segundosDesde(reloj::time_point inicio) {
+    return chrono::duration<double>(reloj::now() - inicio).count();
+}
+
+static double mediana(vector<double> v) {
+    sort(v.begin(), v.end());
+    size_t m = v.size() / 2;
+    return v.size() % 2 ? v[m] : 0.5 * (v[m - 1] + v[m]);
+}
+
+// Resultado de una etapa: mediana del tiempo y asignaciones de una corrida.
+struct Etapa {
+    double ns = 0;
+    size_t asignaciones = 0;
+    size_t bytes = 0;
+};
+
+struct Medicion {
+    int profundidad;
+    size_t triangulos;
+    size_t vertices;        // Después de soldar
+    size_t rombos;          // Pares de mitades juntados
+    size_t bytesArena;
+    Etapa rueda;
+    Etapa subdividir;
+    Etapa paralelo;
+    Etapa soldadura;
+    Etapa juntarRombos;
+    Etapa exacto;
+    Etapa soldaduraExacta;
+    Etapa profundidadPrimero;
+    size_t bytesProfundidad;
+    size_t picoMemoria;
+};
+
+template <typename S>
+static void rellenarRueda(ArenaTriangulosT<S>& arena) {
+    for (int j = 1; j < 10; j++)
+        arena.agregar(trianguloDeRueda(j));
+}
+
+// Mide 'f' 'repeticiones' veces. 'preparar' se llama antes de cada repetición y no se
+// cuenta en el tiempo. Las asignaciones son las de la primera repetición.
+template <typename Preparar, typename F>
+static Etapa medir(int repeticiones, Preparar preparar, F f) {
+    Etapa e;
+    vector<double> tiempos;
+    for (int r = 0; r < repeticiones; r++) {
+        preparar();
+        size_t asig0 = numAsignaciones, bytes0 = bytesAsignados;
+        reloj::time_point inicio = reloj::now();
+        f();
+        tiempos.push_back(1e9 * segundosDesde(inicio));
+        if (r == 0) {
+            e.asignaciones = numAsignaciones - asig0;
+            e.bytes = bytesAsignados - bytes0;
+        }
+    }
+    e.ns = mediana(tiempos);
+    return e;
+}
+
+static Medicion medirProfundidad(int prof, int repeticiones, PoolHilos& hilos) {
+    Medicion m;
+    m.profundidad = prof;
+
+    // Las profundidades chicas tardan microsegundos; se repiten más para que la mediana
+    // sea estable.
+    ArenaTriangulos* arena = nullptr;
+    m.rueda = medir(max(repeticiones, 200 / prof), [&]() { delete arena; arena = nullptr; }, [&]() {
+        arena = new ArenaTriangulos(9, 0, prof);
+        rellenarRueda(*arena);
+    });
+    // Para medir sólo la última generación, cada repetición parte de la penúltima.
+    auto prepararPenultima = [&]() {
+        delete arena;
+        arena = new ArenaTriangulos(9, 0, prof);
+        rellenarRueda(*arena);
+        for (int k = 1; k < prof; k++)
+            arena->subdividir();
+    };
+    m.subdividir = medir(repeticiones, prepararPenultima, [&]() { arena->subdividir(); });
+    m.paralelo = medir(repeticiones, prepararPenultima, [&]() { arena->subdividir(&hilos); });
+    m.triangulos = arena->size();
+    m.bytesArena = arena->bytesReservados();
+
+    SoldadorVertices* soldador = nullptr;
+    vector<uint32_t> indices;
+    m.soldadura = medir(repeticiones, [&]() { delete soldador; soldador = nullptr; indices = vector<uint32_t>(); }, [&]() {
+        soldador = new SoldadorVertices(cotaVerticesSoldados(arena->size(), prof, 9));
+        indices.reserve(3 * arena->size());
+        soldador->agregarBloque(arena->actual().ceros, arena->numCeros(), CLASE_CEROS, indices);
+        soldador->agregarBloque(arena->actual().unos, arena->numUnos(), CLASE_UNOS, indices);
+    });
+    m.vertices = soldador->size();
+    delete soldador;
+    delete arena;
+
+    // Cada repetición junta una copia de los índices recién soldados.
+    vector<uint32_t> juntos;
+    m.juntarRombos = medir(repeticiones, [&]() { juntos = indices; }, [&]() { m.rombos = juntarRombos(juntos); });
+
+    ArenaExacta* exacta = nullptr;
+    m.exacto = medir(repeticiones, [&]() {
+        delete exacta;
+        exacta = new ArenaExacta(9, 0, prof);
+        for (int j = 1; j < 10; j++)
+            exacta->agregar(trianguloDeRuedaExacto(j));
+        for (int k = 1; k < prof; k++)
+            exacta->subdividir();
+    }, [&]() { exacta->subdividir(); });
+    soldador = nullptr;
+    m.soldaduraExacta = medir(repeticiones, [&]() { delete soldador; soldador = nullptr; indices = vector<uint32_t>(); }, [&]() {
+        soldador = new SoldadorVertices(cotaVerticesSoldados(exacta->size(), prof, 9));
+        indices.reserve(3 * exacta->size());
+        soldador->agregarBloque(exacta->actual().ceros, exacta->numCeros(), CLASE_CEROS, indices);
+        soldador->agregarBloque(exacta->actual().unos, exacta->numUnos(), CLASE_UNOS, indices);
+    });
+    delete soldador;
+    delete exacta;
+
+    triangulo rueda[9];
+    for (int j = 1; j < 10; j++)
+        rueda[j - 1] = trianguloDeRueda(j);
+    volatile size_t generados = 0;
+    m.profundidadPrimero = medir(repeticiones, []() {}, [&]() {
+        size_t n = 0;
+        generarEnProfundidad(rueda, 9, prof, [&](const triangulo*, size_t k) { n += k; });
+        generados = n;
+    });
+    m.bytesProfundidad = GeneradorProfundidad(rueda, 9, prof).bytes() + 4096 * sizeof(triangulo);
+    m.picoMemoria = picoMemoria();
+    return m;
+}
+
+// Un tipo de coordenada contra la referencia en double.
+struct MedicionEscalar {
+    const char* nombre;
+    size_t bytesPorTriangulo;
+    double nsPorTriangulo;
+    size_t vertices;        // Después de soldar; distinto de la referencia si hay grietas
+    double errorMaximo;     // Distancia entre vértices correspondientes
+    double errorMedio;
+};
+
+// Las dos arenas hacen los mismos pasos en el mismo orden, así que el vértice k de una
+// corresponde al vértice k de la otra.
+template <typename S>
+static void acumularError(const BloqueSoAT<S>& bloque, const BloqueSoA& ref, size_t n, int color,
+    double& maximo, double& suma) {
+    for (size_t i = 0; i < n; i++) {
+        triangulo t = bloque.obtener(i, color);
+        triangulo r = ref.obtener(i, color);
+        double d[3] = { abs(t.A - r.A), abs(t.B - r.B), abs(t.C - r.C) };
+        for (double x : d) {
+            maximo = max(maximo, x);
+            suma += x;
+        }
+    }
+}
+
+template <typename S>
+static MedicionEscalar medirEscalar(int prof, int repeticiones, const ArenaTriangulos& referencia) {
+    MedicionEscalar m;
+    m.nombre = Escalar<S>::nombre();
+    m.bytesPorTriangulo = 6 * sizeof(S);
+
+    ArenaTriangulosT<S>* arena = nullptr;
+    Etapa e = medir(repeticiones, [&]() {
+        delete arena;
+        arena = new ArenaTriangulosT<S>(9, 0, prof);
+        rellenarRueda(*arena);
+        for (int k = 1; k < prof; k++)
+            arena->subdividir();
+    }, [&]() { arena->subdividir(); });
+    m.nsPorTriangulo = e.ns / arena->size();
+
+    SoldadorVertices soldador(arena->size(), Escalar<S>::celdaSoldadura());
+    vector<uint32_t> indices;
+    soldador.agregarBloque(arena->actual().ceros, arena->numCeros(), CLASE_CEROS, indices);
+    soldador.agregarBloque(arena->actual().unos, arena->numUnos(), CLASE_UNOS, indices);
+    m.vertices = soldador.size();
+
+    double maximo = 0, suma = 0;
+    acumularError(arena->actual().ceros, referencia.actual().ceros, arena->numCeros(), 0, maximo, suma);
+    acumularError(arena->actual().unos, referencia.actual().unos, arena->numUnos(), 1, maximo, suma);
+    m.errorMaximo = maximo;
+    m.errorMedio = suma / (3.0 * arena->size());
+    delete arena;
+    return m;
+}
+
+struct MedicionReglas {
+    const char* nombre;
+    int profundidad;
+    size_t triangulos;
+    double nsPorTriangulo;
+};
+
+// Sin reglas mide subdividir().
+static MedicionReglas medirReglas(const ReglasSustitucion* reglas, uint64_t triangulosMinimos, int repeticiones) {
+    const KernelSustitucionT<double>* kernel = reglas ? kernelSustitucion<double>(*reglas) : nullptr;
+    MedicionReglas m;
+    m.nombre = reglas ? reglas->nombre : "subdividir";
+    m.profundidad = 1;
+    while (censoTriangulos(1, 0, m.profundidad, kernel ? kernel->hijos : HIJOS_ROBINSON).total() < triangulosMinimos)
+        m.profundidad++;
+
+    ArenaTriangulos* arena = nullptr;
+    Etapa e = medir(repeticiones, [&]() {
+        delete arena;
+        arena = new ArenaTriangulos(1, 0, m.profundidad, kernel);
+        arena->agregar(reglas ? semillaDeSector(*reglas) : trianguloDeRueda(0));
+        for (int k = 1; k < m.profundidad; k++)
+            arena->subdividir();
+    }, [&]() { arena->subdividir(); });
+    m.triangulos = arena->size();
+    m.nsPorTriangulo = e.ns / arena->size();
+    delete arena;
+    return m;
+}
+
+// Bytes de un archivo, que se borra después.
+static long bytesYBorrar(const char* ruta) {
+    long bytes = -1;
+    FILE* f = fopen(ruta, "rb");
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        bytes = ftell(f);
+        fclose(f);
+    }
+    remove(ruta);
+    return bytes;
+}
+
+static void escribirEtapa(FILE* f, const char* nombre, const Etapa& e, size_t triangulos, bool coma) {
+    fprintf(f, "      \"%s\": { \"ns\": %.0f, \"ns_por_triangulo\": %.3f, \"asignaciones\": %zu, \"bytes_asignados\": %zu }%s\n",
+        nombre, e.ns, e.ns / (double)triangulos, e.asignaciones, e.bytes, coma ? "," : "");
+}
+
+int main(int argc, char* argv[]) {
+    int maxProfundidad = 14;
+    int repeticiones = 5;
+    unsigned numHilos = 0;
+    int profError = 10;
+    const char* rutaJson = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-profundidad") == 0 && i + 1 < argc)
+            maxProfundidad = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--repeticiones") == 0 && i + 1 < argc)
+            repeticiones = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--hilos") == 0 && i + 1 < argc)
+            numHilos = (unsigned)max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--error-profundidad") == 0 && i + 1 < argc)
+            profError = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            rutaJson = argv[++i];
+        else {
+            fprintf(stderr, "Opción desconocida: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    PoolHilos hilos(numHilos);
+    printf("Kernel: %s, hilos: %u, repeticiones: %d\n\n", kernelSubdivision(), hilos.tamano(), repeticiones);
+
+    // crearCirc() no depende de la profundidad: se mide una vez, con muchas repeticiones
+    // porque cada llamada tarda menos de un microsegundo.
+    const int VECES_CIRCULOS = 10000;
+    volatile float sumidero = 0;
+    Etapa circulos = medir(repeticiones, []() {}, [&]() {
+        for (int k = 0; k < VECES_CIRCULOS; k++) {
+            Circ c = crearCirc(k & 1, 0.3f, 0.1f, 0.05f);
+            sumidero = sumidero + c.listaVert[TRI_POR_CIRC * 9 - 1];
+        }
+    });
+    circulos.ns /= VECES_CIRCULOS;
+    printf("crearCirc: %.1f ns por círculo (%u triángulos)\n\n", circulos.ns, TRI_POR_CIRC);
+
+    printf("%4s %10s %10s | %9s %9s %9s %9s %9s %9s %9s %9s | %8s %8s | %9s\n", "prof", "triangulos", "vertices",
+        "rueda us", "subd ns/t", "par ns/t", "sold ns/t", "romb ns/t", "exac ns/t", "sexa ns/t", "dfs ns/t", "asig sub", "asig sol", "pico MB");
+    vector<Medicion> mediciones;
+    for (int prof = 1; prof <= maxProfundidad; prof++) {
+        Medicion m = medirProfundidad(prof, repeticiones, hilos);
+        mediciones.push_back(m);
+        printf("%4d %10zu %10zu | %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f | %8zu %8zu | %9.1f\n", m.profundidad, m.triangulos, m.vertices,
+            m.rueda.ns / 1000.0, m.subdividir.ns / m.triangulos, m.paralelo.ns / m.triangulos, m.soldadura.ns / m.triangulos,
+            m.juntarRombos.ns / m.triangulos,
+            m.exacto.ns / m.triangulos, m.soldaduraExacta.ns / m.triangulos, m.profundidadPrimero.ns / m.triangulos, m.subdividir.asignaciones, m.soldadura.asignaciones, m.picoMemoria / (1024.0 * 1024.0));
+        fflush(stdout);
+    }
+
+    ArenaTriangulos referencia(9, 0, profError);
+    rellenarRueda(referencia);
+    for (int k = 0; k < profError; k++)
+        referencia.subdividir();
+    MedicionEscalar escalares[3] = {
+        medirEscalar<double>(profError, repeticiones, referencia),
+        medirEscalar<float>(profError, repeticiones, referencia),
+        medirEscalar<Fijo32>(profError, repeticiones, referencia),
+    };
+    printf("\nTipos de coordenada a profundidad %d (%zu triángulos):\n", profError, referencia.size());
+    printf("%8s %9s %9s %10s %12s %12s\n", "tipo", "bytes/t", "subd ns/t", "vertices", "error max", "error medio");
+    for (const MedicionEscalar& e : escalares)
+        printf("%8s %9zu %9.2f %10zu %12.3e %12.3e\n", e.nombre, e.bytesPorTriangulo, e.nsPorTriangulo, e.vertices,
+            e.errorMaximo, e.errorMedio);
+
+    // Direcciones: la decodificación va en lotes como la usaría un exportador.
+    const size_t TAM_LOTE = 4096;
+    TeselacionCodificada codificada;
+    Etapa codificar = medir(repeticiones, []() {}, [&]() { codificada = TeselacionCodificada::rueda(profError); });
+    vector<triangulo> lote(TAM_LOTE);
+    Etapa decodificar = medir(repeticiones, []() {}, [&]() {
+        for (size_t i = 0; i < codificada.size(); i += TAM_LOTE)
+            codificada.decodificar(i, min(TAM_LOTE, codificada.size() - i), lote.data());
+    });
+    // Ida y vuelta por el archivo: lo cargado debe decodificar a los mismos triángulos.
+    TeselacionCodificada cargada;
+    bool guardada = true, leida = true;
+    Etapa guardarDirecciones = medir(repeticiones, []() {}, [&]() { guardada = codificada.guardar("direcciones.bin"); });
+    Etapa cargarDirecciones = medir(repeticiones, []() {}, [&]() { leida = cargada.cargar("direcciones.bin"); });
+    long bytesDirecciones = bytesYBorrar("direcciones.bin");
+    bool idaYVuelta = guardada && leida && cargada.size() == codificada.size() &&
+        cargada.profundidad() == codificada.profundidad();
+    vector<triangulo> loteCargado(TAM_LOTE);
+    for (size_t i = 0; idaYVuelta && i < codificada.size(); i += TAM_LOTE) {
+        size_t n = min(TAM_LOTE, codificada.size() - i);
+        codificada.decodificar(i, n, lote.data());
+        cargada.decodificar(i, n, loteCargado.data());
+        for (size_t k = 0; k < n; k++) {
+            const triangulo &a = lote[k], &b = loteCargado[k];
+            if (a.color != b.color || a.A != b.A || a.B != b.B || a.C != b.C)
+                idaYVuelta = false;
+        }
+    }
+    printf("\nDirecciones a profundidad %d (%zu triángulos): %zu bytes/t, codificar %.2f ns/t, decodificar %.2f ns/t\n",
+        profError, codificada.size(), codificada.bytesPorTriangulo(), codificar.ns / codificada.size(),
+        decodificar.ns / codificada.size());
+    printf("Archivo: %ld bytes, guardar %.2f ms, cargar %.2f ms, %s\n", bytesDirecciones, guardarDirecciones.ns / 1e6,
+        cargarDirecciones.ns / 1e6, idaYVuelta ? "decodifica igual" : "NO DECODIFICA IGUAL");
+
+    // Pentarrejilla: sólo el rectángulo, contra la rueda completa en profundidad.
+    const RegionPlano cartel = { -1, -0.5, 1, 0.5 };
+    const double lado = pow(goldenRatio, -profError);
+    vector<triangulo> rombos;
+    Etapa pentaSerie = medir(repeticiones, []() {}, [&]() { generarPentarrejilla(cartel, lado, rombos); });
+    Etapa pentaParalelo = medir(repeticiones, []() {}, [&]() { generarPentarrejilla(cartel, lado, rombos, &hilos); });
+    triangulo rueda[NUM_SECTORES];
+    for (int j = 0; j < NUM_SECTORES; j++)
+        rueda[j] = trianguloDeRueda(j);
+    volatile size_t generados = 0;
+    Etapa ruedaCompleta = medir(repeticiones, []() {}, [&]() {
+        size_t n = 0;
+        generarEnProfundidad(rueda, NUM_SECTORES, profError, [&](const triangulo*, size_t k) { n += k; });
+        generados = n;
+    });
+    printf("Pentarrejilla a profundidad %d, cartel de 2 x 1 (%zu triángulos): %.2f ms en serie, %.2f ms con hilos; "
+        "la rueda completa en profundidad (%zu triángulos): %.2f ms\n", profError, rombos.size(), pentaSerie.ns / 1e6,
+        pentaParalelo.ns / 1e6, (size_t)generados, ruedaCompleta.ns / 1e6);
+
+    const char* nombresReglas[] = { nullptr, "p3", "p2", "molinete" };
+    vector<MedicionReglas> reglas;
+    for (const char* nombre : nombresReglas)
+        reglas.push_back(medirReglas(nombre ? buscarReglas(nombre) : nullptr, referencia.size(), repeticiones));
+    printf("\nReglas de sustitución, última generación en serie:\n");
+    printf("%12s %6s %10s %9s\n", "reglas", "prof", "triangulos", "subd ns/t");
+    for (const MedicionReglas& r : reglas)
+        printf("%12s %6d %10zu %9.2f\n", r.nombre, r.profundidad, r.triangulos, r.nsPorTriangulo);
+
+    // Regiones: sobre la rueda de referencia soldada.
+    SoldadorVertices soldador(cotaVerticesSoldados(referencia.size(), profError, 9));
+    vector<uint32_t> indices;
+    soldador.agregarBloque(referencia.actual().ceros, referencia.numCeros(), CLASE_CEROS, indices);
+    soldador.agregarBloque(referencia.actual().unos, referencia.numUnos(), CLASE_UNOS, indices);
+    const VerticeEmpacado* vertices = soldador.vertices().data();
+    RegionesTeselacion regiones;
+    PoolHilos unHilo(1);
+    Etapa regionesSerie = medir(repeticiones, []() {}, [&]() { unirRegiones(vertices, indices.data(), indices.size(), unHilo, regiones); });
+    Etapa regionesParalelo = medir(repeticiones, []() {}, [&]() { unirRegiones(vertices, indices.data(), indices.size(), hilos, regiones); });
+    const float colores[2][3] = { { 0, 0, 0 }, { 1, 1, 1 } };
+    Etapa svgRegiones = medir(repeticiones, []() {}, [&]() { exportarSvg("regiones.svg", vertices, regiones, colores); });
+    long bytesSvgRegiones = bytesYBorrar("regiones.svg");
+    vector<uint32_t> juntos = indices;
+    size_t numRombos = juntarRombos(juntos);
+    size_t poligonos = numRombos + (juntos.size() - 6 * numRombos) / 3;
+    Etapa svgTriangulos = medir(repeticiones, []() {}, [&]() {
+        exportarSvgTriangulos("triangulos.svg", vertices, juntos.data(), juntos.size(), numRombos, colores);
+    });
+    long bytesSvgTriangulos = bytesYBorrar("triangulos.svg");
+    printf("\nRegiones a profundidad %d (%zu triángulos): %zu regiones, %zu puntos; unir %.2f ms en serie, %.2f ms con hilos\n",
+        profError, referencia.size(), regiones.regiones.size(), regiones.puntos.size(), regionesSerie.ns / 1e6,
+        regionesParalelo.ns / 1e6);
+    printf("SVG por región: %ld bytes en %.2f ms; por rombo o triángulo (%zu polígonos): %ld bytes en %.2f ms\n",
+        bytesSvgRegiones, svgRegiones.ns / 1e6, poligonos, bytesSvgTriangulos, svgTriangulos.ns / 1e6);
+
+    // Topología: el relleno por vecinos del mismo color debe dar las mismas regiones.
+    TopologiaTeselacion* topologia = nullptr;
+    Etapa topologiaSerie = medir(repeticiones, [&]() {
+        delete topologia;
+        topologia = nullptr;
+    }, [&]() {
+        topologia = new TopologiaTeselacion(vertices, soldador.vertices().size(), indices.data(), indices.size(), unHilo);
+    });
+    Etapa topologiaParalelo = medir(repeticiones, [&]() {
+        delete topologia;
+        topologia = nullptr;
+    }, [&]() {
+        topologia = new TopologiaTeselacion(vertices, soldador.vertices().size(), indices.data(), indices.size(), hilos);
+    });
+    const size_t numTriangulos = topologia->numTriangulos();
+    vector<uint32_t> region(numTriangulos);
+    size_t regionesRelleno = 0;
+    Etapa relleno = medir(repeticiones, [&]() { region.assign(numTriangulos, TopologiaTeselacion::SIN_VECINO); }, [&]() {
+        vector<uint32_t> pila;
+        regionesRelleno = 0;
+        for (uint32_t t = 0; t < numTriangulos; t++) {
+            if (region[t] != TopologiaTeselacion::SIN_VECINO)
+                continue;
+            const uint8_t clase = vertices[indices[3 * t]].clase;
+            region[t] = (uint32_t)regionesRelleno;
+            pila.push_back(t);
+            while (!pila.empty()) {
+                uint32_t u = pila.back();
+                pila.pop_back();
+                for (int k = 0; k < 3; k++) {
+                    uint32_t w = topologia->vecino(u, k);
+                    if (w != TopologiaTeselacion::SIN_VECINO && region[w] == TopologiaTeselacion::SIN_VECINO &&
+                        vertices[indices[3 * w]].clase == clase) {
+                        region[w] = (uint32_t)regionesRelleno;
+                        pila.push_back(w);
+                    }
+                }
+            }
+            regionesRelleno++;
+        }
+    });
+    printf("Topología: construir %.2f ms en serie, %.2f ms con hilos (%zu bytes, %zu contornos); relleno por vecinos "
+        "%.2f ns/t, %zu regiones\n", topologiaSerie.ns / 1e6, topologiaParalelo.ns / 1e6, topologia->bytes(),
+        topologia->numContornos(), relleno.ns / numTriangulos, regionesRelleno);
+
+    if (rutaJson) {
+        FILE* f = fopen(rutaJson, "w");
+        if (!f) {
+            fprintf(stderr, "No se pudo abrir %s\n", rutaJson);
+            return 1;
+        }
+        fprintf(f, "{\n  \"kernel\": \"%s\",\n  \"hilos\": %u,\n  \"repeticiones\": %d,\n", kernelSubdivision(), hilos.tamano(), repeticiones);
+        fprintf(f, "  \"crearCirc\": { \"ns\": %.1f, \"asignaciones\": %zu },\n", circulos.ns, circulos.asignaciones);
+        fprintf(f, "  \"profundidades\": [\n");
+        for (size_t i = 0; i < mediciones.size(); i++) {
+            const Medicion& m = mediciones[i];
+            fprintf(f, "    {\n      \"profundidad\": %d, \"triangulos\": %zu, \"vertices\": %zu, \"rombos\": %zu, \"bytes_arena\": %zu, \"bytes_profundidad\": %zu, \"pico_memoria\": %zu,\n",
+                m.profundidad, m.triangulos, m.vertices, m.rombos, m.bytesArena, m.bytesProfundidad, m.picoMemoria);
+            escribirEtapa(f, "rueda", m.rueda, m.triangulos, true);
+            escribirEtapa(f, "subdividir", m.subdividir, m.triangulos, true);
+            escribirEtapa(f, "paralelo", m.paralelo, m.triangulos, true);
+            escribirEtapa(f, "soldadura", m.soldadura, m.triangulos, true);
+            escribirEtapa(f, "juntar_rombos", m.juntarRombos, m.triangulos, true);
+            escribirEtapa(f, "exacto", m.exacto, m.triangulos, true);
+            escribirEtapa(f, "soldadura_exacta", m.soldaduraExacta, m.triangulos, true);
+            escribirEtapa(f, "profundidad", m.profundidadPrimero, m.triangulos, false);
+            fprintf(f, "    }%s\n", i + 1 < mediciones.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n  \"escalares\": {\n    \"profundidad\": %d,\n    \"tipos\": [\n", profError);
+        for (int i = 0; i < 3; i++) {
+            const MedicionEscalar& e = escalares[i];
+            fprintf(f, "      { \"tipo\": \"%s\", \"bytes_por_triangulo\": %zu, \"ns_por_triangulo\": %.3f, \"vertices\": %zu, "
+                "\"error_maximo\": %.3e, \"error_medio\": %.3e }%s\n", e.nombre, e.bytesPorTriangulo, e.nsPorTriangulo,
+                e.vertices, e.errorMaximo, e.errorMedio, i < 2 ? "," : "");
+        }
+        fprintf(f, "    ]\n  },\n");
+        fprintf(f, "  \"direcciones\": { \"profundidad\": %d, \"triangulos\": %zu, \"bytes_por_triangulo\": %zu, "
+            "\"codificar_ns_por_triangulo\": %.3f, \"decodificar_ns_por_triangulo\": %.3f, \"bytes_archivo\": %ld, "
+            "\"guardar_ns\": %.0f, \"cargar_ns\": %.0f, \"ida_y_vuelta\": %s },\n", profError, codificada.size(),
+            codificada.bytesPorTriangulo(), codificar.ns / codificada.size(), decodificar.ns / codificada.size(),
+            bytesDirecciones, guardarDirecciones.ns, cargarDirecciones.ns, idaYVuelta ? "true" : "false");
+        fprintf(f, "  \"pentarrejilla\": { \"profundidad\": %d, \"triangulos\": %zu, \"serie_ns\": %.0f, \"paralelo_ns\": %.0f, "
+            "\"rueda_ns\": %.0f },\n", profError, rombos.size(), pentaSerie.ns, pentaParalelo.ns, ruedaCompleta.ns);
+        fprintf(f, "  \"reglas\": [\n");
+        for (size_t i = 0; i < reglas.size(); i++) {
+            const MedicionReglas& r = reglas[i];
+            fprintf(f, "    { \"reglas\": \"%s\", \"profundidad\": %d, \"triangulos\": %zu, \"ns_por_triangulo\": %.3f }%s\n",
+                r.nombre, r.profundidad, r.triangulos, r.nsPorTriangulo, i + 1 < reglas.size() ? "," : "");
+        }
+        fprintf(f, "  ],\n");
+        fprintf(f, "  \"regiones\": { \"profundidad\": %d, \"triangulos\": %zu, \"regiones\": %zu, \"puntos\": %zu, "
+            "\"serie_ns\": %.0f, \"paralelo_ns\": %.0f, \"svg_regiones_bytes\": %ld, \"svg_regiones_ns\": %.0f, "
+            "\"svg_poligonos\": %zu, \"svg_poligonos_bytes\": %ld, \"svg_poligonos_ns\": %.0f },\n", profError,
+            referencia.size(), regiones.regiones.size(), regiones.puntos.size(), regionesSerie.ns, regionesParalelo.ns,
+            bytesSvgRegiones, svgRegiones.ns, poligonos, bytesSvgTriangulos, svgTriangulos.ns);
+        fprintf(f, "  \"topologia\": { \"serie_ns\": %.0f, \"paralelo_ns\": %.0f, \"bytes\": %zu, \"contornos\": %zu, "
+            "\"relleno_ns_por_triangulo\": %.3f, \"regiones_relleno\": %zu }\n}\n", topologiaSerie.ns, topologiaParalelo.ns,
+            topologia->bytes(), topologia->numContornos(), relleno.ns / numTriangulos, regionesRelleno);
+        fclose(f);
+        printf("\nResultados en %s\n", rutaJson);
+    }
+    delete topologia;
+    // Un archivo de direcciones que no decodifica igual es un error, no una medición.
+    return idaYVuelta ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/*
+* Caché en disco de la teselación.
+*/
+#include "Cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char MAGIA_CACHE[8] = { 'P', 'E', 'N', 'R', 'O', 'S', 'E', 0 };
+
+static uint64_t alinear(uint64_t n) {
+    return (n + ALINEACION_CACHE - 1) / ALINEACION_CACHE * ALINEACION_CACHE;
+}
+
+uint64_t tamanoCache(size_t numVertices, size_t numIndices) {
+    return alinear(alinear(sizeof(CabeceraCache)) + numVertices * sizeof(VerticeEmpacado)) + numIndices * sizeof(uint32_t);
+}
+
+string rutaDeCache(const char* directorio, const LlaveCache& llave) {
+    static const char* nombres[] = { "double", "float", "fijo", "exacta" };
+    char nombre[96];
+    snprintf(nombre, sizeof(nombre), "teselacion_s%u_p%u_%s_prot%u.cache", llave.semilla, llave.profundidad,
+        llave.precision < 4 ? nombres[llave.precision] : "desconocida", llave.protagonista);
+    string ruta = directorio;
+    if (!ruta.empty() && ruta.back() != '/' && ruta.back() != '\\')
+        ruta += '/';
+    return ruta + nombre;
+}
+
+// Rellena con ceros desde 'posicion' hasta 'desp'.
+static bool escribirHasta(FILE* f, uint64_t& posicion, uint64_t desp) {
+    static const char ceros[256] = {};
+    while (posicion < desp) {
+        size_t n = (size_t)min<uint64_t>(sizeof(ceros), desp - posicion);
+        if (fwrite(ceros, 1, n, f) != n)
+            return false;
+        posicion += n;
+    }
+    return true;
+}
+
+bool guardarCache(const char* ruta, const LlaveCache& llave, const VerticeEmpacado* vertices, size_t numVertices,
+    const uint32_t* indices, size_t numIndices, size_t numRombos) {
+    CabeceraCache c;
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magia, MAGIA_CACHE, sizeof(c.magia));
+    c.version = VERSION_CACHE;
+    c.bytesVertice = sizeof(VerticeEmpacado);
+    c.llave = llave;
+    c.numVertices = numVertices;
+    c.numIndices = numIndices;
+    c.numRombos = numRombos;
+    c.despVertices = alinear(sizeof(CabeceraCache));
+    c.despIndices = alinear(c.despVertices + numVertices * sizeof(VerticeEmpacado));
+
+    string temporal = string(ruta) + ".tmp";
+    FILE* f = fopen(temporal.c_str(), "wb");
+    if (!f)
+        return false;
+    uint64_t posicion = sizeof(c);
+    bool ok = fwrite(&c, sizeof(c), 1, f) == 1;
+    ok = ok && escribirHasta(f, posicion, c.despVertices);
+    ok = ok && fwrite(vertices, sizeof(VerticeEmpacado), numVertices, f) == numVertices;
+    posicion += numVertices * sizeof(VerticeEmpacado);
+    ok = ok && escribirHasta(f, posicion, c.despIndices);
+    ok = ok && fwrite(indices, sizeof(uint32_t), numIndices, f) == numIndices;
+    ok = fclose(f) == 0 && ok;
+    // rename() no reemplaza un archivo existente en Windows.
+    if (ok) {
+        remove(ruta);
+        ok = rename(temporal.c_str(), ruta) == 0;
+    }
+    if (!ok)
+        remove(temporal.c_str());
+    return ok;
+}
+
+CacheTeselacion::~CacheTeselacion() {
+    cerrar();
+}
+
+void CacheTeselacion::cerrar() {
+#ifdef _WIN32
+    if (base)
+        UnmapViewOfFile(base);
+    if (mapeo)
+        CloseHandle((HANDLE)mapeo);
+    if (archivo)
+        CloseHandle((HANDLE)archivo);
+    archivo = mapeo = nullptr;
+#else
+    if (base)
+        munmap(base, tamano);
+#endif
+    base = nullptr;
+    tamano = 0;
+    verts = nullptr;
+    inds = nullptr;
+    numVerts = numInds = rombos = 0;
+}
+
+bool CacheTeselacion::abrir(const char* ruta, const LlaveCache& llave) {
+    cerrar();
+#ifdef _WIN32
+    HANDLE h = CreateFileA(ruta, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+    archivo = h;
+    LARGE_INTEGER t;
+    if (!GetFileSizeEx(h, &t) || (uint64_t)t.QuadPart < sizeof(CabeceraCache)) {
+        cerrar();
+        return false;
+    }
+    tamano = (size_t)t.QuadPart;
+    mapeo = CreateFileMappingA(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    base = mapeo ? MapViewOfFile((HANDLE)mapeo, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!base) {
+        cerrar();
+        return false;
+    }
+#else
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(CabeceraCache)) {
+        close(fd);
+        return false;
+    }
+    tamano = (size_t)st.st_size;
+    void* p = mmap(nullptr, tamano, PROT_READ, MAP_PRIVATE, fd, 0);
+    // El mapeo sigue vivo después de cerrar el descriptor.
+    close(fd);
+    if (p == MAP_FAILED) {
+        tamano = 0;
+        return false;
+    }
+    base = p;
+#endif
+
+    // Los tamaños se comparan dividiendo, así que una cabecera dañada no puede desbordar
+    // las cuentas y pasar la revisión.
+    const CabeceraCache& c = *(const CabeceraCache*)base;
+    bool valida = memcmp(c.magia, MAGIA_CACHE, sizeof(c.magia)) == 0 && c.version == VERSION_CACHE &&
+        c.bytesVertice == sizeof(VerticeEmpacado) && c.llave == llave &&
+        c.despVertices % ALINEACION_CACHE == 0 && c.despIndices % ALINEACION_CACHE == 0 &&
+        sizeof(CabeceraCache) <= c.despVertices && c.despVertices <= c.despIndices && c.despIndices <= tamano &&
+        c.numVertices <= (c.despIndices - c.despVertices) / sizeof(VerticeEmpacado) &&
+        c.numIndices <= (tamano - c.despIndices) / sizeof(uint32_t) && c.numIndices % 3 == 0 &&
+        c.numRombos <= c.numIndices / 6;
+    const char* bytes = (const char*)base;
+    if (valida) {
+        // Un índice fuera de rango haría leer fuera del arreglo de vértices al dibujar o al
+        // rasterizar; recorrerlos una vez cuesta mucho menos que regenerar la teselación.
+        const uint32_t* ind = (const uint32_t*)(bytes + c.despIndices);
+        uint32_t mayor = 0;
+        for (uint64_t i = 0; i < c.numIndices; i++)
+            mayor = max(mayor, ind[i]);
+        valida = c.numIndices == 0 || mayor < c.numVertices;
+    }
+    if (!valida) {
+        cerrar();
+        return false;
+    }
+    verts = (const VerticeEmpacado*)(bytes + c.despVertices);
+    numVerts = (size_t)c.numVertices;
+    inds = (const uint32_t*)(bytes + c.despIndices);
+    numInds = (size_t)c.numIndices;
+    rombos = (size_t)c.numRombos;
+    return true;
+}
@@ -0,0 +1,108 @@
+/*
+* Caché en disco de la teselación ya soldada y empacada, para no volver a subdividir en
+* cada arranque.
+*/
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Vertice.h"
+
+// Precisión con la que se generó la teselación (--escalar y --exacto de Main.cpp). Cada
+// una da vértices empacados un poco distintos, así que tiene su propia entrada.
+enum PrecisionCache {
+    PRECISION_DOUBLE = 0,
+    PRECISION_FLOAT,
+    PRECISION_FIJO,
+    PRECISION_EXACTA
+};
+
+// Lo que determina el contenido del archivo.
+struct LlaveCache {
+    uint32_t semilla;       // Triángulo de trianguloDeRueda() que se subdividió
+    uint32_t profundidad;
+    uint32_t precision;     // PrecisionCache
+    uint32_t protagonista;  // Sector que hace de protagonista
+
+    bool operator==(const LlaveCache& o) const {
+        return semilla == o.semilla && profundidad == o.profundidad && precision == o.precision &&
+            protagonista == o.protagonista;
+    }
+};
+
+// Formato del archivo, en el orden de bytes de la máquina:
+//   cabecera (CabeceraCache)
+//   vértices empacados, desde despVertices
+//   índices uint32_t, desde despIndices; los primeros 6 * numRombos son los pares de
+//   mitades de rombo de juntarRombos() (Rombos.h)
+// Los dos arreglos empiezan en múltiplo de ALINEACION_CACHE, así que al mapear el archivo
+// completo quedan alineados a página y se pueden pasar tal cual a glBufferData o al
+// rasterizador, sin copiarlos ni interpretarlos. Cualquier cambio al formato (o a
+// VerticeEmpacado) sube VERSION_CACHE y los archivos viejos se regeneran.
+const uint32_t VERSION_CACHE = 2;
+const uint64_t ALINEACION_CACHE = 4096;
+
+struct CabeceraCache {
+    char magia[8];              // "PENROSE" y un cero
+    uint32_t version;
+    uint32_t bytesVertice;      // sizeof(VerticeEmpacado)
+    LlaveCache llave;
+    uint64_t numVertices;
+    uint64_t numIndices;
+    uint64_t numRombos;
+    uint64_t despVertices;
+    uint64_t despIndices;
+};
+
+// Tamaño del archivo con esos arreglos, en bytes.
+uint64_t tamanoCache(size_t numVertices, size_t numIndices);
+
+// Nombre del archivo de la llave dentro de 'directorio'.
+std::string rutaDeCache(const char* directorio, const LlaveCache& llave);
+
+// Escribe el archivo completo en una ruta temporal y lo renombra al final, así que otro
+// proceso nunca ve un archivo a medias. Regresa false si no se pudo escribir.
+bool guardarCache(const char* ruta, const LlaveCache& llave, const VerticeEmpacado* vertices, size_t numVertices,
+    const uint32_t* indices, size_t numIndices, size_t numRombos);
+
+// Vista de sólo lectura de un archivo de caché mapeado en memoria. Los arreglos viven
+// mientras viva el objeto.
+class CacheTeselacion {
+public:
+    CacheTeselacion() {}
+    ~CacheTeselacion();
+
+    CacheTeselacion(const CacheTeselacion&) = delete;
+    CacheTeselacion& operator=(const CacheTeselacion&) = delete;
+
+    // Mapea el archivo y revisa la cabecera. Regresa false (y no deja nada abierto) si no
+    // existe, es de otra versión o de otra llave, está truncado o tiene un índice que no
+    // cae en el arreglo de vértices.
+    bool abrir(const char* ruta, const LlaveCache& llave);
+
+    const VerticeEmpacado* vertices() const { return verts; }
+    size_t numVertices() const { return numVerts; }
+    const uint32_t* indices() const { return inds; }
+    size_t numIndices() const { return numInds; }
+    size_t numRombos() const { return rombos; }
+
+private:
+    void cerrar();
+
+    void* base = nullptr;
+    size_t tamano = 0;
+#ifdef _WIN32
+    void* archivo = nullptr;
+    void* mapeo = nullptr;
+#endif
+    const VerticeEmpacado* verts = nullptr;
+    size_t numVerts = 0;
+    const uint32_t* inds = nullptr;
+    size_t numInds = 0;
+    size_t rombos = 0;
+};
+
+#endif
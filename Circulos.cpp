@@ -0,0 +1,33 @@
+/*
+* Círculos hechos de triángulos.
+*/
+#include "Circulos.h"
+#include "Penrose.h"
+
+#include <cmath>
+
+using namespace std;
+
+Circ crearCirc(int color, float x, float y, float radio) {
+    Circ nuevoCirc;
+    nuevoCirc.color = color;
+    float theta = 2 * pi / TRI_POR_CIRC;
+
+    for (int i = 0; i < 9 * TRI_POR_CIRC; i += 9) {
+        //Primer vért.
+        nuevoCirc.listaVert[i] = x;
+        nuevoCirc.listaVert[i + 1] = y;
+        nuevoCirc.listaVert[i + 2] = 0.0f;
+
+        //Segundo vért.
+        nuevoCirc.listaVert[i + 3] = x - radio * sin(-i * theta);
+        nuevoCirc.listaVert[i + 4] = y - radio * cos(-i * theta);
+        nuevoCirc.listaVert[i + 5] = 0.0f;
+
+        //Tercer vért.
+        nuevoCirc.listaVert[i + 6] = x - radio * sin(-(i + 1) * theta);
+        nuevoCirc.listaVert[i + 7] = y - radio * cos(-(i + 1) * theta);
+        nuevoCirc.listaVert[i + 8] = 0.0f;
+    }
+    return nuevoCirc;
+}
@@ -0,0 +1,21 @@
+/*
+* Círculos hechos de triángulos (los ojos del protagonista).
+*/
+#ifndef CIRCULOS_H
+#define CIRCULOS_H
+
+// --------------------------------- Creación de círculos
+//Número de triángulos usados para aproximar un círculo
+unsigned const int TRI_POR_CIRC = 10;
+
+//Círculos
+typedef struct Circ {
+    int color; // 0 o 1 (blanco o negro)    
+    float listaVert[TRI_POR_CIRC * 9];
+} circ;
+
+// Círculo de radio 'radio' centrado en (x, y), como TRI_POR_CIRC triángulos con un
+// vértice en el centro.
+Circ crearCirc(int color, float x, float y, float radio);
+
+#endif
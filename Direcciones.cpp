@@ -0,0 +1,274 @@
+/*
+* Codificación de la teselación por direcciones.
+*/
+#include "Direcciones.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+// ------------------------------------------------------------------------------------
+// Tablas del decodificador. Un paso lleva los vértices (A, B, C) del padre a los del
+// hijo elegido: hijo[i] = sum_j m[i][j] * padre[j]. Se guarda también el color del hijo.
+struct Paso {
+    double m[3][3];
+    uint8_t valido;
+    uint8_t color;
+};
+
+// Niveles por bloque y elecciones posibles por bloque (2 bits por nivel).
+static const int NIVELES_BLOQUE = 4;
+static const int CODIGOS_BLOQUE = 1 << (2 * NIVELES_BLOQUE);
+
+struct TablasDireccion {
+    Paso uno[2][4];                     // [color del padre][elección]
+    Paso bloque[2][CODIGOS_BLOQUE];     // Cuatro pasos compuestos; la primera elección en los bits altos
+};
+
+static Paso componer(const Paso& primero, const Paso& despues) {
+    Paso r;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            r.m[i][j] = despues.m[i][0] * primero.m[0][j] + despues.m[i][1] * primero.m[1][j] + despues.m[i][2] * primero.m[2][j];
+    r.valido = primero.valido && despues.valido;
+    r.color = despues.color;
+    return r;
+}
+
+static TablasDireccion crearTablas() {
+    TablasDireccion t;
+    memset(&t, 0, sizeof(t));
+    // P = A + (B - A) / phi, Q = B + (A - B) / phi, R = B + (C - B) / phi, como en
+    // subdividir().
+    const double ip = 1.0 / goldenRatio, iq = 1.0 - ip;
+    const Paso pasos[2][3] = {
+        {
+            { { { 0, 0, 1 }, { iq, ip, 0 }, { 0, 1, 0 } }, 1, 0 },      // (C, P, B)
+            { { { iq, ip, 0 }, { 0, 0, 1 }, { 1, 0, 0 } }, 1, 1 },      // (P, C, A)
+            { {}, 0, 0 },
+        },
+        {
+            { { { 0, iq, ip }, { ip, iq, 0 }, { 1, 0, 0 } }, 1, 0 },    // (R, Q, A)
+            { { { 0, iq, ip }, { 0, 0, 1 }, { 1, 0, 0 } }, 1, 1 },      // (R, C, A)
+            { { { ip, iq, 0 }, { 0, iq, ip }, { 0, 1, 0 } }, 1, 1 },    // (Q, R, B)
+        },
+    };
+    for (int c = 0; c < 2; c++)
+        for (int e = 0; e < 3; e++)
+            t.uno[c][e] = pasos[c][e];
+
+    for (int c = 0; c < 2; c++) {
+        for (int codigo = 0; codigo < CODIGOS_BLOQUE; codigo++) {
+            Paso p = { { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } }, 1, (uint8_t)c };
+            for (int k = NIVELES_BLOQUE - 1; k >= 0 && p.valido; k--)
+                p = componer(p, t.uno[p.color][(codigo >> (2 * k)) & 3]);
+            t.bloque[c][codigo] = p;
+        }
+    }
+    return t;
+}
+
+static const TablasDireccion& tablas() {
+    static const TablasDireccion t = crearTablas();
+    return t;
+}
+
+static inline void aplicar(const Paso& p, const complex<double> v[3], complex<double> r[3]) {
+    for (int i = 0; i < 3; i++)
+        r[i] = complex<double>(p.m[i][0] * v[0].real() + p.m[i][1] * v[1].real() + p.m[i][2] * v[2].real(),
+            p.m[i][0] * v[0].imag() + p.m[i][1] * v[1].imag() + p.m[i][2] * v[2].imag());
+}
+
+bool direccionValida(uint64_t direccion, int profundidad) {
+    if (profundidad < 0 || profundidad > PROFUNDIDAD_MAXIMA_DIRECCION)
+        return false;
+    uint64_t raiz = direccion >> (2 * profundidad);
+    if (raiz >= (uint64_t)NUM_SECTORES)
+        return false;
+    // Todas las semillas de la rueda son tipo cero.
+    int color = 0;
+    for (int k = profundidad - 1; k >= 0; k--) {
+        const Paso& p = tablas().uno[color][(direccion >> (2 * k)) & 3];
+        if (!p.valido)
+            return false;
+        color = p.color;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------------------
+static void ponerLE(uint8_t* p, uint64_t x, int bytes) {
+    for (int b = 0; b < bytes; b++)
+        p[b] = (uint8_t)(x >> (8 * b));
+}
+
+static uint64_t leerLE(const uint8_t* p, int bytes) {
+    uint64_t x = 0;
+    for (int b = 0; b < bytes; b++)
+        x |= (uint64_t)p[b] << (8 * b);
+    return x;
+}
+
+TeselacionCodificada::TeselacionCodificada(int profundidad)
+    : prof(profundidad), bytesDir((bitsDeDireccion(profundidad) + 7) / 8) {
+    assert(profundidad >= 0 && profundidad <= PROFUNDIDAD_MAXIMA_DIRECCION);
+}
+
+TeselacionCodificada TeselacionCodificada::rueda(int profundidad, int primeraSemilla, int numSemillas) {
+    TeselacionCodificada t(profundidad);
+    t.datos.reserve((size_t)censoTriangulos(1, 0, profundidad).total() * numSemillas * t.bytesDir);
+
+    // Mismo recorrido que GeneradorProfundidad, pero sólo con colores y direcciones.
+    struct Nodo {
+        uint64_t direccion;
+        int color;
+        int nivel;
+    };
+    vector<Nodo> pila;
+    pila.reserve(2 * (size_t)profundidad + 1);
+    for (int j = primeraSemilla; j < primeraSemilla + numSemillas; j++) {
+        Nodo raiz = { (uint64_t)j << (2 * profundidad), 0, 0 };
+        pila.push_back(raiz);
+        while (!pila.empty()) {
+            Nodo n = pila.back();
+            pila.pop_back();
+            if (n.nivel == profundidad) {
+                t.agregar(n.direccion);
+                continue;
+            }
+            int desplazamiento = 2 * (profundidad - n.nivel - 1);
+            for (int e = n.color == 0 ? 1 : 2; e >= 0; e--) {
+                Nodo hijo = { n.direccion | ((uint64_t)e << desplazamiento), tablas().uno[n.color][e].color, n.nivel + 1 };
+                pila.push_back(hijo);
+            }
+        }
+    }
+    return t;
+}
+
+void TeselacionCodificada::agregar(uint64_t direccion) {
+    assert(direccionValida(direccion, prof));
+    size_t n = datos.size();
+    datos.resize(n + bytesDir);
+    ponerLE(datos.data() + n, direccion, bytesDir);
+}
+
+uint64_t TeselacionCodificada::direccion(size_t i) const {
+    return leerLE(datos.data() + i * bytesDir, bytesDir);
+}
+
+void TeselacionCodificada::decodificar(size_t primero, size_t n, triangulo* salida) const {
+    assert(primero + n <= size());
+    const TablasDireccion& t = tablas();
+    // Los primeros prof % 4 niveles se aplican uno por uno junto con la raíz; el resto,
+    // en bloques de cuatro. estados[k] es el triángulo después del bloque k (el 0, el de
+    // la raíz y los niveles sueltos) y 'prefijo' la parte de la dirección que lo
+    // determina.
+    const int numBloques = prof / NIVELES_BLOQUE;
+    const int sueltos = prof % NIVELES_BLOQUE;
+    struct Estado {
+        uint64_t prefijo;
+        int color;
+        complex<double> v[3];
+    };
+    Estado estados[PROFUNDIDAD_MAXIMA_DIRECCION / NIVELES_BLOQUE + 1];
+    int validos = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t d = direccion(primero + i);
+        int k = 0;
+        while (k < validos && estados[k].prefijo == d >> (2 * NIVELES_BLOQUE * (numBloques - k)))
+            k++;
+        for (; k <= numBloques; k++) {
+            Estado& e = estados[k];
+            e.prefijo = d >> (2 * NIVELES_BLOQUE * (numBloques - k));
+            if (k == 0) {
+                triangulo raiz = trianguloDeRueda((int)(e.prefijo >> (2 * sueltos)));
+                e.color = raiz.color;
+                e.v[0] = raiz.A;
+                e.v[1] = raiz.B;
+                e.v[2] = raiz.C;
+                for (int s = sueltos - 1; s >= 0; s--) {
+                    const Paso& p = t.uno[e.color][(e.prefijo >> (2 * s)) & 3];
+                    complex<double> v[3] = { e.v[0], e.v[1], e.v[2] };
+                    aplicar(p, v, e.v);
+                    e.color = p.color;
+                }
+            }
+            else {
+                const Estado& anterior = estados[k - 1];
+                const Paso& p = t.bloque[anterior.color][e.prefijo & (CODIGOS_BLOQUE - 1)];
+                aplicar(p, anterior.v, e.v);
+                e.color = p.color;
+            }
+        }
+        validos = numBloques + 1;
+
+        const Estado& ultimo = estados[numBloques];
+        triangulo& r = salida[i];
+        r.color = ultimo.color;
+        r.A = ultimo.v[0];
+        r.B = ultimo.v[1];
+        r.C = ultimo.v[2];
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// Archivo: "PENRDIR" y un cero, versión, profundidad, bytes por dirección y número de
+// triángulos, todo en little endian, y luego las direcciones.
+static const char MAGIA_DIRECCIONES[8] = { 'P', 'E', 'N', 'R', 'D', 'I', 'R', 0 };
+static const uint32_t VERSION_DIRECCIONES = 1;
+
+bool TeselacionCodificada::guardar(const char* ruta) const {
+    uint8_t cabecera[28];
+    memcpy(cabecera, MAGIA_DIRECCIONES, 8);
+    ponerLE(cabecera + 8, VERSION_DIRECCIONES, 4);
+    ponerLE(cabecera + 12, (uint64_t)prof, 4);
+    ponerLE(cabecera + 16, (uint64_t)bytesDir, 4);
+    ponerLE(cabecera + 20, size(), 8);
+    FILE* f = fopen(ruta, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(cabecera, 1, sizeof(cabecera), f) == sizeof(cabecera) &&
+        fwrite(datos.data(), 1, datos.size(), f) == datos.size();
+    return fclose(f) == 0 && ok;
+}
+
+bool TeselacionCodificada::cargar(const char* ruta) {
+    FILE* f = fopen(ruta, "rb");
+    if (!f)
+        return false;
+    uint8_t cabecera[28];
+    bool ok = fread(cabecera, 1, sizeof(cabecera), f) == sizeof(cabecera) &&
+        memcmp(cabecera, MAGIA_DIRECCIONES, 8) == 0 && leerLE(cabecera + 8, 4) == VERSION_DIRECCIONES;
+    int p = ok ? (int)leerLE(cabecera + 12, 4) : 0;
+    ok = ok && p >= 0 && p <= PROFUNDIDAD_MAXIMA_DIRECCION;
+    const int bytes = ok ? (bitsDeDireccion(p) + 7) / 8 : 1;
+    ok = ok && (int)leerLE(cabecera + 16, 4) == bytes;
+    // El número de triángulos tiene que cuadrar con lo que queda del archivo antes de
+    // reservar nada, para que una cabecera corrupta no pida memoria de más.
+    long inicio = ok ? ftell(f) : -1;
+    ok = ok && inicio >= 0 && fseek(f, 0, SEEK_END) == 0;
+    long fin = ok ? ftell(f) : -1;
+    ok = ok && fin >= inicio && fseek(f, inicio, SEEK_SET) == 0;
+    const uint64_t restante = ok ? (uint64_t)(fin - inicio) : 0;
+    ok = ok && restante % bytes == 0 && leerLE(cabecera + 20, 8) == restante / bytes;
+    vector<uint8_t> leidos;
+    if (ok) {
+        leidos.resize((size_t)restante);
+        ok = fread(leidos.data(), 1, leidos.size(), f) == leidos.size();
+    }
+    fclose(f);
+    if (!ok)
+        return false;
+
+    TeselacionCodificada t(p);
+    t.datos.swap(leidos);
+    for (size_t i = 0; i < t.size(); i++)
+        if (!direccionValida(t.direccion(i), p))
+            return false;
+    *this = std::move(t);
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+* Codificación compacta de la teselación: cada triángulo se guarda como su dirección en
+* el árbol de subdivisión en lugar de sus coordenadas.
+*/
+#ifndef DIRECCIONES_H
+#define DIRECCIONES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Penrose.h"
+
+// Un triángulo final queda determinado por el triángulo de la rueda del que sale (0 a 9)
+// y por qué hijo se tomó en cada subdivisión: uno de dos si el padre es tipo cero, uno
+// de tres si es tipo uno, en el orden de subdividir() (hijo cero, hijo uno y, para
+// padres tipo uno, segundo hijo uno). La dirección empaca todo en un entero:
+//   bits 2p .. 2p + 3:   triángulo de la rueda
+//   bits 2(p - k) .. +1: hijo que se tomó en la subdivisión k (k = 1 .. p)
+// con p la profundidad. Las elecciones van de la primera en los bits altos a la última
+// en los bajos, así que ordenar direcciones es recorrer el árbol en profundidad, y dos
+// triángulos cercanos en ese orden comparten la parte alta de la dirección.
+const int PROFUNDIDAD_MAXIMA_DIRECCION = 30;
+
+// Bits de una dirección a esa profundidad.
+inline int bitsDeDireccion(int profundidad) { return 4 + 2 * profundidad; }
+
+// Regresa false si la dirección no corresponde a ningún triángulo (rueda fuera de rango,
+// elección 3, o elección 2 bajo un padre tipo cero).
+bool direccionValida(uint64_t direccion, int profundidad);
+
+// Teselación guardada como direcciones empacadas en bitsDeDireccion() redondeado a bytes
+// (4 bytes por triángulo a profundidad 12, contra 48 de BloqueSoA), en orden de bytes
+// little endian sin importar la máquina, así que los archivos de guardar() se pueden
+// llevar de una máquina a otra.
+class TeselacionCodificada {
+public:
+    explicit TeselacionCodificada(int profundidad = 0);
+
+    // Todos los triángulos de las semillas de la rueda indicadas (por default las diez),
+    // en el orden de GeneradorProfundidad.
+    static TeselacionCodificada rueda(int profundidad, int primeraSemilla = 0, int numSemillas = NUM_SECTORES);
+
+    void agregar(uint64_t direccion);
+    uint64_t direccion(size_t i) const;
+
+    // Reconstruye los triángulos primero .. primero + n - 1 en 'salida'. Las
+    // subdivisiones se aplican de cuatro en cuatro con matrices precalculadas, y como
+    // los triángulos vecinos comparten la parte alta de la dirección, la de la parte que
+    // no cambió se reutiliza del triángulo anterior: en un rango contiguo cuesta más o
+    // menos un bloque de cuatro niveles por triángulo. Las coordenadas difieren de las de
+    // subdividir() en unos cuantos ulps (las matrices redondean distinto).
+    void decodificar(size_t primero, size_t n, triangulo* salida) const;
+
+    // Archivo binario: cabecera y las direcciones tal como están en memoria. cargar()
+    // regresa false si el archivo no existe, está truncado o trae direcciones inválidas.
+    bool guardar(const char* ruta) const;
+    bool cargar(const char* ruta);
+
+    int profundidad() const { return prof; }
+    size_t size() const { return datos.size() / bytesDir; }
+    size_t bytesPorTriangulo() const { return bytesDir; }
+    size_t bytes() const { return datos.size(); }
+
+private:
+    int prof;
+    int bytesDir;
+    std::vector<uint8_t> datos;
+};
+
+#endif
@@ -0,0 +1,290 @@
+/*
+* Subdivisión con aritmética exacta en Z[zeta].
+*/
+#include "Exacto.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define EXACTO_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EXACTO_SSE2
+#endif
+
+using namespace std;
+
+// zeta^k rotado pi / 10, para la conversión a reales.
+static const double COS_BASE[4] = { cos(pi / 10), cos(pi / 10 + 2 * pi / 5), cos(pi / 10 + 4 * pi / 5), cos(pi / 10 + 6 * pi / 5) };
+static const double SEN_BASE[4] = { sin(pi / 10), sin(pi / 10 + 2 * pi / 5), sin(pi / 10 + 4 * pi / 5), sin(pi / 10 + 6 * pi / 5) };
+
+// Raíz décima de la unidad e^(i k pi / 5) en la base de Z[zeta]. Las pares son potencias
+// de zeta; las impares, menos una potencia de zeta (e^(i pi / 5) = -zeta^3).
+static PuntoExacto raizDecima(int k) {
+    k = ((k % 10) + 10) % 10;
+    int potencia = k % 2 == 0 ? k / 2 : ((k + 5) % 10) / 2;
+    int signo = k % 2 == 0 ? 1 : -1;
+    PuntoExacto p = { { 0, 0, 0, 0 } };
+    if (potencia < 4)
+        p.c[potencia] = signo;
+    else
+        p.c[0] = p.c[1] = p.c[2] = p.c[3] = -signo;
+    return p;
+}
+
+TrianguloExacto trianguloDeRuedaExacto(int j) {
+    // En el marco rotado, polar(1, (2j -+ 1) pi / 10) queda en e^(i (j - 1) pi / 5) y
+    // e^(i j pi / 5).
+    PuntoExacto origen = { { 0, 0, 0, 0 } };
+    TrianguloExacto t;
+    t.color = 0;
+    t.A = origen;
+    t.B = raizDecima(j - 1);
+    t.C = raizDecima(j);
+    if (j % 2 == 0)
+        swap(t.B, t.C);
+    return t;
+}
+
+void aReales(const PuntoExacto& p, double& x, double& y) {
+    x = p.c[0] * COS_BASE[0] + p.c[1] * COS_BASE[1] + p.c[2] * COS_BASE[2] + p.c[3] * COS_BASE[3];
+    y = p.c[0] * SEN_BASE[0] + p.c[1] * SEN_BASE[1] + p.c[2] * SEN_BASE[2] + p.c[3] * SEN_BASE[3];
+}
+
+// ------------------------------------------------------------------------------------
+// Mismo esquema que en Penrose.cpp: envolturas mínimas sobre registros de enteros para
+// escribir un solo kernel.
+struct EnteroEscalar {
+    typedef int32_t T;
+    static const int ancho = 1;
+    static T cargar(const int32_t* p) { return *p; }
+    static void guardar(int32_t* p, T v) { *p = v; }
+    static T sumar(T a, T b) { return a + b; }
+    static T restar(T a, T b) { return a - b; }
+};
+
+#if defined(EXACTO_AVX2)
+struct EnteroSimd {
+    typedef __m256i T;
+    static const int ancho = 8;
+    static T cargar(const int32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void guardar(int32_t* p, T v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static T sumar(T a, T b) { return _mm256_add_epi32(a, b); }
+    static T restar(T a, T b) { return _mm256_sub_epi32(a, b); }
+};
+#elif defined(EXACTO_SSE2)
+struct EnteroSimd {
+    typedef __m128i T;
+    static const int ancho = 4;
+    static T cargar(const int32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static void guardar(int32_t* p, T v) { _mm_storeu_si128((__m128i*)p, v); }
+    static T sumar(T a, T b) { return _mm_add_epi32(a, b); }
+    static T restar(T a, T b) { return _mm_sub_epi32(a, b); }
+};
+#else
+typedef EnteroEscalar EnteroSimd;
+#endif
+
+template <class V>
+struct PuntoVec {
+    typename V::T c[4];
+};
+
+template <class V>
+static inline PuntoVec<V> leer(int32_t* const coef[4], size_t i) {
+    PuntoVec<V> p;
+    for (int j = 0; j < 4; j++)
+        p.c[j] = V::cargar(coef[j] + i);
+    return p;
+}
+
+template <class V>
+static inline void escribir(int32_t* const coef[4], size_t i, const PuntoVec<V>& p) {
+    for (int j = 0; j < 4; j++)
+        V::guardar(coef[j] + i, p.c[j]);
+}
+
+// P = O + (H - O) / phi. Con d = H - O, d / phi = d zeta + d zeta^4, que en la base
+// queda (d1 - d0 - d3, d2 - d3, d1 - d0, d2 - d0 - d3).
+template <class V>
+static inline PuntoVec<V> puntoAureo(const PuntoVec<V>& o, const PuntoVec<V>& h) {
+    typedef typename V::T T;
+    T d0 = V::restar(h.c[0], o.c[0]), d1 = V::restar(h.c[1], o.c[1]);
+    T d2 = V::restar(h.c[2], o.c[2]), d3 = V::restar(h.c[3], o.c[3]);
+    T d10 = V::restar(d1, d0);
+    T d23 = V::restar(d2, d3);
+    PuntoVec<V> p;
+    p.c[0] = V::sumar(o.c[0], V::restar(d10, d3));
+    p.c[1] = V::sumar(o.c[1], d23);
+    p.c[2] = V::sumar(o.c[2], d10);
+    p.c[3] = V::sumar(o.c[3], V::restar(d23, d0));
+    return p;
+}
+
+// p * zeta: los coeficientes se recorren una potencia y el de zeta^4 se reparte con
+// zeta^4 = -1 - zeta - zeta^2 - zeta^3.
+static PuntoExacto porZeta(const PuntoExacto& p) {
+    PuntoExacto r = { { -p.c[3], p.c[0] - p.c[3], p.c[1] - p.c[3], p.c[2] - p.c[3] } };
+    return r;
+}
+
+PuntoExacto porPhi(const PuntoExacto& p) {
+    PuntoExacto z2 = porZeta(porZeta(p));
+    PuntoExacto z3 = porZeta(z2);
+    PuntoExacto r;
+    for (int j = 0; j < 4; j++)
+        r.c[j] = -z2.c[j] - z3.c[j];
+    return r;
+}
+
+static inline PuntoExacto puntoAureoExacto(const PuntoExacto& o, const PuntoExacto& h) {
+    PuntoVec<EnteroEscalar> a, b;
+    for (int j = 0; j < 4; j++) {
+        a.c[j] = o.c[j];
+        b.c[j] = h.c[j];
+    }
+    PuntoVec<EnteroEscalar> q = puntoAureo<EnteroEscalar>(a, b);
+    PuntoExacto r = { { q.c[0], q.c[1], q.c[2], q.c[3] } };
+    return r;
+}
+
+int hijosExactos(const TrianguloExacto& t, TrianguloExacto hijos[3]) {
+    if (t.color == 0) {
+        PuntoExacto P = puntoAureoExacto(t.A, t.B);
+        TrianguloExacto h0 = { 0, t.C, P, t.B };
+        TrianguloExacto h1 = { 1, P, t.C, t.A };
+        hijos[0] = h0;
+        hijos[1] = h1;
+        return 2;
+    }
+    PuntoExacto Q = puntoAureoExacto(t.B, t.A);
+    PuntoExacto R = puntoAureoExacto(t.B, t.C);
+    TrianguloExacto h0 = { 0, R, Q, t.A };
+    TrianguloExacto h1 = { 1, R, t.C, t.A };
+    TrianguloExacto h2 = { 1, Q, R, t.B };
+    hijos[0] = h0;
+    hijos[1] = h1;
+    hijos[2] = h2;
+    return 3;
+}
+
+// Triángulos tipo cero: P = A + (B - A) / phi
+//   hijo cero: (C, P, B)
+//   hijo uno:  (P, C, A)
+template <class V>
+static size_t kernelCeros(const BloqueExacto& p, size_t inicio, size_t fin, const BloqueExacto& h0, const BloqueExacto& h1) {
+    size_t i = inicio;
+    for (; i + V::ancho <= fin; i += V::ancho) {
+        PuntoVec<V> a = leer<V>(p.a, i), b = leer<V>(p.b, i), c = leer<V>(p.c, i);
+        PuntoVec<V> q = puntoAureo<V>(a, b);
+        escribir<V>(h0.a, i, c); escribir<V>(h0.b, i, q); escribir<V>(h0.c, i, b);
+        escribir<V>(h1.a, i, q); escribir<V>(h1.b, i, c); escribir<V>(h1.c, i, a);
+    }
+    return i;
+}
+
+// Triángulos tipo uno: Q = B + (A - B) / phi, R = B + (C - B) / phi
+//   hijo cero:         (R, Q, A)
+//   primer hijo uno:   (R, C, A)
+//   segundo hijo uno:  (Q, R, B)
+template <class V>
+static size_t kernelUnos(const BloqueExacto& p, size_t inicio, size_t fin, const BloqueExacto& h0, const BloqueExacto& h1,
+    const BloqueExacto& h2) {
+    size_t i = inicio;
+    for (; i + V::ancho <= fin; i += V::ancho) {
+        PuntoVec<V> a = leer<V>(p.a, i), b = leer<V>(p.b, i), c = leer<V>(p.c, i);
+        PuntoVec<V> q = puntoAureo<V>(b, a);
+        PuntoVec<V> r = puntoAureo<V>(b, c);
+        escribir<V>(h0.a, i, r); escribir<V>(h0.b, i, q); escribir<V>(h0.c, i, a);
+        escribir<V>(h1.a, i, r); escribir<V>(h1.b, i, c); escribir<V>(h1.c, i, a);
+        escribir<V>(h2.a, i, q); escribir<V>(h2.b, i, r); escribir<V>(h2.c, i, b);
+    }
+    return i;
+}
+
+// El kernel vectorial avanza mientras quepan registros completos y lo que sobra se
+// termina con la versión escalar.
+static void subdividirRango(const GeneracionExacta& origen, size_t inicioCeros, size_t finCeros, size_t inicioUnos,
+    size_t finUnos, const BloqueExacto destinos[5]) {
+    size_t i = kernelCeros<EnteroSimd>(origen.ceros, inicioCeros, finCeros, destinos[0], destinos[1]);
+    kernelCeros<EnteroEscalar>(origen.ceros, i, finCeros, destinos[0], destinos[1]);
+    i = kernelUnos<EnteroSimd>(origen.unos, inicioUnos, finUnos, destinos[2], destinos[3], destinos[4]);
+    kernelUnos<EnteroEscalar>(origen.unos, i, finUnos, destinos[2], destinos[3], destinos[4]);
+}
+
+// Igual que en subdividirParalelo(): debajo de esto no vale la pena despertar a los hilos.
+static const size_t TAM_PEDAZO = 16384;
+
+void subdividirExacto(const GeneracionExacta& origen, GeneracionExacta& destino, PoolHilos* hilos) {
+    const size_t z = origen.numCeros;
+    const size_t u = origen.numUnos;
+
+    // Cero de cero, uno de cero, cero de uno, primer y segundo uno de uno.
+    const BloqueExacto destinos[5] = { destino.ceros, destino.unos, destino.ceros.desde(z), destino.unos.desde(z),
+        destino.unos.desde(z + u) };
+
+    if (hilos == nullptr || hilos->tamano() == 1 || z + u < 2 * TAM_PEDAZO) {
+        subdividirRango(origen, 0, z, 0, u, destinos);
+    }
+    else {
+        // Límites en múltiplos de 8 para que cada pedazo use registros completos salvo
+        // el último.
+        size_t numPedazos = 4 * (size_t)hilos->tamano();
+        size_t pedazoCeros = (max((z + numPedazos - 1) / numPedazos, (size_t)1) + 7) & ~(size_t)7;
+        size_t pedazoUnos = (max((u + numPedazos - 1) / numPedazos, (size_t)1) + 7) & ~(size_t)7;
+        hilos->paraCada(numPedazos, [&](size_t k) {
+            size_t inicioCeros = min(k * pedazoCeros, z);
+            size_t inicioUnos = min(k * pedazoUnos, u);
+            subdividirRango(origen, inicioCeros, min(inicioCeros + pedazoCeros, z), inicioUnos,
+                min(inicioUnos + pedazoUnos, u), destinos);
+        });
+    }
+
+    destino.numCeros = z + u;
+    destino.numUnos = z + 2 * u;
+}
+
+// Reparte un pedazo de buffer en los doce arreglos de un bloque.
+static BloqueExacto repartir(int32_t* base, size_t cap) {
+    BloqueExacto b;
+    for (int j = 0; j < 4; j++) {
+        b.a[j] = base + j * cap;
+        b.b[j] = base + (4 + j) * cap;
+        b.c[j] = base + (8 + j) * cap;
+    }
+    return b;
+}
+
+ArenaExacta::ArenaExacta(size_t cerosIniciales, size_t unosIniciales, int generaciones)
+    : gen(0), maxGeneraciones(generaciones) {
+    assert(generaciones <= PROFUNDIDAD_MAXIMA_EXACTA);
+    capacidadesDeArena(cerosIniciales, unosIniciales, generaciones, capCeros, capUnos);
+    for (int b = 0; b < 2; b++) {
+        buffers[b].resize(12 * (capCeros[b] + capUnos[b]));
+        gens[b].ceros = repartir(buffers[b].data(), capCeros[b]);
+        gens[b].unos = repartir(buffers[b].data() + 12 * capCeros[b], capUnos[b]);
+        gens[b].numCeros = gens[b].numUnos = 0;
+    }
+}
+
+void ArenaExacta::agregar(const TrianguloExacto& t) {
+    assert(gen == 0);
+    GeneracionExacta& g = gens[0];
+    if (t.color == 0) {
+        assert(g.numCeros < capCeros[0]);
+        g.ceros.poner(g.numCeros++, t);
+    }
+    else {
+        assert(g.numUnos < capUnos[0]);
+        g.unos.poner(g.numUnos++, t);
+    }
+}
+
+void ArenaExacta::subdividir(PoolHilos* hilos) {
+    assert(gen < maxGeneraciones);
+    const GeneracionExacta& origen = gens[gen % 2];
+    gen++;
+    subdividirExacto(origen, gens[gen % 2], hilos);
+}
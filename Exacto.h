@@ -0,0 +1,124 @@
+/*
+* Aritmética exacta para la subdivisión: los vértices se guardan como enteros del anillo
+* Z[zeta], con zeta = e^(2 pi i / 5), en lugar de complex<double>.
+*/
+#ifndef EXACTO_H
+#define EXACTO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hilos.h"
+#include "Penrose.h"
+
+// Un punto es c0 + c1 zeta + c2 zeta^2 + c3 zeta^3 (zeta^4 = -1 - zeta - zeta^2 - zeta^3)
+// rotado pi / 10. Con esa rotación los vértices de la rueda son raíces décimas de la
+// unidad, que están en Z[zeta], y 1 / phi = zeta + zeta^4 también, así que
+// A + (B - A) / phi se calcula sólo con sumas y restas de enteros. No hay redondeo: los
+// vértices que comparten dos triángulos vecinos son iguales entero por entero.
+//
+// Los coeficientes crecen más o menos como phi^n con la profundidad n. Con int32_t
+// alcanzan (con margen para las restas intermedias) hasta PROFUNDIDAD_MAXIMA_EXACTA.
+const int PROFUNDIDAD_MAXIMA_EXACTA = 40;
+
+struct PuntoExacto {
+    int32_t c[4];
+
+    bool operator==(const PuntoExacto& o) const {
+        return c[0] == o.c[0] && c[1] == o.c[1] && c[2] == o.c[2] && c[3] == o.c[3];
+    }
+};
+
+struct TrianguloExacto {
+    int color;
+    PuntoExacto A;
+    PuntoExacto B;
+    PuntoExacto C;
+};
+
+// Igual que trianguloDeRueda(j), en coordenadas exactas.
+TrianguloExacto trianguloDeRuedaExacto(int j);
+
+// Conversión a coordenadas reales (deshace la rotación).
+void aReales(const PuntoExacto& p, double& x, double& y);
+
+// p * phi, también exacto: phi = 1 + zeta + zeta^4 = -zeta^2 - zeta^3.
+PuntoExacto porPhi(const PuntoExacto& p);
+// Hijos de un triángulo con las mismas reglas y el mismo orden que subdividirExacto().
+// Regresa cuántos son (2 o 3).
+int hijosExactos(const TrianguloExacto& t, TrianguloExacto hijos[3]);
+
+// Bloque de triángulos de un color con un arreglo por coeficiente de cada vértice, como
+// BloqueSoA.
+struct BloqueExacto {
+    int32_t* a[4];
+    int32_t* b[4];
+    int32_t* c[4];
+
+    BloqueExacto desde(size_t k) const {
+        BloqueExacto r;
+        for (int j = 0; j < 4; j++) {
+            r.a[j] = a[j] + k;
+            r.b[j] = b[j] + k;
+            r.c[j] = c[j] + k;
+        }
+        return r;
+    }
+    PuntoExacto punto(int32_t* const coef[4], size_t i) const {
+        PuntoExacto p = { { coef[0][i], coef[1][i], coef[2][i], coef[3][i] } };
+        return p;
+    }
+    TrianguloExacto obtener(size_t i, int color) const {
+        TrianguloExacto t = { color, punto(a, i), punto(b, i), punto(c, i) };
+        return t;
+    }
+    void poner(size_t i, const TrianguloExacto& t) {
+        for (int j = 0; j < 4; j++) {
+            a[j][i] = t.A.c[j];
+            b[j][i] = t.B.c[j];
+            c[j][i] = t.C.c[j];
+        }
+    }
+};
+
+struct GeneracionExacta {
+    BloqueExacto ceros;
+    BloqueExacto unos;
+    size_t numCeros;
+    size_t numUnos;
+};
+
+// Mismas reglas y mismo orden de hijos que subdividir() de Penrose.h. El kernel sólo
+// hace sumas y restas de enteros sobre arreglos contiguos; usa AVX2 o SSE2 si el
+// compilador los tiene habilitados y reparte el trabajo entre los hilos si se le pasan.
+void subdividirExacto(const GeneracionExacta& origen, GeneracionExacta& destino, PoolHilos* hilos = nullptr);
+
+// Equivalente de ArenaTriangulos con coordenadas exactas.
+class ArenaExacta {
+public:
+    ArenaExacta(size_t cerosIniciales, size_t unosIniciales, int generaciones);
+
+    ArenaExacta(const ArenaExacta&) = delete;
+    ArenaExacta& operator=(const ArenaExacta&) = delete;
+
+    void agregar(const TrianguloExacto& t);
+    void subdividir(PoolHilos* hilos = nullptr);
+
+    const GeneracionExacta& actual() const { return gens[gen % 2]; }
+    size_t size() const { return numCeros() + numUnos(); }
+    size_t numCeros() const { return actual().numCeros; }
+    size_t numUnos() const { return actual().numUnos; }
+    int generacion() const { return gen; }
+    size_t bytesReservados() const { return (buffers[0].size() + buffers[1].size()) * sizeof(int32_t); }
+
+private:
+    std::vector<int32_t> buffers[2];
+    GeneracionExacta gens[2];
+    size_t capCeros[2];
+    size_t capUnos[2];
+    int gen;
+    int maxGeneraciones;
+};
+
+#endif
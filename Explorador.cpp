@@ -0,0 +1,283 @@
+/*
+* Explorador de la teselación infinita.
+*/
+#include "Explorador.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+size_t Explorador::HashTriangulo::operator()(const TrianguloExacto& t) const {
+    // FNV-1a sobre los doce coeficientes y el color.
+    uint64_t h = 1469598103934665603ULL;
+    auto mezclar = [&h](int32_t v) {
+        h ^= (uint32_t)v;
+        h *= 1099511628211ULL;
+    };
+    mezclar(t.color);
+    for (int j = 0; j < 4; j++) {
+        mezclar(t.A.c[j]);
+        mezclar(t.B.c[j]);
+        mezclar(t.C.c[j]);
+    }
+    return (size_t)h;
+}
+
+Explorador::Explorador(int profundidad, size_t memoriaMaxima, unsigned numHilos)
+    : memoriaMaxima(memoriaMaxima), cuadro(0), siguienteId(1), inflacionesActuales(0), bytesUsados(0), salir(false) {
+    // Los pedazos tienen que quedar al menos una generación debajo de la rueda de radio
+    // 1: la rueda inflada sólo la reproduce desde ahí.
+    profundidad = max(profundidad, 1);
+    nivelPedazo = max(1, profundidad - PROFUNDIDAD_PEDAZO);
+    profundidadPedazo = profundidad - nivelPedazo;
+
+    if (numHilos == 0)
+        numHilos = max(thread::hardware_concurrency(), 2u) - 1;
+    for (unsigned i = 0; i < numHilos; i++)
+        hilos.emplace_back(&Explorador::trabajar, this);
+}
+
+Explorador::~Explorador() {
+    {
+        lock_guard<mutex> lock(mtx);
+        salir = true;
+        espera.clear();
+    }
+    hayTrabajo.notify_all();
+    for (thread& h : hilos)
+        h.join();
+}
+
+void Explorador::trabajar() {
+    for (;;) {
+        TrianguloExacto t;
+        {
+            unique_lock<mutex> lock(mtx);
+            hayTrabajo.wait(lock, [this]() { return salir || !espera.empty(); });
+            if (salir)
+                return;
+            t = espera.back();
+            espera.pop_back();
+            enProceso[t] = true;
+        }
+        unique_ptr<Pedazo> p = generar(t);
+        {
+            lock_guard<mutex> lock(mtx);
+            enProceso.erase(t);
+            terminados.push_back(move(p));
+        }
+        hayListos.notify_all();
+    }
+}
+
+// Subdivide el triángulo del pedazo en profundidad y guarda sus triángulos relativos a
+// la esquina A. Las cuentas son exactas, así que los vértices que comparten dos pedazos
+// vecinos salen iguales desde los dos.
+size_t Explorador::verticesPorPedazo() const {
+    return 3 * (size_t)max(censoTriangulos(1, 0, profundidadPedazo).total(), censoTriangulos(0, 1, profundidadPedazo).total());
+}
+
+unique_ptr<Pedazo> Explorador::generar(const TrianguloExacto& t) const {
+    unique_ptr<Pedazo> p(new Pedazo());
+    p->id = 0;
+    p->triangulo = t;
+    p->ultimoCuadro = 0;
+    aReales(t.A, p->ancla[0], p->ancla[1]);
+    p->vertices.reserve(3 * (size_t)censoTriangulos(t.color == 0, t.color == 1, profundidadPedazo).total());
+
+    struct Nodo {
+        TrianguloExacto t;
+        int nivel;
+    };
+    vector<Nodo> pila;
+    pila.reserve(2 * (size_t)profundidadPedazo + 1);
+    Nodo raiz = { t, 0 };
+    pila.push_back(raiz);
+    while (!pila.empty()) {
+        Nodo n = pila.back();
+        pila.pop_back();
+        if (n.nivel == profundidadPedazo) {
+            const PuntoExacto* v[3] = { &n.t.A, &n.t.B, &n.t.C };
+            for (int k = 0; k < 3; k++) {
+                double x, y;
+                aReales(*v[k], x, y);
+                VerticeRefinado r = { (float)(x - p->ancla[0]), (float)(y - p->ancla[1]),
+                    (uint8_t)(CLASE_CEROS + n.t.color), { 0, 0, 0 } };
+                p->vertices.push_back(r);
+            }
+            continue;
+        }
+        TrianguloExacto h[3];
+        int m = hijosExactos(n.t, h);
+        for (int k = m - 1; k >= 0; k--) {
+            Nodo hijo = { h[k], n.nivel + 1 };
+            pila.push_back(hijo);
+        }
+    }
+    return p;
+}
+
+// Recorre la rueda inflada desde sus diez triángulos hasta el nivel de los pedazos y se
+// queda con los que se ven: el círculo que los envuelve toca el cuadrado de la pantalla.
+void Explorador::buscarVisibles(const Camara& camara, vector<TrianguloExacto>& salida) {
+    salida.clear();
+
+    // La rueda de radio phi^(4k) cubre el círculo de radio phi^(4k) cos(pi / 10).
+    double mitad = 1 / camara.escala;
+    double alcance = hypot(fabs(camara.x) + mitad, fabs(camara.y) + mitad);
+    int k = 0;
+    while (k < INFLACIONES_MAXIMAS && pow(goldenRatio, 4 * k) * cos(pi / 10) < alcance)
+        k++;
+    inflacionesActuales = k;
+    const int nivelFinal = 4 * k + nivelPedazo;
+
+    struct Nodo {
+        TrianguloExacto t;
+        int nivel;
+    };
+    vector<Nodo> pila;
+    for (int j = 0; j < NUM_SECTORES; j++) {
+        Nodo raiz = { trianguloDeRuedaExacto(j), 0 };
+        for (int i = 0; i < 4 * k; i++) {
+            raiz.t.A = porPhi(raiz.t.A);
+            raiz.t.B = porPhi(raiz.t.B);
+            raiz.t.C = porPhi(raiz.t.C);
+        }
+        pila.push_back(raiz);
+    }
+    while (!pila.empty()) {
+        Nodo n = pila.back();
+        pila.pop_back();
+
+        double x[3], y[3];
+        aReales(n.t.A, x[0], y[0]);
+        aReales(n.t.B, x[1], y[1]);
+        aReales(n.t.C, x[2], y[2]);
+        double cx = (x[0] + x[1] + x[2]) / 3, cy = (y[0] + y[1] + y[2]) / 3;
+        double r2 = 0;
+        for (int v = 0; v < 3; v++)
+            r2 = max(r2, (x[v] - cx) * (x[v] - cx) + (y[v] - cy) * (y[v] - cy));
+        double dx = max(fabs(cx - camara.x) - mitad, 0.0), dy = max(fabs(cy - camara.y) - mitad, 0.0);
+        if (dx * dx + dy * dy > r2)
+            continue;
+
+        if (n.nivel == nivelFinal) {
+            salida.push_back(n.t);
+            continue;
+        }
+        TrianguloExacto h[3];
+        int m = hijosExactos(n.t, h);
+        for (int i = 0; i < m; i++) {
+            Nodo hijo = { h[i], n.nivel + 1 };
+            pila.push_back(hijo);
+        }
+    }
+}
+
+void Explorador::recoger() {
+    vector<unique_ptr<Pedazo> > nuevos;
+    {
+        lock_guard<mutex> lock(mtx);
+        nuevos.swap(terminados);
+    }
+    for (unique_ptr<Pedazo>& p : nuevos) {
+        if (indice.count(p->triangulo))
+            continue;
+        p->id = siguienteId++;
+        bytesUsados += p->bytes();
+        lru.push_front(move(p));
+        indice[lru.front()->triangulo] = lru.begin();
+    }
+}
+
+void Explorador::expulsar() {
+    while (bytesUsados > memoriaMaxima && !lru.empty() && lru.back()->ultimoCuadro != cuadro) {
+        const Pedazo& p = *lru.back();
+        expulsadosCuadro.push_back(p.id);
+        bytesUsados -= p.bytes();
+        indice.erase(p.triangulo);
+        lru.pop_back();
+    }
+}
+
+void Explorador::actualizar(const Camara& camara, bool esperar) {
+    cuadro++;
+    expulsadosCuadro.clear();
+    buscarVisibles(camara, enVista);
+
+    for (;;) {
+        recoger();
+        listos.clear();
+        pendientes.clear();
+        for (const TrianguloExacto& t : enVista) {
+            auto it = indice.find(t);
+            if (it == indice.end()) {
+                pendientes.push_back(t);
+                continue;
+            }
+            // Lo que se ve pasa al frente de la lista.
+            lru.splice(lru.begin(), lru, it->second);
+            Pedazo& p = *lru.front();
+            p.ultimoCuadro = cuadro;
+            listos.push_back(&p);
+        }
+
+        // Lo más cerca del centro de la pantalla se genera primero.
+        sort(pendientes.begin(), pendientes.end(), [&camara](const TrianguloExacto& a, const TrianguloExacto& b) {
+            double ax, ay, bx, by;
+            aReales(a.A, ax, ay);
+            aReales(b.A, bx, by);
+            return hypot(ax - camara.x, ay - camara.y) > hypot(bx - camara.x, by - camara.y);
+        });
+
+        unique_lock<mutex> lock(mtx);
+        // Lo que esperaba y ya no se ve se olvida; lo que un hilo ya está generando se
+        // deja terminar.
+        for (const TrianguloExacto& t : espera)
+            enProceso.erase(t);
+        espera.clear();
+        for (const TrianguloExacto& t : pendientes) {
+            if (enProceso.count(t))
+                continue;
+            enProceso[t] = false;
+            espera.push_back(t);
+        }
+        if (!espera.empty())
+            hayTrabajo.notify_all();
+        if (!esperar || pendientes.empty())
+            break;
+        hayListos.wait(lock, [this]() { return !terminados.empty(); });
+    }
+    expulsar();
+}
+
+Camara recorrido(double t) {
+    Camara c;
+    c.x = 0.4 * t;
+    c.y = 3 * sin(0.05 * t);
+    c.escala = 0.5 * pow(2.0, sin(0.07 * t));
+    return c;
+}
+
+void pedazoARecorte(const Pedazo& p, const Camara& camara, vector<VerticeRefinado>& salida) {
+    float dx = (float)(p.ancla[0] - camara.x), dy = (float)(p.ancla[1] - camara.y);
+    float escala = (float)camara.escala;
+    for (const VerticeRefinado& v : p.vertices) {
+        VerticeRefinado r = v;
+        r.x = (v.x + dx) * escala;
+        r.y = (v.y + dy) * escala;
+        salida.push_back(r);
+    }
+}
+
+void trianguloARecorte(const TrianguloExacto& t, const Camara& camara, vector<VerticeRefinado>& salida) {
+    const PuntoExacto* v[3] = { &t.A, &t.B, &t.C };
+    for (int k = 0; k < 3; k++) {
+        double x, y;
+        aReales(*v[k], x, y);
+        VerticeRefinado r = { (float)((x - camara.x) * camara.escala), (float)((y - camara.y) * camara.escala),
+            (uint8_t)(CLASE_CEROS + t.color), { 0, 0, 0 } };
+        salida.push_back(r);
+    }
+}
@@ -0,0 +1,152 @@
+/*
+* Explorador de la teselación infinita: la cámara se puede mover y acercar sin límite
+* por el plano. La teselación crece hacia afuera por inflación y se genera por pedazos
+* de tamaño fijo en hilos de trabajo, que se guardan en un caché LRU con un tope de
+* memoria.
+*/
+#ifndef EXPLORADOR_H
+#define EXPLORADOR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Exacto.h"
+#include "Vertice.h"
+
+// Punto del plano que queda en el centro de la pantalla y cuántas unidades de recorte
+// mide una unidad del plano (0.5 es el tamaño de la rueda en la animación).
+struct Camara {
+    double x = 0;
+    double y = 0;
+    double escala = 0.5;
+};
+
+// La rueda de radio phi^4 subdividida n + 4 veces contiene, tal cual y con los vértices
+// en el mismo orden, a la rueda de radio 1 subdividida n veces, para todo n >= 1. Así
+// que la rueda de radio phi^(4k) es la supertesela que se obtiene de inflar k veces
+// (componer cuatro generaciones de padres) la rueda original, y sus triángulos de un
+// mismo tamaño no dependen de k: cuando la cámara se sale de la rueda actual sólo se
+// pasa a la siguiente, sin tocar lo que ya se generó. Con coordenadas exactas
+// (Exacto.h) los coeficientes crecen con el radio; con int32_t alcanzan hasta
+// INFLACIONES_MAXIMAS, un radio de phi^40 = 2e8.
+const int INFLACIONES_MAXIMAS = 10;
+// Generaciones que se subdivide cada pedazo: unos cientos de triángulos.
+const int PROFUNDIDAD_PEDAZO = 6;
+const size_t MEMORIA_PEDAZOS = (size_t)64 << 20;
+// Límites del acercamiento. Al alejarse, el número de pedazos visibles crece con el
+// cuadrado; con 0.25 son unos 700.
+const double ESCALA_MINIMA = 0.25;
+const double ESCALA_MAXIMA = 16;
+
+// Un triángulo de la rueda inflada a PROFUNDIDAD_PEDAZO generaciones de la última. Se
+// identifica por su triángulo exacto, que es el mismo sin importar desde qué rueda se
+// llegó a él.
+struct Pedazo {
+    uint64_t id;                                // Único; lo usa quien guarde algo por pedazo
+    TrianguloExacto triangulo;
+    double ancla[2];                            // Esquina A, en coordenadas del plano
+    std::vector<VerticeRefinado> vertices;      // Relativos al ancla, tres por triángulo
+    unsigned long long ultimoCuadro;            // Último cuadro en que se vio
+
+    size_t bytes() const { return sizeof(Pedazo) + vertices.capacity() * sizeof(VerticeRefinado); }
+};
+
+class Explorador {
+public:
+    // 'profundidad' es la de los triángulos que se dibujan, contada desde la rueda de
+    // radio 1 como en la animación. Con 0 hilos se usa uno menos que los núcleos.
+    Explorador(int profundidad, size_t memoriaMaxima = MEMORIA_PEDAZOS, unsigned numHilos = 0);
+    ~Explorador();
+
+    Explorador(const Explorador&) = delete;
+    Explorador& operator=(const Explorador&) = delete;
+
+    // Prepara un cuadro: recoge los pedazos que terminaron los hilos, busca los que se
+    // ven con la cámara y pide los que falten. Los que ya no caben en la memoria se
+    // expulsan empezando por los que se vieron hace más tiempo (nunca uno del cuadro
+    // actual). Con 'esperar' no regresa hasta tener todos los visibles, para que dos
+    // corridas den los mismos cuadros.
+    void actualizar(const Camara& camara, bool esperar = false);
+
+    // Pedazos listos que se ven en el cuadro actual. Los punteros valen hasta el
+    // siguiente actualizar().
+    const std::vector<const Pedazo*>& visibles() const { return listos; }
+    // Triángulos de los pedazos que se ven pero todavía no están listos. Se pueden
+    // dibujar como un solo triángulo de su color mientras tanto.
+    const std::vector<TrianguloExacto>& faltantes() const { return pendientes; }
+    // Ids de los pedazos que se expulsaron en el último actualizar().
+    const std::vector<uint64_t>& expulsados() const { return expulsadosCuadro; }
+
+    // Máximo de vértices de un pedazo (los de tipo uno tienen más triángulos).
+    size_t verticesPorPedazo() const;
+
+    int inflaciones() const { return inflacionesActuales; }
+    size_t numPedazos() const { return lru.size(); }
+    size_t bytes() const { return bytesUsados; }
+
+private:
+    struct HashTriangulo {
+        size_t operator()(const TrianguloExacto& t) const;
+    };
+    struct IgualTriangulo {
+        bool operator()(const TrianguloExacto& a, const TrianguloExacto& b) const {
+            return a.color == b.color && a.A == b.A && a.B == b.B && a.C == b.C;
+        }
+    };
+    typedef std::list<std::unique_ptr<Pedazo> > ListaLru;
+
+    void trabajar();
+    std::unique_ptr<Pedazo> generar(const TrianguloExacto& t) const;
+    void buscarVisibles(const Camara& camara, std::vector<TrianguloExacto>& salida);
+    void recoger();
+    void expulsar();
+
+    int profundidadPedazo;      // Generaciones dentro de cada pedazo
+    int nivelPedazo;            // Nivel de los pedazos, desde la rueda de radio 1
+    size_t memoriaMaxima;
+    unsigned long long cuadro;
+    uint64_t siguienteId;
+    int inflacionesActuales;
+
+    // Caché: el frente de la lista es lo más reciente.
+    ListaLru lru;
+    std::unordered_map<TrianguloExacto, ListaLru::iterator, HashTriangulo, IgualTriangulo> indice;
+    size_t bytesUsados;
+
+    std::vector<TrianguloExacto> enVista;
+    std::vector<const Pedazo*> listos;
+    std::vector<TrianguloExacto> pendientes;
+    std::vector<uint64_t> expulsadosCuadro;
+
+    // Trabajo de los hilos. 'espera' se reemplaza en cada cuadro con lo que falta, así
+    // que lo que ya salió de la vista antes de empezarse nunca se genera; está ordenada
+    // por distancia a la cámara y se toma del final, lo más cercano. 'enProceso' tiene
+    // lo pedido que no ha terminado: false si espera, true si un hilo ya lo genera.
+    std::vector<std::thread> hilos;
+    std::mutex mtx;
+    std::condition_variable hayTrabajo;
+    std::condition_variable hayListos;
+    std::vector<TrianguloExacto> espera;
+    std::unordered_map<TrianguloExacto, bool, HashTriangulo, IgualTriangulo> enProceso;
+    std::vector<std::unique_ptr<Pedazo> > terminados;
+    bool salir;
+};
+
+// Recorrido automático para el modo de exhibición: la cámara avanza sin parar por el
+// plano, serpenteando y acercándose y alejándose despacio.
+Camara recorrido(double t);
+
+// Vértices en coordenadas de recorte de un pedazo o de un triángulo suelto, para
+// dibujarlos con Rasterizador::dibujarRefinados(). Se agregan al final de 'salida'.
+// Los del pedazo se calculan en float igual que explorador.vs.
+void pedazoARecorte(const Pedazo& p, const Camara& camara, std::vector<VerticeRefinado>& salida);
+void trianguloARecorte(const TrianguloExacto& t, const Camara& camara, std::vector<VerticeRefinado>& salida);
+
+#endif
@@ -0,0 +1,67 @@
+/*
+* Generación de la teselación en profundidad.
+*/
+#include "Generador.h"
+
+#include <cstdio>
+
+using namespace std;
+
+GeneradorProfundidad::GeneradorProfundidad(const triangulo* semillas, size_t numSemillas, int profundidad)
+    : semillas(semillas, semillas + numSemillas), siguienteSemilla(0), profundidad(profundidad) {
+    pila.reserve(2 * (size_t)profundidad + 1);
+}
+
+size_t GeneradorProfundidad::siguientes(triangulo* lote, size_t capacidad) {
+    size_t n = 0;
+    while (n < capacidad) {
+        if (pila.empty()) {
+            if (siguienteSemilla == semillas.size())
+                break;
+            Nodo raiz = { semillas[siguienteSemilla++], 0 };
+            pila.push_back(raiz);
+        }
+        Nodo nodo = pila.back();
+        pila.pop_back();
+        if (nodo.nivel == profundidad) {
+            lote[n++] = nodo.t;
+            continue;
+        }
+
+        // Los hijos se meten al revés para que salgan en el orden de subdividir().
+        triangulo hijos[3];
+        int k = hijosDe(nodo.t, hijos);
+        while (k > 0) {
+            Nodo h = { hijos[--k], nodo.nivel + 1 };
+            pila.push_back(h);
+        }
+    }
+    return n;
+}
+
+bool exportarTeselacion(const char* ruta, int profundidad, uint64_t& escritos) {
+    escritos = 0;
+    FILE* f = fopen(ruta, "wb");
+    if (!f)
+        return false;
+
+    triangulo rueda[NUM_SECTORES];
+    for (int j = 0; j < NUM_SECTORES; j++)
+        rueda[j] = trianguloDeRueda(j);
+
+    // Se usa el generador directamente (y no generarEnProfundidad) para dejar de generar
+    // en cuanto falle una escritura.
+    GeneradorProfundidad generador(rueda, NUM_SECTORES, profundidad);
+    const size_t TAM_LOTE = 4096;
+    vector<triangulo> lote(TAM_LOTE);
+    vector<TrianguloExportado> salida(TAM_LOTE);
+    bool ok = true;
+    for (size_t n; ok && (n = generador.siguientes(lote.data(), TAM_LOTE)) > 0;) {
+        for (size_t i = 0; i < n; i++)
+            salida[i] = TrianguloExportado::de(lote[i]);
+        ok = fwrite(salida.data(), sizeof(TrianguloExportado), n, f) == n;
+        if (ok)
+            escritos += n;
+    }
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,76 @@
+/*
+* Generación de la teselación en profundidad: en lugar de guardar generaciones
+* completas, recorre el árbol de subdivisión de cada semilla y entrega los triángulos de
+* la última generación por lotes.
+*/
+#ifndef GENERADOR_H
+#define GENERADOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Penrose.h"
+
+// Recorre en profundidad el árbol de subdivisión de las semillas con una pila explícita.
+// Cada nodo que se saca de la pila mete a sus dos o tres hijos, así que la pila nunca
+// pasa de 2 * profundidad + 1 triángulos: la memoria no depende de cuántos triángulos
+// tenga la teselación, sólo de la profundidad. Los vértices se calculan igual que en
+// subdividir(), así que salen exactamente los mismos triángulos que con ArenaTriangulos
+// (en otro orden: los hijos de cada triángulo quedan juntos).
+class GeneradorProfundidad {
+public:
+    GeneradorProfundidad(const triangulo* semillas, size_t numSemillas, int profundidad);
+
+    // Pone en 'lote' hasta 'capacidad' triángulos de la última generación y regresa
+    // cuántos puso. Regresa 0 cuando ya no quedan.
+    size_t siguientes(triangulo* lote, size_t capacidad);
+
+    // Memoria de trabajo, en bytes.
+    size_t bytes() const { return pila.capacity() * sizeof(Nodo) + semillas.capacity() * sizeof(triangulo); }
+
+private:
+    struct Nodo {
+        triangulo t;
+        int nivel;
+    };
+
+    std::vector<triangulo> semillas;
+    size_t siguienteSemilla;
+    std::vector<Nodo> pila;     // Se reserva completa en el constructor
+    int profundidad;
+};
+
+// Manda todos los triángulos de la última generación a 'sumidero' en lotes de hasta
+// 'tamLote': sumidero(const triangulo* lote, size_t n). Sólo se guarda un lote a la vez.
+template <typename Sumidero>
+void generarEnProfundidad(const triangulo* semillas, size_t numSemillas, int profundidad, Sumidero sumidero,
+    size_t tamLote = 4096) {
+    GeneradorProfundidad generador(semillas, numSemillas, profundidad);
+    std::vector<triangulo> lote(tamLote);
+    for (size_t n; (n = generador.siguientes(lote.data(), tamLote)) > 0;)
+        sumidero(lote.data(), n);
+}
+
+// Registro de un triángulo en los archivos exportados: Ax, Ay, Bx, By, Cx, Cy como float
+// y el color como uint32_t, en el orden de bytes de la máquina.
+const size_t BYTES_TRIANGULO_EXPORTADO = 28;
+struct TrianguloExportado {
+    float v[6];
+    uint32_t color;
+
+    static TrianguloExportado de(const triangulo& t) {
+        TrianguloExportado r = { { (float)t.A.real(), (float)t.A.imag(), (float)t.B.real(), (float)t.B.imag(),
+            (float)t.C.real(), (float)t.C.imag() }, (uint32_t)t.color };
+        return r;
+    }
+};
+static_assert(sizeof(TrianguloExportado) == BYTES_TRIANGULO_EXPORTADO, "Formato de exportación");
+
+// Escribe la rueda completa (los diez triángulos de trianguloDeRueda() subdivididos
+// 'profundidad' veces) a un archivo binario sin pasar por una arena, un
+// TrianguloExportado por triángulo. Regresa false si no se pudo escribir; en 'escritos'
+// queda cuántos triángulos se escribieron.
+bool exportarTeselacion(const char* ruta, int profundidad, uint64_t& escritos);
+
+#endif
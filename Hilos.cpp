@@ -0,0 +1,79 @@
+/*
+* Grupo de hilos de trabajo reutilizable.
+*/
+#include "Hilos.h"
+
+using namespace std;
+
+PoolHilos::PoolHilos(unsigned numHilos)
+    : tareaActual(nullptr), totalTareas(0), siguienteTarea(0), tareasPendientes(0), ronda(0), salir(false) {
+    if (numHilos == 0)
+        numHilos = thread::hardware_concurrency();
+    if (numHilos == 0)
+        numHilos = 1;
+    // El hilo que llama a paraCada() también trabaja, así que se crea uno menos.
+    for (unsigned i = 1; i < numHilos; i++)
+        hilos.emplace_back(&PoolHilos::trabajar, this);
+}
+
+PoolHilos::~PoolHilos() {
+    {
+        lock_guard<mutex> lock(mtx);
+        salir = true;
+    }
+    hayTrabajo.notify_all();
+    for (thread& h : hilos)
+        h.join();
+}
+
+void PoolHilos::paraCada(size_t numTareas, const function<void(size_t)>& tarea) {
+    if (numTareas == 0)
+        return;
+    if (hilos.empty() || numTareas == 1) {
+        for (size_t i = 0; i < numTareas; i++)
+            tarea(i);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(mtx);
+        tareaActual = &tarea;
+        totalTareas = numTareas;
+        siguienteTarea = 0;
+        tareasPendientes = numTareas;
+        ronda++;
+    }
+    hayTrabajo.notify_all();
+    tomarTareas();
+
+    unique_lock<mutex> lock(mtx);
+    terminaron.wait(lock, [this] { return tareasPendientes == 0; });
+    tareaActual = nullptr;
+}
+
+// Toma tareas una por una hasta que ya no quede ninguna por repartir.
+void PoolHilos::tomarTareas() {
+    unique_lock<mutex> lock(mtx);
+    while (tareaActual != nullptr && siguienteTarea < totalTareas) {
+        size_t i = siguienteTarea++;
+        const function<void(size_t)>& tarea = *tareaActual;
+        lock.unlock();
+        tarea(i);
+        lock.lock();
+        if (--tareasPendientes == 0)
+            terminaron.notify_all();
+    }
+}
+
+void PoolHilos::trabajar() {
+    unsigned long long vista = 0;
+    for (;;) {
+        {
+            unique_lock<mutex> lock(mtx);
+            hayTrabajo.wait(lock, [&] { return salir || ronda != vista; });
+            if (salir)
+                return;
+            vista = ronda;
+        }
+        tomarTareas();
+    }
+}
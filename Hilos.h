@@ -0,0 +1,70 @@
+/*
+* Grupo de hilos de trabajo reutilizable.
+*/
+#ifndef HILOS_H
+#define HILOS_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Grupo fijo de hilos que se crea una sola vez y se reutiliza para cada trabajo en
+// paralelo, para no pagar la creación de hilos en cada generación o cuadro.
+class PoolHilos {
+public:
+    // Con 0 hilos se usa std::thread::hardware_concurrency().
+    explicit PoolHilos(unsigned numHilos = 0);
+    ~PoolHilos();
+
+    PoolHilos(const PoolHilos&) = delete;
+    PoolHilos& operator=(const PoolHilos&) = delete;
+
+    // Ejecuta tarea(0) ... tarea(numTareas - 1) repartidas entre los hilos (el hilo que
+    // llama también trabaja) y regresa cuando todas terminaron. No es reentrante.
+    void paraCada(size_t numTareas, const std::function<void(size_t)>& tarea);
+
+    // Número total de hilos que trabajan, contando al que llama.
+    unsigned tamano() const { return (unsigned)hilos.size() + 1; }
+
+private:
+    void trabajar();
+    void tomarTareas();
+
+    std::vector<std::thread> hilos;
+    std::mutex mtx;
+    std::condition_variable hayTrabajo;
+    std::condition_variable terminaron;
+    const std::function<void(size_t)>* tareaActual;
+    size_t totalTareas;
+    size_t siguienteTarea;
+    size_t tareasPendientes;
+    unsigned long long ronda;
+    bool salir;
+};
+
+// Ordena por pedazos en paralelo y luego mezcla los pedazos de dos en dos, también en
+// paralelo. Los elementos iguales según 'menor' pueden quedar en cualquier orden.
+template <class T, class Menor>
+void ordenarParalelo(std::vector<T>& v, PoolHilos& hilos, Menor menor) {
+    size_t pedazos = 1;
+    while (pedazos < 2 * (size_t)hilos.tamano() && v.size() / (2 * pedazos) >= 4096)
+        pedazos *= 2;
+    const size_t tam = (v.size() + pedazos - 1) / pedazos;
+    hilos.paraCada(pedazos, [&](size_t p) {
+        size_t inicio = std::min(p * tam, v.size()), fin = std::min(inicio + tam, v.size());
+        std::sort(v.begin() + inicio, v.begin() + fin, menor);
+    });
+    for (size_t ancho = tam; pedazos > 1; ancho *= 2, pedazos /= 2) {
+        hilos.paraCada(pedazos / 2, [&](size_t p) {
+            size_t inicio = std::min(2 * p * ancho, v.size()), medio = std::min(inicio + ancho, v.size()),
+                fin = std::min(medio + ancho, v.size());
+            std::inplace_merge(v.begin() + inicio, v.begin() + medio, v.begin() + fin, menor);
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+* Teselación memoizada con prototipos.
+*/
+#include "Instancias.h"
+
+#include "Soldadura.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+// Tipo de un vértice del prototipo a partir de sus coordenadas en punto fijo. Se
+// tolera una unidad de redondeo; a las profundidades que se usan, ningún vértice
+// interior queda tan cerca de una arista.
+static int tipoDeVertice(const VerticeEmpacado& v) {
+    const int uno = (int)ESCALA_VERTICE;
+    bool enAB = abs(v.y) <= 1;
+    bool enCA = abs(v.x) <= 1;
+    bool enBC = abs(v.x + v.y - uno) <= 1;
+    if (enAB && enCA)
+        return ESQUINA_A;
+    if (enAB && enBC)
+        return ESQUINA_B;
+    if (enCA && enBC)
+        return ESQUINA_C;
+    if (enAB)
+        return ARISTA_AB;
+    if (enBC)
+        return ARISTA_BC;
+    if (enCA)
+        return ARISTA_CA;
+    return VERTICE_INTERIOR;
+}
+
+Prototipo crearPrototipo(int color, int profundidad, PoolHilos* hilos) {
+    triangulo referencia;
+    referencia.color = color;
+    referencia.A = complex<double>(0, 0);
+    referencia.B = complex<double>(1, 0);
+    referencia.C = complex<double>(0, 1);
+
+    ArenaTriangulos arena(color == 0 ? 1 : 0, color == 1 ? 1 : 0, profundidad);
+    arena.agregar(referencia);
+    for (int k = 0; k < profundidad; k++)
+        arena.subdividir(hilos);
+
+    Prototipo p;
+    SoldadorVertices soldador(cotaVerticesSoldados(arena.size(), profundidad));
+    p.indices.reserve(3 * arena.size());
+    soldador.agregarBloque(arena.actual().ceros, arena.numCeros(), CLASE_CEROS, p.indices);
+    soldador.agregarBloque(arena.actual().unos, arena.numUnos(), CLASE_UNOS, p.indices);
+    p.vertices = soldador.vertices();
+    for (VerticeEmpacado& v : p.vertices)
+        v.borde = (uint8_t)tipoDeVertice(v);
+    return p;
+}
+
+TeselacionMemoizada::TeselacionMemoizada(const triangulo& semilla, int profundidad, int profundidadPrototipo,
+    PoolHilos* hilos) {
+    prototipos[0] = crearPrototipo(0, profundidadPrototipo, hilos);
+    prototipos[1] = crearPrototipo(1, profundidadPrototipo, hilos);
+
+    int profundidadInstancias = profundidad - profundidadPrototipo;
+    ArenaTriangulos arena(semilla.color == 0 ? 1 : 0, semilla.color == 1 ? 1 : 0, profundidadInstancias);
+    arena.agregar(semilla);
+    for (int k = 0; k < profundidadInstancias; k++)
+        arena.subdividir(hilos);
+
+    // Todas las esquinas se sueldan con la misma clase: un triángulo cero y uno uno
+    // vecinos también tienen que ver la misma esquina.
+    SoldadorVertices soldador(cotaVerticesSoldados(arena.size(), profundidadInstancias));
+    vector<uint32_t> indices[2];
+    indices[0].reserve(3 * arena.numCeros());
+    indices[1].reserve(3 * arena.numUnos());
+    soldador.agregarBloque(arena.actual().ceros, arena.numCeros(), CLASE_CEROS, indices[0]);
+    soldador.agregarBloque(arena.actual().unos, arena.numUnos(), CLASE_CEROS, indices[1]);
+    soldador.marcarBordesDeSector();
+    const vector<VerticeEmpacado>& esquinas = soldador.vertices();
+
+    for (int c = 0; c < 2; c++) {
+        inst[c].resize(indices[c].size() / 3);
+        for (size_t i = 0; i < inst[c].size(); i++) {
+            InstanciaTriangulo& t = inst[c][i];
+            for (int k = 0; k < 3; k++) {
+                const VerticeEmpacado& v = esquinas[indices[c][3 * i + k]];
+                t.esquinas[k][0] = v.x;
+                t.esquinas[k][1] = v.y;
+                t.bordes[k] = v.borde;
+            }
+            t.relleno = 0;
+        }
+    }
+}
+
+size_t TeselacionMemoizada::numTriangulos() const {
+    return inst[0].size() * (prototipos[0].indices.size() / 3) + inst[1].size() * (prototipos[1].indices.size() / 3);
+}
+
+size_t TeselacionMemoizada::bytes() const {
+    size_t total = 0;
+    for (int c = 0; c < 2; c++) {
+        total += prototipos[c].vertices.size() * sizeof(VerticeEmpacado);
+        total += prototipos[c].indices.size() * sizeof(uint32_t);
+        total += inst[c].size() * sizeof(InstanciaTriangulo);
+    }
+    return total;
+}
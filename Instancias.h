@@ -0,0 +1,79 @@
+/*
+* Teselación memoizada: en lugar de subdividir toda la teselación hasta la profundidad
+* final, se subdivide una sola vez un triángulo de cada color (los prototipos) y la
+* teselación se guarda como los triángulos gruesos de una profundidad menor, cada uno
+* con una referencia al prototipo de su color.
+*/
+#ifndef INSTANCIAS_H
+#define INSTANCIAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hilos.h"
+#include "Penrose.h"
+#include "Vertice.h"
+
+// La subdivisión sólo hace combinaciones afines de A, B y C, así que la subdivisión k
+// veces de cualquier triángulo de color c es la del triángulo de referencia de color c
+// (A = (0, 0), B = (1, 0), C = (0, 1)) llevada por el mapa afín que manda esos vértices
+// a los del triángulo: un vértice (u, v) del prototipo queda en A + u (B - A) + v (C - A).
+//
+// Dos triángulos gruesos vecinos calculan por separado los vértices de su arista común.
+// Para que el redondeo no deje grietas, los vértices del prototipo que caen en una
+// esquina o en una arista se marcan con su TipoVerticePrototipo y se calculan sólo con
+// las dos esquinas de esa arista, con una fórmula simétrica que da el mismo resultado
+// bit a bit desde los dos lados (ver memoizado.vs).
+enum TipoVerticePrototipo {
+    VERTICE_INTERIOR = 0,
+    ESQUINA_A,
+    ESQUINA_B,
+    ESQUINA_C,
+    ARISTA_AB,          // Parámetro t = u, de A a B
+    ARISTA_BC,          // Parámetro t = v, de B a C
+    ARISTA_CA           // Parámetro t = 1 - v, de C a A
+};
+
+// Subdivisión del triángulo de referencia de un color, soldada y empacada: (u, v) en
+// punto fijo en x, y; la clase de color (CLASE_CEROS o CLASE_UNOS) y el
+// TipoVerticePrototipo en 'borde'.
+struct Prototipo {
+    std::vector<VerticeEmpacado> vertices;
+    std::vector<uint32_t> indices;
+};
+
+Prototipo crearPrototipo(int color, int profundidad, PoolHilos* hilos = nullptr);
+
+// Un triángulo grueso: sus tres esquinas en punto fijo (del sector 0, como los vértices
+// empacados) y el BordeSector de cada una. 16 bytes, contra los 8 bytes por vértice de
+// todos los triángulos finos que representa.
+struct InstanciaTriangulo {
+    int16_t esquinas[3][2];     // A, B, C
+    uint8_t bordes[3];
+    uint8_t relleno;
+};
+
+// Teselación de una semilla a 'profundidad' guardada como instancias de profundidad
+// profundidad - profundidadPrototipo de los dos prototipos de profundidadPrototipo.
+// La memoria pasa de crecer con la profundidad total a crecer sólo con la de las
+// instancias. Las esquinas de las instancias se sueldan, así que dos triángulos
+// gruesos vecinos ven exactamente los mismos valores.
+class TeselacionMemoizada {
+public:
+    TeselacionMemoizada(const triangulo& semilla, int profundidad, int profundidadPrototipo, PoolHilos* hilos = nullptr);
+
+    const Prototipo& prototipo(int color) const { return prototipos[color]; }
+    const std::vector<InstanciaTriangulo>& instancias(int color) const { return inst[color]; }
+
+    // Triángulos finos que se dibujan en total.
+    size_t numTriangulos() const;
+    // Memoria de los prototipos y las instancias, en bytes.
+    size_t bytes() const;
+
+private:
+    Prototipo prototipos[2];
+    std::vector<InstanciaTriangulo> inst[2];
+};
+
+#endif
@@ -1,9 +1,9 @@
 /*
-* Cdigo para generar una teselacin de penrose.
+* Código para generar una teselación de penrose.
 * Autores: 
     - Fabio G. Calo Dizy, 191489    
-    - Jos Alberto Mrquez Lujn, 187917
-    - Pedro Olivares Snchez, 190198
+    - José Alberto Márquez Luján, 187917
+    - Pedro Olivares Sánchez, 190198
 * Fecha de entrega: 17 de octubre de 2021
 *
 * Referencias: https://preshing.com/20110831/penrose-tiling-explained/
@@ -18,259 +18,440 @@
 
 #include <learnopengl/shader_s.h>
 
+#include "Penrose.h"
+#include "Malla.h"
+#include "Soldadura.h"
+#include "Instancias.h"
+#include "Exacto.h"
+#include "Generador.h"
+#include "Cache.h"
+#include "Plan.h"
+#include "Refinamiento.h"
+#include "Explorador.h"
+#include "Sustitucion.h"
+#include "Rombos.h"
+#include "Pentarrejilla.h"
+#include "Regiones.h"
+#include "Circulos.h"
+#include "Animacion.h"
+#include "Rasterizador.h"
+#include "Png.h"
+
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <cmath>
 #include <list>
+#include <memory>
 #include <complex>
+#include <future>
+#include <string>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 
-// Tamao de la pantalla
+// Tamaño de la pantalla
 const unsigned int SCR_WIDTH = 1000;
 const unsigned int SCR_HEIGHT = 1000;
 
 // #############################################################################
-// Declaracin de constantes a utilizar a lo largo de este programa
+// Declaración de constantes a utilizar a lo largo de este programa
 const int IMAGE_SIZE_X = SCR_WIDTH;
 const int IMAGE_SIZE_Y = SCR_HEIGHT;
 const int NUM_SUBDIVISONES = 7;
-const double goldenRatio = (1 + sqrt(5)) / 2;
-const double pi = 3.1415926535897932384626433832795028841971;
-
-//Control del tiempo
-/* 0: ### Inicio
-*  1: ### Tringulo entra en escena
-*  2: ### Tringulo se para un momento
-*  3: ### Tringulo se mueve hacia la trselacin y choca.
-*  4: ### Tringulo se para un momento
-*  5: ### Tringulo choca varias veces ms.
-*  6: ### Tringulo rota hasta quedar paralelo al suelo
-*  7: ### Tringulo se cae
-*  8: ### Tringulo cado se cambia de color
-*  9: ### Nuevo tringulo sube
-* 10: ### Tringulo rota hasta quedar como estaba antes
-* 11: ### Tringulo nuevo se para un momento
-* 12: ### Tringulo nuevo se incorpora a la teselacin
-* 13: ### La teselacin completa se hace grande
-*/
-//                          0     1     2     3     4     5     6     7     8     9     10    11    12    13
-const float tiempos[14] = { 2.0f, 1.0f, 1.5f, 1.5f, 0.5f, 2.0f, 0.5f, 0.5f, 4.0f, 2.0f, 2.0f, 1.0f, 2.0f, 3.5f };
+
+//Control del tiempo. Las fases de la animación y su duración están en Animacion.h
 int tiempoIndex = 0;
 
-// Estructura que guarda la informacin de los tringulos a dibujar
-struct triangulo {
-    int color;
-    complex<double> A;
-    complex<double> B;
-    complex<double> C;
-};
-
-// Mtodo para subdividir todos los tringulos de manera que el resultante sea un
-// tipo de estructura como la de Penrose. Recibe una lista de apuntadores a los
-// tringulos ya creados y regresa otra lista con la subdivisin de los tringulos.
-// Podra optimizarse liberando la memoria de los tringulos originales.
-list<struct triangulo*> subdividir(list<struct triangulo*> triangulos) {
-    list<struct triangulo*> resultado = {};
-    list<struct triangulo*> ::iterator it;
-    // Iteramos sobre la lista que nos pasaron como argumento
-    for (it = triangulos.begin(); it != triangulos.end(); ++it) {
-        // Subdividimos al tringulo segn el tipo de color que tenga
-        if ((*it)->color == 0) {
-            complex<double> P;
-            struct triangulo* t1 = (struct triangulo*)malloc(sizeof(struct triangulo));
-            struct triangulo* t2 = (struct triangulo*)malloc(sizeof(struct triangulo));
-            P = (*it)->A + ((*it)->B - (*it)->A) / goldenRatio;
-
-            t1->color = 0;
-            t1->A = (*it)->C;
-            t1->B = P;
-            t1->C = (*it)->B;
-
-            t2->color = 1;
-            t2->A = P;
-            t2->B = (*it)->C;
-            t2->C = (*it)->A;
-
-            resultado.push_back(t1);
-            resultado.push_back(t2);
-        }
-        else {
-            complex<double> Q;
-            complex<double> R;
-            struct triangulo* t1 = (struct triangulo*)malloc(sizeof(struct triangulo));
-            struct triangulo* t2 = (struct triangulo*)malloc(sizeof(struct triangulo));
-            struct triangulo* t3 = (struct triangulo*)malloc(sizeof(struct triangulo));
-
-            Q = (*it)->B + ((*it)->A - (*it)->B) / goldenRatio;
-            R = (*it)->B + ((*it)->C - (*it)->B) / goldenRatio;
-
-            t1->color = 1;
-            t1->A = R;
-            t1->B = (*it)->C;
-            t1->C = (*it)->A;
-
-            t2->color = 1;
-            t2->A = Q;
-            t2->B = R;
-            t2->C = (*it)->B;
-
-            t3->color = 0;
-            t3->A = R;
-            t3->B = Q;
-            t3->C = (*it)->A;
-
-            resultado.push_back(t1);
-            resultado.push_back(t2);
-            resultado.push_back(t3);
-        }
+// Explorador (--explorar): lo que el teclado movió y acercó la cámara, encima del
+// recorrido automático, y la escala del último cuadro para que el paso de las flechas
+// sea siempre la misma fracción de la pantalla.
+bool explorando = false;
+double desplazamientoX = 0;
+double desplazamientoY = 0;
+double factorZoom = 1;
+double escalaExplorador = 0.5;
+// Pedazos que se suben a la GPU por cuadro como máximo; los demás se dibujan como un
+// solo triángulo hasta que les toque. Cada subida es un memcpy sin sincronizar a su
+// casilla (CasillasPedazos, Malla.h): un pedazo son 1131 vértices (13 KB) y la copia
+// mide alrededor de 1 us en CPU, unos 15 us con el tope. El tope sólo evita que un
+// alejamiento de golpe (cientos de pedazos nuevos) junte varios MB de copias y de
+// transferencia en un solo cuadro.
+const int SUBIDAS_POR_CUADRO = 16;
+
+// Este método no tiene una aplicación real en el código; sin embargo, lo utilicé para asegurarme
+// de que los valores que estaba generando el algoritmo fueran los correctos.
+void imprimeTriangulos(const ArenaTriangulos& triangulos) {
+    const Generacion& g = triangulos.actual();
+    for (size_t i = 0; i < g.numCeros + g.numUnos; i++) {
+        triangulo t = i < g.numCeros ? g.ceros.obtener(i, 0) : g.unos.obtener(i - g.numCeros, 1);
+        printf("%f, %f, 0.0 \n%f, %f, 0.0 \n%f, %f, 0.0\n", t.A.real(), t.A.imag(),
+            t.B.real(), t.B.imag(), t.C.real(), t.C.imag());
     }
-    return resultado;
+}
+// Subdivide el sector 0 con coordenadas de tipo S y suelda sus vértices.
+// Con 'reglas' se subdivide con ellas (Sustitucion.h) en lugar de con las de subdividir().
+template <typename S>
+SoldadorVertices soldarSector(int profundidad, PoolHilos& hilos, vector<uint32_t>& indices,
+    const ReglasSustitucion* reglas = nullptr) {
+    ArenaTriangulosT<S> sector(1, 0, profundidad, reglas ? kernelSustitucion<S>(*reglas) : nullptr);
+    sector.agregar(reglas ? semillaDeSector(*reglas) : trianguloDeRueda(0));
+    for (int j = 0; j < profundidad; j++)
+        sector.subdividir(&hilos);
+    SoldadorVertices soldador(cotaVerticesSoldados(sector.size(), profundidad), Escalar<S>::celdaSoldadura());
+    indices.reserve(3 * sector.size());
+    soldador.agregarBloque(sector.actual().ceros, sector.numCeros(), CLASE_CEROS, indices);
+    soldador.agregarBloque(sector.actual().unos, sector.numUnos(), CLASE_UNOS, indices);
+    soldador.marcarBordesDeSector();
+    return soldador;
 }
 
-// --------------------------------- Creacin de crculos
-//Nmero de tringulos usados para aproximar un crculo
-unsigned const int TRI_POR_CIRC = 10;
-
-//Crculos
-typedef struct Circ {
-    int color; // 0 o 1 (blanco o negro)    
-    float listaVert[TRI_POR_CIRC * 9];
-} circ;
-
-Circ crearCirc(int color, float x, float y, float radio) {
-    Circ nuevoCirc;
-    nuevoCirc.color = color;
-    float theta = 2 * pi / TRI_POR_CIRC;
-
-    for (int i = 0; i < 9 * TRI_POR_CIRC; i += 9) {
-        //Primer vrt.
-        nuevoCirc.listaVert[i] = x;
-        nuevoCirc.listaVert[i + 1] = y;
-        nuevoCirc.listaVert[i + 2] = 0.0f;
-
-        //Segundo vrt.
-        nuevoCirc.listaVert[i + 3] = x - radio * sin(-i * theta);
-        nuevoCirc.listaVert[i + 4] = y - radio * cos(-i * theta);
-        nuevoCirc.listaVert[i + 5] = 0.0f;
-
-        //Tercer vrt.
-        nuevoCirc.listaVert[i + 6] = x - radio * sin(-(i + 1) * theta);
-        nuevoCirc.listaVert[i + 7] = y - radio * cos(-(i + 1) * theta);
-        nuevoCirc.listaVert[i + 8] = 0.0f;
-    }
-    return nuevoCirc;
+// Igual, con coordenadas exactas.
+SoldadorVertices soldarSectorExacto(int profundidad, PoolHilos& hilos, vector<uint32_t>& indices) {
+    ArenaExacta sector(1, 0, profundidad);
+    sector.agregar(trianguloDeRuedaExacto(0));
+    for (int j = 0; j < profundidad; j++)
+        sector.subdividir(&hilos);
+    SoldadorVertices soldador(cotaVerticesSoldados(sector.size(), profundidad));
+    indices.reserve(3 * sector.size());
+    soldador.agregarBloque(sector.actual().ceros, sector.numCeros(), CLASE_CEROS, indices);
+    soldador.agregarBloque(sector.actual().unos, sector.numUnos(), CLASE_UNOS, indices);
+    soldador.marcarBordesDeSector();
+    return soldador;
 }
 
-// Este mtodo no tiene una aplicacin real en el cdigo; sin embargo, lo utilic para asegurarme
-// de que los valores que estaba generando el algoritmo fueran los correctos.
-void imprimeTriangulos(list<struct triangulo*> triangulos) {
-    list<struct triangulo*> ::iterator it;
-    for (it = triangulos.begin(); it != triangulos.end(); ++it) {
-        printf("%f, %f, 0.0 \n%f, %f, 0.0 \n%f, %f, 0.0\n", (*it)->A.real(), (*it)->A.imag(),
-            (*it)->B.real(), (*it)->B.imag(), (*it)->C.real(), (*it)->C.imag());
-    }
+// Subdivide la rueda completa (los 10 sectores) y suelda sus vértices, para las
+// exportaciones que necesitan la teselación entera y no un sector.
+SoldadorVertices soldarRueda(int profundidad, PoolHilos& hilos, vector<uint32_t>& indices) {
+    ArenaTriangulos rueda(NUM_SECTORES, 0, profundidad);
+    for (int j = 0; j < NUM_SECTORES; j++)
+        rueda.agregar(trianguloDeRueda(j));
+    for (int j = 0; j < profundidad; j++)
+        rueda.subdividir(&hilos);
+    SoldadorVertices soldador(cotaVerticesSoldados(rueda.size(), profundidad, NUM_SECTORES));
+    indices.reserve(3 * rueda.size());
+    soldador.agregarBloque(rueda.actual().ceros, rueda.numCeros(), CLASE_CEROS, indices);
+    soldador.agregarBloque(rueda.actual().unos, rueda.numUnos(), CLASE_UNOS, indices);
+    return soldador;
 }
 // #########################################################################################
 
-// Mtodo principal
-int main()
+// Método principal
+int main(int argc, char* argv[])
 {
-    // Parte para calcular lo de Penrose
-    // Empezamos con 10 tringulos alrededor del origen.
-    list<struct triangulo*> triangulos = {};    // Teselacin principal. Estar incompleta
-    list<struct triangulo*> triProtag = {};     // Tringulo protagonista.
-    complex<double> A(0, 0);
-
-    for (int j = 0; j < 10; j++) {
-        struct triangulo* t = (struct triangulo*)malloc(sizeof(struct triangulo));
-        t->color = 0;
-        t->A = A;
-        t->B = polar(1.0, ((2 * j - 1) * pi) / 10.0);
-        t->C = polar(1.0, ((2 * j + 1) * pi) / 10.0);
-        if (j % 2 == 0) {
-            complex<double> aux = t->B;
-            t->B = t->C;
-            t->C = aux;
+    // Opciones de línea de comandos:
+    //   --sin-ventana       dibuja la animación con el rasterizador por software, sin
+    //                       necesitar GPU ni pantalla.
+    //   --exportar <dir>    dibuja la animación cuadro por cuadro a paso fijo y guarda
+    //                       cada cuadro en el directorio (que ya debe existir).
+    //   --fps <n>           cuadros por segundo de la exportación (60 por default).
+    //   --formato png|rgba  formato de los cuadros exportados (png por default).
+    //   --profundidad <n>   veces que se subdivide la teselación (NUM_SUBDIVISONES por
+    //                       default).
+    //   --memoizar <k>      en lugar de subdividir todo, subdivide k veces un triángulo
+    //                       de cada color y dibuja la teselación como instancias de esos
+    //                       dos prototipos (Instancias.h). Permite profundidades que no
+    //                       caben en memoria de otro modo.
+    //   --exacto            subdivide con coordenadas exactas (Exacto.h) en lugar de
+    //                       double. No aplica con --memoizar.
+    //   --escalar float|double|fijo
+    //                       tipo de las coordenadas de la subdivisión (double por
+    //                       default; fijo es punto fijo de 32 bits). No aplica con
+    //                       --memoizar ni con --exacto.
+    //   --exportar-teselacion <archivo>
+    //                       escribe la rueda completa a la profundidad dada en binario
+    //                       (Generador.h) y termina. Genera en profundidad, así que la
+    //                       memoria no crece con el número de triángulos.
+    //   --region <x0,y0,x1,y1>
+    //                       con --exportar-teselacion, en lugar de la rueda escribe los
+    //                       rombos que tocan ese rectángulo del plano, generados
+    //                       directamente con la pentarrejilla (Pentarrejilla.h) y del
+    //                       tamaño de la rueda subdividida --profundidad veces.
+    //   --cache <dir>       guarda la teselación soldada en un archivo de <dir> (Cache.h)
+    //                       y en los siguientes arranques la mapea en lugar de volver a
+    //                       subdividir. No aplica con --memoizar.
+    //   --refinar <px>      no subdivide por adelantado: cada cuadro refina sólo los
+    //                       triángulos visibles hasta que midan menos de <px> pixeles
+    //                       (Refinamiento.h). Ignora --profundidad, --memoizar,
+    //                       --exacto, --escalar y --cache.
+    //   --presupuesto <n>   máximo de triángulos por cuadro con --refinar
+    //                       (PRESUPUESTO_REFINADO por default).
+    //   --explorar <s>      explorador de la teselación infinita (Explorador.h): la
+    //                       cámara sigue un recorrido automático y con ventana también
+    //                       se mueve con las flechas y se acerca con Q / E. Sin ventana
+    //                       el recorrido dura <s> segundos.
+    //   --memoria-pedazos <MB>
+    //                       tope de memoria del caché de pedazos del explorador.
+    //   --reglas <nombre>   subdivide con otras reglas de sustitución (Sustitucion.h):
+    //                       p3 (las de siempre), p2 (cometas y dardos) o molinete. Sólo
+    //                       cambia la teselación que se subdivide por adelantado; no
+    //                       aplica con --memoizar, --exacto ni --cache.
+    //   --exportar-svg <archivo>
+    //                       escribe la rueda completa a la profundidad dada como SVG y
+    //                       termina. Los triángulos vecinos del mismo color se juntan en
+    //                       un solo polígono por región (Regiones.h).
+    //   --svg-triangulos    con --exportar-svg, escribe un polígono por rombo o triángulo
+    //                       en lugar de por región, para comparar.
+    //   --dry-run           sólo reporta cuánta memoria, subida a la GPU y disco van a
+    //                       ocupar las opciones dadas (Plan.h) y termina.
+    bool sinVentana = false;
+    const char* dirExportar = nullptr;
+    int fps = 60;
+    bool formatoPng = true;
+    int profundidad = NUM_SUBDIVISONES;
+    int profMemo = 0;
+    bool exacto = false;
+    const char* escalar = "double";
+    const char* archivoTeselacion = nullptr;
+    bool conRegion = false;
+    RegionPlano region = { 0, 0, 0, 0 };
+    const char* dirCache = nullptr;
+    double tamRefinado = 0;
+    size_t presupuesto = PRESUPUESTO_REFINADO;
+    double duracionExplorar = 0;
+    size_t memoriaPedazos = MEMORIA_PEDAZOS;
+    const ReglasSustitucion* reglas = nullptr;
+    const char* archivoSvg = nullptr;
+    bool svgTriangulos = false;
+    bool soloPlan = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sin-ventana") == 0)
+            sinVentana = true;
+        else if (strcmp(argv[i], "--exportar") == 0 && i + 1 < argc)
+            dirExportar = argv[++i];
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            fps = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--formato") == 0 && i + 1 < argc)
+            formatoPng = strcmp(argv[++i], "rgba") != 0;
+        else if (strcmp(argv[i], "--profundidad") == 0 && i + 1 < argc)
+            profundidad = max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--memoizar") == 0 && i + 1 < argc)
+            profMemo = max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--exacto") == 0)
+            exacto = true;
+        else if (strcmp(argv[i], "--escalar") == 0 && i + 1 < argc)
+            escalar = argv[++i];
+        else if (strcmp(argv[i], "--exportar-teselacion") == 0 && i + 1 < argc)
+            archivoTeselacion = argv[++i];
+        else if (strcmp(argv[i], "--region") == 0 && i + 1 < argc) {
+            conRegion = sscanf(argv[++i], "%lf,%lf,%lf,%lf", &region.x0, &region.y0, &region.x1, &region.y1) == 4;
+            if (!conRegion)
+                std::cout << "Región inválida: " << argv[i] << std::endl;
         }
-
-        // Si es el tringulo protagonista, lo pondremos en el arreglo aparte.
-        if (j == 0)
-            triProtag.push_back(t);
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            dirCache = argv[++i];
+        else if (strcmp(argv[i], "--refinar") == 0 && i + 1 < argc)
+            tamRefinado = max(0.0, atof(argv[++i]));
+        else if (strcmp(argv[i], "--presupuesto") == 0 && i + 1 < argc)
+            presupuesto = (size_t)max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--explorar") == 0 && i + 1 < argc) {
+            explorando = true;
+            duracionExplorar = max(0.0, atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--memoria-pedazos") == 0 && i + 1 < argc)
+            memoriaPedazos = (size_t)max(1, atoi(argv[++i])) << 20;
+        else if (strcmp(argv[i], "--reglas") == 0 && i + 1 < argc) {
+            reglas = buscarReglas(argv[++i]);
+            if (!reglas)
+                std::cout << "Reglas desconocidas: " << argv[i] << " (hay " << nombresDeReglas() << ")" << std::endl;
+        }
+        else if (strcmp(argv[i], "--exportar-svg") == 0 && i + 1 < argc)
+            archivoSvg = argv[++i];
+        else if (strcmp(argv[i], "--svg-triangulos") == 0)
+            svgTriangulos = true;
+        else if (strcmp(argv[i], "--dry-run") == 0)
+            soloPlan = true;
         else
-            triangulos.push_back(t);
-    }    
+            std::cout << "Opción desconocida: " << argv[i] << std::endl;
+    }
 
-    // Subdividimos los tringulos las veces que indice la constante NUM_SUBDIVISIONES.
-    for (int j = 0; j < NUM_SUBDIVISONES; j++) {
-        triangulos = subdividir(triangulos);
-        triProtag = subdividir(triProtag);
+    string errorReglas;
+    if (reglas && !validarReglas(*reglas, &errorReglas)) {
+        std::cout << "Reglas inválidas: " << errorReglas << std::endl;
+        return -1;
     }
 
-    // Guardamos los tringulos en formato de vrtices para OpenGL.
-    list<struct triangulo*> ::iterator it;
-    vector<float> vert_ceros;
-    vector<float> vert_unos;
-    for (it = triangulos.begin(); it != triangulos.end(); ++it) {
-        if ((*it)->color == 0) {
-            vert_ceros.push_back((float)(*it)->A.real());
-            vert_ceros.push_back((float)(*it)->A.imag());
-            vert_ceros.push_back(0.0);
-            vert_ceros.push_back((float)(*it)->B.real());
-            vert_ceros.push_back((float)(*it)->B.imag());
-            vert_ceros.push_back(0.0);
-            vert_ceros.push_back((float)(*it)->C.real());
-            vert_ceros.push_back((float)(*it)->C.imag());
-            vert_ceros.push_back(0.0);
+    // En el modo memoizado la teselación sale de los prototipos. Con --refinar y
+    // --explorar no se subdivide nada aquí: cada cuadro genera lo que se ve.
+    bool refinado = tamRefinado > 0 && !explorando;
+    bool teselacionFija = !refinado && !explorando;
+    profMemo = teselacionFija && !reglas ? min(profMemo, profundidad) : 0;
+    bool memoizado = profMemo > 0;
+    if (exacto) {
+        string motivo;
+        if (memoizado)
+            motivo = "no aplica con --memoizar";
+        else if (!teselacionFija)
+            motivo = "no aplica con --refinar ni con --explorar";
+        else if (reglas)
+            motivo = "no aplica con --reglas";
+        else if (profundidad > PROFUNDIDAD_MAXIMA_EXACTA)
+            motivo = "sólo alcanza hasta profundidad " + to_string(PROFUNDIDAD_MAXIMA_EXACTA);
+        if (!motivo.empty()) {
+            std::cout << "Aviso: se ignora --exacto (" << motivo << "); se usan coordenadas " << escalar << std::endl;
+            exacto = false;
         }
-        else {
-            vert_unos.push_back((float)(*it)->A.real());
-            vert_unos.push_back((float)(*it)->A.imag());
-            vert_unos.push_back(0.0);
-            vert_unos.push_back((float)(*it)->B.real());
-            vert_unos.push_back((float)(*it)->B.imag());
-            vert_unos.push_back(0.0);
-            vert_unos.push_back((float)(*it)->C.real());
-            vert_unos.push_back((float)(*it)->C.imag());
-            vert_unos.push_back(0.0);
+    }
+    // La llave del caché no distingue reglas.
+    if (reglas)
+        dirCache = nullptr;
+
+    if (soloPlan) {
+        size_t bytesPorPunto = 2 * sizeof(double);
+        if (!exacto && strcmp(escalar, "float") == 0)
+            bytesPorPunto = 2 * sizeof(float);
+        else if (!exacto && strcmp(escalar, "fijo") == 0)
+            bytesPorPunto = 2 * sizeof(Fijo32);
+        else if (exacto)
+            bytesPorPunto = sizeof(PuntoExacto);
+        imprimirPlan(planearMemoria(profundidad, bytesPorPunto, profMemo,
+            reglas ? kernelSustitucion<double>(*reglas)->hijos : HIJOS_ROBINSON));
+        return 0;
+    }
+
+    if (archivoTeselacion && conRegion) {
+        PoolHilos hilos;
+        auto inicio = chrono::steady_clock::now();
+        uint64_t escritos;
+        bool ok = exportarRegion(archivoTeselacion, region, profundidad, hilos, escritos);
+        double total = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        std::cout << escritos << " triángulos escritos en " << total << " s con " << hilos.tamano() << " hilos" << std::endl;
+        if (!ok) {
+            std::cout << "No se pudo escribir " << archivoTeselacion << std::endl;
+            return -1;
         }
+        return 0;
     }
-    // Hacemos lo mismo con el tringulo protagonista
-    vector<float> vert_ceros_protag;
-    vector<float> vert_unos_protag;
-    for (it = triProtag.begin(); it != triProtag.end(); ++it) {
-        if ((*it)->color == 0) {
-            vert_ceros_protag.push_back((float)(*it)->A.real());
-            vert_ceros_protag.push_back((float)(*it)->A.imag());
-            vert_ceros_protag.push_back(0.0);
-            vert_ceros_protag.push_back((float)(*it)->B.real());
-            vert_ceros_protag.push_back((float)(*it)->B.imag());
-            vert_ceros_protag.push_back(0.0);
-            vert_ceros_protag.push_back((float)(*it)->C.real());
-            vert_ceros_protag.push_back((float)(*it)->C.imag());
-            vert_ceros_protag.push_back(0.0);
+
+    if (archivoTeselacion) {
+        auto inicio = chrono::steady_clock::now();
+        uint64_t escritos;
+        bool ok = exportarTeselacion(archivoTeselacion, profundidad, escritos);
+        double total = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        std::cout << escritos << " de " << NUM_SECTORES * censoTriangulos(1, 0, profundidad).total() << " triángulos escritos en "
+            << total << " s" << std::endl;
+        if (!ok) {
+            std::cout << "No se pudo escribir " << archivoTeselacion << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    if (archivoSvg) {
+        PoolHilos hilos;
+        auto inicio = chrono::steady_clock::now();
+        vector<uint32_t> indices;
+        SoldadorVertices soldador = soldarRueda(profundidad, hilos, indices);
+        EstadoCuadro estado;
+        const float colores[2][3] = { { estado.color1[0], estado.color1[1], estado.color1[2] },
+            { estado.color2[0], estado.color2[1], estado.color2[2] } };
+        bool ok;
+        if (svgTriangulos) {
+            size_t rombos = juntarRombos(indices);
+            ok = exportarSvgTriangulos(archivoSvg, soldador.vertices().data(), indices.data(), indices.size(), rombos, colores);
+            std::cout << indices.size() / 3 << " triángulos en " << rombos + (indices.size() - 6 * rombos) / 3 << " polígonos";
         }
         else {
-            vert_unos_protag.push_back((float)(*it)->A.real());
-            vert_unos_protag.push_back((float)(*it)->A.imag());
-            vert_unos_protag.push_back(0.0);
-            vert_unos_protag.push_back((float)(*it)->B.real());
-            vert_unos_protag.push_back((float)(*it)->B.imag());
-            vert_unos_protag.push_back(0.0);
-            vert_unos_protag.push_back((float)(*it)->C.real());
-            vert_unos_protag.push_back((float)(*it)->C.imag());
-            vert_unos_protag.push_back(0.0);
+            RegionesTeselacion regiones;
+            unirRegiones(soldador.vertices().data(), indices.data(), indices.size(), hilos, regiones);
+            ok = exportarSvg(archivoSvg, soldador.vertices().data(), regiones, colores);
+            std::cout << indices.size() / 3 << " triángulos en " << regiones.regiones.size() << " regiones ("
+                << regiones.anillos.size() << " anillos, " << regiones.puntos.size() << " puntos)";
         }
+        double total = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        std::cout << " escritos en " << total << " s con " << hilos.tamano() << " hilos" << std::endl;
+        if (!ok) {
+            std::cout << "No se pudo escribir " << archivoSvg << std::endl;
+            return -1;
+        }
+        return 0;
     }
 
-    // Ahora toca hacer los crculos.    
+    // Parte para calcular lo de Penrose
+    // La rueda inicial son 10 triángulos alrededor del origen, pero todos son copias
+    // rotadas (y reflejadas) del triángulo 0, y sus subdivisiones también. Así que sólo se
+    // subdivide el sector 0 y los otros 9 se dibujan transformándolo con matrizSector().
+    // El sector 0 es además el triángulo protagonista.
+
+    // Subdividimos los triángulos las veces que indique la profundidad (NUM_SUBDIVISONES
+    // por default). Las generaciones grandes se reparten entre todos los núcleos.
+    PoolHilos hilos;
+    unique_ptr<TeselacionMemoizada> memo;
+    if (memoizado) {
+        memo.reset(new TeselacionMemoizada(trianguloDeRueda(0), profundidad, profMemo, &hilos));
+        std::cout << "Teselación memoizada: " << memo->numTriangulos() << " triángulos por sector en "
+            << memo->bytes() / 1024 << " KB (" << memo->instancias(0).size() + memo->instancias(1).size()
+            << " instancias de dos prototipos)" << std::endl;
+    }
+
+    // Matrices de cada sector, para el shader y el rasterizador.
+    glm::mat4 matSectores[NUM_SECTORES];
+    for (int j = 0; j < NUM_SECTORES; j++) {
+        double m[4];
+        matrizSector(j, m);
+        matSectores[j] = glm::mat4(1.0f);
+        // glm guarda por columnas: [columna][renglón].
+        matSectores[j][0][0] = (float)m[0];
+        matSectores[j][1][0] = (float)m[1];
+        matSectores[j][0][1] = (float)m[2];
+        matSectores[j][1][1] = (float)m[3];
+    }
+
+    // Guardamos los triángulos en formato de vértices para OpenGL. Todo lo que se dibuja
+    // con proyecto1.vs/.fs son vértices empacados, cada uno con su clase de color. Los
+    // vértices que comparten triángulos vecinos se sueldan en uno solo y los triángulos
+    // se guardan como índices. El sector va con las clases de la teselación principal
+    // (el shader las cambia en el protagonista). Como cada generación ya está separada
+    // por color, cada tramo se llena directamente de su bloque. Las arenas de la
+    // subdivisión se liberan en cuanto se sueldan.
+    // Después de soldar, las dos mitades de cada rombo se ponen seguidas al principio del
+    // buffer de índices (Rombos.h).
+    // Con --cache, si ya hay un archivo para esta configuración el sector se toma
+    // directamente del archivo mapeado, ya con los rombos juntos; si no, se genera y se
+    // guarda.
+    LlaveCache llave = { 0, (uint32_t)profundidad, PRECISION_DOUBLE, 0 };
+    if (exacto)
+        llave.precision = PRECISION_EXACTA;
+    else if (strcmp(escalar, "float") == 0)
+        llave.precision = PRECISION_FLOAT;
+    else if (strcmp(escalar, "fijo") == 0)
+        llave.precision = PRECISION_FIJO;
+    string rutaCache = dirCache ? rutaDeCache(dirCache, llave) : string();
+    CacheTeselacion cache;
+    bool enCache = !memoizado && teselacionFija && dirCache && cache.abrir(rutaCache.c_str(), llave);
+
+    vector<uint32_t> indEmpacados;
+    size_t rombosEmpacados = 0;
+    SoldadorVertices soldador;
+    if (!enCache && !memoizado && teselacionFija) {
+        if (exacto)
+            soldador = soldarSectorExacto(profundidad, hilos, indEmpacados);
+        else if (llave.precision == PRECISION_FLOAT)
+            soldador = soldarSector<float>(profundidad, hilos, indEmpacados, reglas);
+        else if (llave.precision == PRECISION_FIJO)
+            soldador = soldarSector<Fijo32>(profundidad, hilos, indEmpacados, reglas);
+        else
+            soldador = soldarSector<double>(profundidad, hilos, indEmpacados, reglas);
+        rombosEmpacados = juntarRombos(indEmpacados);
+        if (dirCache && !guardarCache(rutaCache.c_str(), llave, soldador.vertices().data(), soldador.size(),
+            indEmpacados.data(), indEmpacados.size(), rombosEmpacados))
+            std::cout << "No se pudo escribir " << rutaCache << std::endl;
+    }
+
+    const VerticeEmpacado* vertTeselacion = enCache ? cache.vertices() : soldador.vertices().data();
+    const size_t numVertTeselacion = enCache ? cache.numVertices() : soldador.size();
+    const uint32_t* indTeselacion = enCache ? cache.indices() : indEmpacados.data();
+    const size_t numIndTeselacion = enCache ? cache.numIndices() : indEmpacados.size();
+    const size_t rombosTeselacion = enCache ? cache.numRombos() : rombosEmpacados;
+
+    // Ahora toca hacer los círculos. Van en su propio arreglo para que el del sector
+    // pueda venir tal cual del caché.
     list<Circ> listaCirc;
-    vector<float> vertices2; //Lista de circ. blancos
-    vector<float> vertices3; //Lista de circ. negros
-    vector<int> indices2;
-    vector<int> indices3;
 
     // Ojo izquierdo
     listaCirc.push_back(crearCirc(0, 0.3f, 0.1f, 0.05f));
@@ -279,24 +460,189 @@ int main()
     listaCirc.push_back(crearCirc(0, 0.38f, 0.1f, 0.05f));
     listaCirc.push_back(crearCirc(1, 0.368f, 0.1f, 0.03f));
 
-    for (auto const& circActual : listaCirc) {
-        if (circActual.color == 0) {
-            for (int i = 0; i < TRI_POR_CIRC * 9; i++)
-                vertices2.push_back(circActual.listaVert[i]);
-        }
-        else {
-            for (int i = 0; i < TRI_POR_CIRC * 9; i++)
-                vertices3.push_back(circActual.listaVert[i]);
+    // Primero todos los círculos blancos y luego los negros, para que los negros queden
+    // encima.
+    SoldadorVertices soldadorOjos;
+    vector<uint32_t> indOjos;
+    indOjos.reserve(listaCirc.size() * TRI_POR_CIRC * 3);
+    for (int color = 0; color < 2; color++) {
+        for (auto const& circActual : listaCirc) {
+            if (circActual.color != color)
+                continue;
+            for (unsigned i = 0; i < TRI_POR_CIRC * 9; i += 3)
+                indOjos.push_back(soldadorOjos.agregar(circActual.listaVert[i], circActual.listaVert[i + 1],
+                    color == 0 ? CLASE_OJOS_BLANCOS : CLASE_OJOS_NEGROS));
         }
     }
+    const vector<VerticeEmpacado>& vertOjos = soldadorOjos.vertices();
 
-    for (int i = 0; i < 3 * TRI_POR_CIRC * listaCirc.size() / 2; i++)
-        indices2.push_back(i);
+    float desp_x = 0.25f;
+    float desp_y = 0.45f;
+    float tam = 0.25f;
+    // Foco
+    float vertices[] = {
+        // positions          // colors                     // texture coords
+         0.5f * tam + desp_x,  0.5f * tam + desp_y, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // top right
+         0.5f * tam + desp_x, -0.5f * tam + desp_y, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // bottom right
+        -0.5f * tam + desp_x, -0.5f * tam + desp_y, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // bottom left
+        -0.5f * tam + desp_x,  0.5f * tam + desp_y, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // top left 
+    };
+    unsigned int indices[] = {
+        0, 1, 3, // first triangle
+        1, 2, 3  // second triangle
+    };
 
-    for (int i = 0; i < 3 * TRI_POR_CIRC * listaCirc.size() / 2; i++)
-        indices3.push_back(i);
+    // Refinamiento según la vista: las semillas son los diez triángulos de la rueda, en el
+    // mismo orden en que se dibujan las instancias (los sectores 1 a 9 y al final el 0, que
+    // es el protagonista y va con sus clases y su transformación).
+    RefinadorVista refinador(SCR_WIDTH, SCR_HEIGHT, tamRefinado, presupuesto);
+    auto refinarCuadro = [&](const glm::mat4 transforms[2]) {
+        refinador.limpiar();
+        for (int j = 1; j <= NUM_SECTORES; j++) {
+            int sector = j % NUM_SECTORES;
+            int clase = sector == 0 ? CLASE_CEROS_PROTAG : CLASE_CEROS;
+            refinador.agregar(trianguloDeRueda(sector), transforms[transformacionDeClase(clase)], clase);
+        }
+        refinador.refinar();
+    };
+
+    // Explorador: sus pedazos se generan en sus propios hilos.
+    unique_ptr<Explorador> explorador;
+    if (explorando)
+        explorador.reset(new Explorador(profundidad, memoriaPedazos));
 
     // #######################################################################################
+    // Modos sin ventana: cada cuadro se rasteriza en memoria con el mismo orden de
+    // dibujo que el ciclo de render de OpenGL.
+    if (sinVentana || dirExportar) {
+        Rasterizador rast(SCR_WIDTH, SCR_HEIGHT, hilos);
+        Textura texFoco;
+        if (!cargarTextura("foco2.png", texFoco))
+            std::cout << "Failed to load texture" << std::endl;
+
+        auto dibujarCuadro = [&](int fase, const EstadoCuadro& estado) {
+            rast.limpiar(0.871f, 0.878f, 0.95f);
+            glm::mat4 transforms[2];
+            float colores[NUM_CLASES][3];
+            estado.transformaciones(transforms);
+            estado.tablaColores(colores);
+            if (refinado) {
+                refinarCuadro(transforms);
+                rast.dibujarRefinados(refinador.vertices().data(), refinador.vertices().size(), colores);
+            }
+            else if (memoizado) {
+                // Mismo orden que con instancias: sectores 1 a 9 y al final el 0.
+                for (int j = 1; j <= NUM_SECTORES; j++)
+                    for (int c = 0; c < 2; c++)
+                        rast.dibujarMemoizado(memo->prototipo(c), memo->instancias(c), transforms, colores,
+                            matSectores[j % NUM_SECTORES], j % NUM_SECTORES);
+            }
+            else {
+                rast.dibujarEmpacados(vertTeselacion, indTeselacion, numIndTeselacion, transforms, colores,
+                    matSectores, 1, NUM_SECTORES, rombosTeselacion);
+            }
+            if (faseDibujaOjos(fase))
+                rast.dibujarEmpacados(vertOjos.data(), indOjos.data(), indOjos.size(), transforms, colores, matSectores);
+            if (faseDibujaFoco(fase))
+                rast.dibujarTexturado(vertices, indices, 6, texFoco);
+            rast.terminar();
+        };
+
+        // El explorador usa los colores originales y no dibuja ni ojos ni foco.
+        vector<VerticeRefinado> vertExplorador;
+        auto dibujarExplorador = [&](const Camara& camara, bool esperar) {
+            explorador->actualizar(camara, esperar);
+            vertExplorador.clear();
+            for (const Pedazo* p : explorador->visibles())
+                pedazoARecorte(*p, camara, vertExplorador);
+            for (const TrianguloExacto& t : explorador->faltantes())
+                trianguloARecorte(t, camara, vertExplorador);
+            float colores[NUM_CLASES][3];
+            EstadoCuadro().tablaColores(colores);
+            rast.limpiar(0.871f, 0.878f, 0.95f);
+            rast.dibujarRefinados(vertExplorador.data(), vertExplorador.size(), colores);
+            rast.terminar();
+        };
+
+        // Mientras un cuadro se codifica y escribe en otro hilo, el siguiente ya se está
+        // dibujando.
+        future<bool> escritura;
+        vector<uint32_t> copia;
+        auto guardarCuadro = [&](int k) {
+            if (escritura.valid() && !escritura.get())
+                std::cout << "No se pudo escribir el cuadro " << k - 1 << std::endl;
+            copia = rast.pixeles();
+            char ruta[1024];
+            snprintf(ruta, sizeof(ruta), "%s/cuadro_%05d.%s", dirExportar, k, formatoPng ? "png" : "rgba");
+            string nombre = ruta;
+            escritura = async(launch::async, [&copia, nombre, formatoPng]() {
+                if (formatoPng)
+                    return guardarPng(nombre.c_str(), SCR_WIDTH, SCR_HEIGHT, copia.data());
+                FILE* f = fopen(nombre.c_str(), "wb");
+                if (!f)
+                    return false;
+                bool ok = fwrite(copia.data(), sizeof(uint32_t), copia.size(), f) == copia.size();
+                return fclose(f) == 0 && ok;
+            });
+        };
+
+        typedef chrono::steady_clock reloj;
+        reloj::time_point inicio = reloj::now();
+        int cuadros = 0;
+        if (explorando) {
+            // Recorrido a paso fijo. Al exportar se espera a tener todos los pedazos que
+            // se ven, para que dos corridas den los mismos archivos; sin exportar, los
+            // que falten se dibujan gruesos como en la ventana.
+            int totalCuadros = (int)ceil(duracionExplorar * fps);
+            for (int k = 0; k <= totalCuadros; k++) {
+                dibujarExplorador(recorrido((double)k / fps), dirExportar != nullptr);
+                if (dirExportar)
+                    guardarCuadro(k);
+                cuadros++;
+            }
+            std::cout << explorador->numPedazos() << " pedazos en caché (" << explorador->bytes() / 1024
+                << " KB), rueda inflada " << explorador->inflaciones() << " veces" << std::endl;
+        }
+        else if (dirExportar) {
+            // Exportación a paso fijo: el cuadro k corresponde al instante k / fps, sin
+            // importar cuánto tarde en dibujarse, así que dos corridas dan los mismos
+            // archivos.
+            int totalCuadros = (int)ceil(duracionTotal() * fps);
+            for (int k = 0; k <= totalCuadros; k++) {
+                int fase;
+                double t;
+                if (!faseEnTiempo((double)k / fps, fase, t))
+                    break;
+                EstadoCuadro estado;
+                evaluarFase(fase, t, estado);
+                dibujarCuadro(fase, estado);
+                guardarCuadro(k);
+                cuadros++;
+            }
+        }
+        else {
+            // Mismo control de tiempos que el ciclo de render, con el reloj de pared.
+            reloj::time_point inicioFase = inicio;
+            while (tiempoIndex < NUM_FASES) {
+                EstadoCuadro estado;
+                double t = chrono::duration<double>(reloj::now() - inicioFase).count();
+                if (t <= tiempos[tiempoIndex]) {
+                    evaluarFase(tiempoIndex, t, estado);
+                }
+                else {
+                    inicioFase = reloj::now();
+                    tiempoIndex++;
+                }
+                dibujarCuadro(tiempoIndex, estado);
+                cuadros++;
+            }
+        }
+        if (escritura.valid() && !escritura.get())
+            std::cout << "No se pudo escribir el último cuadro" << std::endl;
+        double total = chrono::duration<double>(reloj::now() - inicio).count();
+        std::cout << cuadros << " cuadros en " << total << " s (" << 1000.0 * total / cuadros << " ms por cuadro)" << std::endl;
+        return 0;
+    }
 
     // ------------------------------
     glfwInit();
@@ -308,7 +654,7 @@ int main()
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    // glfw creacin de la ventana
+    // glfw creación de la ventana
     // --------------------
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Proyecto 1", NULL, NULL);
     if (window == NULL)
@@ -333,89 +679,119 @@ int main()
     // ------------------------------------
     Shader ourShader("proyecto1.vs", "proyecto1.fs");
     Shader ourShader2("shaderAux.vs", "shaderAux.fs");
-    
-    float desp_x = 0.25f;
-    float desp_y = 0.45f;
-    float tam = 0.25f;
-    // Foco
-    float vertices[] = {
-        // positions          // colors                     // texture coords
-         0.5f * tam + desp_x,  0.5f * tam + desp_y, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f, // top right
-         0.5f * tam + desp_x, -0.5f * tam + desp_y, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f, // bottom right
-        -0.5f * tam + desp_x, -0.5f * tam + desp_y, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f, // bottom left
-        -0.5f * tam + desp_x,  0.5f * tam + desp_y, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f  // top left 
-    };
-    unsigned int indices[] = {
-        0, 1, 3, // first triangle
-        1, 2, 3  // second triangle
-    };
+    Shader ourShader3("memoizado.vs", "proyecto1.fs");
+    Shader ourShader4("refinado.vs", "proyecto1.fs");
+    Shader ourShader5("explorador.vs", "proyecto1.fs");
+    // Las ubicaciones de los uniforms se resuelven una sola vez; en el ciclo de render
+    // ya no se busca ningún nombre.
+    Uniform<glm::mat4> transformLoc = ourShader.uniform<glm::mat4>("transform");
+    Uniform<glm::vec3> coloresLoc = ourShader.uniform<glm::vec3>("colores");
+    Uniform<int> primerSectorLoc = ourShader.uniform<int>("primerSector");
+    // Las matrices de los sectores no cambian entre cuadros.
+    ourShader.use();
+    ourShader.set(ourShader.uniform<glm::mat4>("sectores"), matSectores, NUM_SECTORES);
+    Uniform<glm::mat4> transformMemoLoc = ourShader3.uniform<glm::mat4>("transform");
+    Uniform<glm::vec3> coloresMemoLoc = ourShader3.uniform<glm::vec3>("colores");
+    Uniform<glm::mat4> matSectorLoc = ourShader3.uniform<glm::mat4>("matSector");
+    Uniform<int> sectorLoc = ourShader3.uniform<int>("sector");
+    Uniform<glm::vec3> coloresRefinadoLoc = ourShader4.uniform<glm::vec3>("colores");
+    Uniform<glm::vec2> desplazamientoLoc = ourShader5.uniform<glm::vec2>("desplazamiento");
+    Uniform<float> escalaLoc = ourShader5.uniform<float>("escala");
+    Uniform<glm::vec3> coloresExploradorLoc = ourShader5.uniform<glm::vec3>("colores");
+
+    if (explorando) {
+        float colores[NUM_CLASES][3];
+        EstadoCuadro().tablaColores(colores);
+        ourShader4.use();
+        ourShader4.set(coloresRefinadoLoc, colores, NUM_CLASES);
+        ourShader5.use();
+        ourShader5.set(coloresExploradorLoc, colores, NUM_CLASES);
+
+        // Una casilla por pedazo, según su id; se suelta cuando el explorador lo expulsa.
+        // Lo que todavía no está en la GPU se junta en una sola malla de triángulos
+        // sueltos que se vuelve a llenar en cada cuadro.
+        CasillasPedazos casillas = crearCasillasPedazos(explorador->verticesPorPedazo());
+        unordered_map<uint64_t, int> casillasPedazos;
+        size_t capacidadFaltantes = 3 * 4096;
+        Malla mallaFaltantes = crearMallaRefinada("pedazos faltantes", capacidadFaltantes);
+        vector<VerticeRefinado> vertFaltantes;
+        glfwSetTime(0.0f);
+        while (!glfwWindowShouldClose(window)) {
+            processInput(window);
+            Camara camara = recorrido(glfwGetTime());
+            camara.x += desplazamientoX;
+            camara.y += desplazamientoY;
+            camara.escala = min(max(camara.escala * factorZoom, ESCALA_MINIMA), ESCALA_MAXIMA);
+            escalaExplorador = camara.escala;
+
+            explorador->actualizar(camara);
+            for (uint64_t id : explorador->expulsados()) {
+                auto it = casillasPedazos.find(id);
+                if (it != casillasPedazos.end()) {
+                    soltarPedazo(casillas, it->second);
+                    casillasPedazos.erase(it);
+                }
+            }
 
+            glClearColor(0.871f, 0.878f, 0.95f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ourShader5.use();
+            ourShader5.set(escalaLoc, (float)camara.escala);
+            vertFaltantes.clear();
+            int subidas = 0;
+            for (const Pedazo* p : explorador->visibles()) {
+                auto it = casillasPedazos.find(p->id);
+                if (it == casillasPedazos.end()) {
+                    if (subidas == SUBIDAS_POR_CUADRO) {
+                        trianguloARecorte(p->triangulo, camara, vertFaltantes);
+                        continue;
+                    }
+                    int casilla = subirPedazo(casillas, p->vertices.data(), p->vertices.size());
+                    it = casillasPedazos.insert(make_pair(p->id, casilla)).first;
+                    subidas++;
+                }
+                // La resta se hace en double, así que no importa qué tan lejos esté la cámara.
+                ourShader5.set(desplazamientoLoc, glm::vec2((float)(p->ancla[0] - camara.x), (float)(p->ancla[1] - camara.y)));
+                dibujarPedazo(casillas, it->second);
+            }
+            for (const TrianguloExacto& t : explorador->faltantes())
+                trianguloARecorte(t, camara, vertFaltantes);
+            if (!vertFaltantes.empty()) {
+                ourShader4.use();
+                capacidadFaltantes = max(capacidadFaltantes, vertFaltantes.size());
+                subirRefinados(mallaFaltantes, vertFaltantes.data(), vertFaltantes.size(), capacidadFaltantes);
+                mallaFaltantes.dibujar();
+            }
+            terminarCuadroPedazos(casillas);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        destruirCasillasPedazos(casillas);
+        destruirMalla(mallaFaltantes);
+        glfwTerminate();
+        return 0;
+    }
+    
+    // Mallas. Cada una sabe cuántos vértices e índices tiene, así que las llamadas de
+    // dibujo ya no dependen de cuentas hechas a mano.
     // ------------------------------------------------------------------
-    unsigned int VBOs[7], VAOs[7], EBOs[3];
-    glGenVertexArrays(7, VAOs); // Generamos seis VAOs y seis Buffers
-    glGenBuffers(7, VBOs);
-    glGenBuffers(3, EBOs); // Solamente usamos EBO para los crculos (ojos)
-    // Tringulos tipo cero de la teselacin PRINCIPAL
-    // --------------------
-    glBindVertexArray(VAOs[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-    glBufferData(GL_ARRAY_BUFFER, vert_ceros.size() * sizeof(float), &vert_ceros[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Tringulos tipo uno de la teselacin PRINCIPAL
-    // ---------------------
-    glBindVertexArray(VAOs[1]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-    glBufferData(GL_ARRAY_BUFFER, vert_unos.size() * sizeof(float), &vert_unos[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(0);
-    // Tringulos tipo cero del tringulo PROTAGONISTA
-    // --------------------
-    glBindVertexArray(VAOs[2]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[2]);
-    glBufferData(GL_ARRAY_BUFFER, vert_ceros_protag.size() * sizeof(float), &vert_ceros_protag[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Tringulos tipo uno del tringulo PROTAGONISTA
-    // ---------------------
-    glBindVertexArray(VAOs[3]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[3]);
-    glBufferData(GL_ARRAY_BUFFER, vert_unos_protag.size() * sizeof(float), &vert_unos_protag[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexAttribArray(0);
-    // Crculos blancos (Ojos)
-    // ---------------------
-    glBindVertexArray(VAOs[4]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[4]);
-    glBufferData(GL_ARRAY_BUFFER, vertices2.size() * sizeof(float), &vertices2[0], GL_STATIC_DRAW);    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[0]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices2.size() * sizeof(int), &indices2[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    //Crculos negros (Ojos)
-    // ---------------------
-    glBindVertexArray(VAOs[5]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[5]);
-    glBufferData(GL_ARRAY_BUFFER, vertices3.size() * sizeof(float), &vertices3[0], GL_STATIC_DRAW);    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices3.size() * sizeof(int), &indices3[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Foco
-    glBindVertexArray(VAOs[6]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[6]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[2]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // texture coord attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // Sector de la teselación (que también es el triángulo PROTAGONISTA), que puede venir
+    // directamente del archivo mapeado, y ojos
+    Malla mallaEmpacada = crearMallaEmpacada("teselacion", vertTeselacion, numVertTeselacion, indTeselacion, numIndTeselacion);
+    Malla mallaOjos = crearMallaEmpacada("ojos", vertOjos.data(), vertOjos.size(), indOjos.data(), indOjos.size());
+    // Prototipos de la teselación memoizada, con sus instancias
+    Malla mallasMemo[2];
+    if (memoizado) {
+        mallasMemo[0] = crearMallaMemoizada("prototipo cero", memo->prototipo(0), memo->instancias(0));
+        mallasMemo[1] = crearMallaMemoizada("prototipo uno", memo->prototipo(1), memo->instancias(1));
+    }
+    // Teselación refinada según la vista, que se vuelve a llenar en cada cuadro
+    Malla mallaRefinada;
+    if (refinado)
+        mallaRefinada = crearMallaRefinada("teselacion refinada", 3 * presupuesto);
+    // Foco: posición, color y coordenadas de textura
+    Malla mallaFoco = crearMalla("foco", vertices, sizeof(vertices) / sizeof(float), { 3, 3, 2 }, indices, sizeof(indices) / sizeof(unsigned int));
 
     unsigned int texture;
     glGenTextures(1, &texture);
@@ -440,285 +816,21 @@ int main()
     }
     stbi_image_free(data);    
 
-    // Para dibujar nicamente los bordes
+    // Para dibujar únicamente los bordes
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);    
     glfwSetTime(0.0f);
     while (!glfwWindowShouldClose(window)) {
         processInput(window);        
 
-        // Variables
-        float scaleAmount = 1.0f;
-        float aux;
-        float rotAux = 0.0f;
-        // Declaracin de las matrices de transformacin que vamos a estar usando. Son la identidad por default.
-        glm::mat4 transform = glm::mat4(1.0f);          // Matriz para transformar la teselacin principal
-        glm::mat4 transform_protag = glm::mat4(1.0f);   // Matriz para transformar al tringulo protagonista        
-
-        // Colores
-        GLfloat color1[] = { 0.043f, 0.145f, 0.271f };                  // Color 1 de la teselacin principal
-        GLfloat color2[] = { 0.698f, 0.761f, 0.929f };                  // Color 2 de la teselacin principal
-        GLfloat color_cero_protag[] = { 0.8705f, 0.7686f, 0.2509f };    // Color cero del tringulo protagonista
-        GLfloat color_uno_protag[] = { 0.8705f, 0.7686f, 0.2509f };     // Color uno del tringulo protagonista
-        GLfloat color_ojos_blancos[] = { 1.0f, 1.0f, 1.0f };            // Color blanco de los ojos del protagonista
-        GLfloat color_ojos_negros[] = { 0.0f, 0.0f, 0.0f };             // Color blanco de los ojos del protagonista
+        // Estado del cuadro: transformaciones y colores. Por default son la identidad y
+        // los colores originales; evaluarFase() los ajusta según el tiempo.
+        EstadoCuadro estado;
 
         // Control de tiempos
-        if (tiempoIndex < sizeof(tiempos) / sizeof(float)) {
+        if (tiempoIndex < NUM_FASES) {
             if (glfwGetTime() <= tiempos[tiempoIndex]) {                
                 // Animar. Usaremos puras transformaciones.                
-                switch (tiempoIndex) {
-                case 0:                    
-                    // ### Inicio
-                    // Tiempo: 2 segundos
-                    
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));                    
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // El tringulo protagonista va a estar fuera de la escena
-                    transform_protag = glm::translate(transform_protag, glm::vec3(1.0f, 0.0f, 0.0f));                    
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
-                    break;
-                case 1:
-                    // ### Tringulo entra en escena
-                    // Tiempo: 1 segundos
-                    
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // Tringulo protagonista                            
-                    // El tringulo protagonista va a empezar en 1.0 y queremos que llegue a 0
-                    transform_protag = glm::translate(transform_protag, glm::vec3(1 - glfwGetTime(), 0.0f, 0.0f));                    
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
-                    break;
-                case 2:                   
-                    // ### Tringulo se para un momento
-                    // Tiempo: 1.5 segundos
-                     
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    break;
-                case 3:          
-                    // ### Tringulo se mueve hacia la trselacin y choca.
-                    // Tiempo: 1.5 segundos
-                    
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // Tringulo protagonista                                        
-                    // 0.25\sin\left(\pi\left(\frac{4}{3}x + 0.5\right)\right) - 0.25
-                    aux = 0.25 * sin(pi * (((float)4 / (float)3) * glfwGetTime() + 0.5)) - 0.25;
-                    transform_protag = glm::translate(transform_protag, glm::vec3(aux, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
-                    break;
-                case 4:
-                    // ### Tringulo se para un momento
-                    // Tiempo: 0.5 segundos
-                    
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                                        
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    break;
-                case 5: 
-                    // ### Tringulo choca varias veces ms.
-                    // Tiempo: 2 segundos
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // Tringulo protagonista                                        
-                    // y\ =\ 0.25\sin\left(\pi\left(3x+\frac{1}{2}\right)\right)-0.25
-                    aux = 0.25 * sin(pi * (3 * glfwGetTime() + 0.5)) - 0.25;
-                    transform_protag = glm::translate(transform_protag, glm::vec3(aux, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    //Cambiamos los colores de los triangulos
-                    if (glfwGetTime() < .67) {
-                        color_cero_protag[0] = 1.0f; color_cero_protag[1] = 0.2f; color_cero_protag[2] = 0.2f;
-                        color_uno_protag[0] = 1.0f; color_uno_protag[1] = 0.2f; color_uno_protag[2] = 0.2f;
-                    }
-                    else if (glfwGetTime() < 1.33) {
-                        color_cero_protag[0] = 0.0f; color_cero_protag[1] = 0.5f; color_cero_protag[2] = 0.3f;
-                        color_uno_protag[0] = 0.0f; color_uno_protag[1] = 0.5f; color_uno_protag[2] = 0.3f;
-                    }
-                    else {
-                        color_cero_protag[0] = 0.2f; color_cero_protag[1] = 0.2f; color_cero_protag[2] = 1.0f;
-                        color_uno_protag[0] = 0.2f; color_uno_protag[1] = 0.2f; color_uno_protag[2] = 1.0f;
-                    }
-
-                    break;
-                case 6:                   
-                    // ### Tringulo rota hasta quedar paralelo al suelo
-                    // Tiempo: 0.5 segundos
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    rotAux = (float)1 / (float)5 * pi * (float)glfwGetTime();
-                    transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    break;                    
-                case 7:
-                    // ### Tringulo se cae
-                    // Tiempo: 0.5 segundos
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    transform_protag = glm::translate(transform_protag, glm::vec3(0.0f, -2 * (float)glfwGetTime(), 0.0f));
-                    rotAux = (float)1 / (float)10 * pi;
-                    transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
-                    break;                    
-                case 8:
-                    // Tringulo cado se cambia de color
-                    // Tiempo: 4 segundos
-                    
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    
-                    transform_protag = glm::translate(transform_protag, glm::vec3(0.0f, -1.0f, 0.0f));
-                    rotAux = (float)1 / (float)10 * pi;
-                    transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // Cambiamos los colores aleatoriamente
-                    if (glfwGetTime() < 3) {
-                        color_cero_protag[0] = (float)rand() / (float)(RAND_MAX / 1);
-                        color_cero_protag[1] = (float)rand() / (float)(RAND_MAX / 1);
-                        color_cero_protag[2] = (float)rand() / (float)(RAND_MAX / 1);
-                        color_uno_protag[0] = (float)rand() / (float)(RAND_MAX / 1);
-                        color_uno_protag[1] = (float)rand() / (float)(RAND_MAX / 1);
-                        color_uno_protag[2] = (float)rand() / (float)(RAND_MAX / 1);
-                    }
-                    //Hasta que llegamos al que encaja con la teselacin
-                    else {
-                        color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
-                        color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
-                    }
-                    break;
-                case 9: 
-                    // Nuevo tringulo sube
-                    // Tiempo: 2 segundos
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    transform_protag = glm::translate(transform_protag, glm::vec3(0.0f, 0.5 * (float)glfwGetTime() - 1, 0.0f));
-                    rotAux = (float)1 / (float)10 * pi;
-                    transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // Cambiamos los colores
-                    color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
-                    color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
-                    break;
-                case 10:
-                    // ### Tringulo rota hasta quedar como estaba antes
-                    // Tiempo: 2 segundos
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // y=-\frac{\pi}{20}x+\frac{\pi}{10}
-                    rotAux = - 0.05 * pi * (float)glfwGetTime() + pi / (float)10;
-                    transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    // Cambiamos los colores
-                    color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
-                    color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
-                    break;
-                case 11:
-                    // ### Tringulo nuevo se para un momento
-                    // Tiempo: 1 segundo
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    // Cambiamos los colores
-                    color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
-                    color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
-
-                    break;
-                case 12:
-                    // ### Tringulo nuevo se incorpora a la teselacin
-                    // Tiempo: 2 segundos
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    transform_protag = glm::translate(transform_protag, glm::vec3(-0.25*(float)glfwGetTime(), 0.0f, 0.0f));
-                    scaleAmount = 0.5f;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));                    
-                    // Cambiamos los colores
-                    color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
-                    color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
-
-                    break;
-                case 13:
-                    // ### La teselacin completa se hace grande
-                    // Tiempo:  segundos
-
-                    // Teselacin principal
-                    transform = glm::translate(transform, glm::vec3(-0.5f, 0.0f, 0.0f));                    
-                    transform_protag = glm::translate(transform_protag, glm::vec3(-0.5f, 0.0f, 0.0f));
-
-                    rotAux = 0.5 * (float)glfwGetTime();
-                    transform_protag = glm::rotate(transform_protag, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
-                    transform = glm::rotate(transform, rotAux, glm::vec3(0.0f, 0.0f, 1.0f));
-
-                    scaleAmount = 0.5*(float)glfwGetTime() + 0.5;
-                    transform_protag = glm::scale(transform_protag, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-                    transform = glm::scale(transform, glm::vec3(scaleAmount, scaleAmount, scaleAmount));
-
-                    // Cambiamos los colores
-                    color_cero_protag[0] = 0.043f; color_cero_protag[1] = 0.145f; color_cero_protag[2] = 0.271f;
-                    color_uno_protag[0] = 0.698f; color_uno_protag[1] = 0.761f; color_uno_protag[2] = 0.929f;
-                    break;
-                default:
-                    std::cout << "ndice de tiempo invlido" << std::endl;
-                    glfwTerminate();
-                    break;
-                }
+                evaluarFase(tiempoIndex, glfwGetTime(), estado);
             }
             else {
                 glfwSetTime(0.0f);
@@ -737,58 +849,55 @@ int main()
         glClearColor(0.871f, 0.878f, 0.95f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Ahora s, propiamente, dibujamos los tringulos tipo cero de la teselacin principal
+        // Ahora sí, propiamente, dibujamos. Las transformaciones y los colores de todas
+        // las clases se mandan de una vez; los 10 sectores de la teselación (el último es
+        // el protagonista) salen en una sola llamada con instancias y los ojos en otra.
+        glm::mat4 transforms[2];
+        float colores[NUM_CLASES][3];
+        estado.transformaciones(transforms);
+        estado.tablaColores(colores);
         ourShader.use();
-        unsigned int transformLoc = glGetUniformLocation(ourShader.ID, "transform");
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));       // Le pasamos al shader la transformacin que queremos.
-        
-        unsigned int color1Loc = glGetUniformLocation(ourShader.ID, "ourColor");
-        glUniform3fv(color1Loc, 1, color1);        
-        glBindVertexArray(VAOs[0]);
-        glDrawArrays(GL_TRIANGLES, 0, vert_ceros.size());
-
-        // Anlogamente, dibujamos los tringulos tipo uno de la teselacin principal                
-        unsigned int color2Loc = glGetUniformLocation(ourShader.ID, "ourColor");
-        glUniform3fv(color2Loc, 1, color2);     
-        glBindVertexArray(VAOs[1]);
-        glDrawArrays(GL_TRIANGLES, 0, vert_unos.size());
-
-        // Cambiamos de transformacin
-        unsigned int transf_protag_loc = glGetUniformLocation(ourShader.ID, "transform");
-        glUniformMatrix4fv(transf_protag_loc, 1, GL_FALSE, glm::value_ptr(transform_protag));
-
-        // Dibujamos los tringulos tipo cero del tringulo protagonista                
-        unsigned int color_cero_protag_loc = glGetUniformLocation(ourShader.ID, "ourColor");
-        glUniform3fv(color_cero_protag_loc, 1, color_cero_protag);        
-        glBindVertexArray(VAOs[2]);
-        glDrawArrays(GL_TRIANGLES, 0, vert_ceros_protag.size());
-
-        // Dibujamos los tringulos tipo uno del tringulo protagonista                
-        unsigned int color_uno_protag_loc = glGetUniformLocation(ourShader.ID, "ourColor");
-        glUniform3fv(color_uno_protag_loc, 1, color_uno_protag);
-        glBindVertexArray(VAOs[3]);
-        glDrawArrays(GL_TRIANGLES, 0, vert_unos_protag.size());
-
-        if (tiempoIndex != 13 && tiempoIndex != 7 && tiempoIndex != 8) {
-            // Dibujamos los crculos blancos                
-            unsigned int color_blanco_loc = glGetUniformLocation(ourShader.ID, "ourColor");
-            glUniform3fv(color_blanco_loc, 1, color_ojos_blancos);
-            glBindVertexArray(VAOs[4]);
-            glDrawElements(GL_TRIANGLES, 9 * TRI_POR_CIRC * listaCirc.size() / 2, GL_UNSIGNED_INT, 0);
-
-            // Dibujamos los tringulos tipo uno del tringulo protagonista                
-            unsigned int color_negro_loc = glGetUniformLocation(ourShader.ID, "ourColor");
-            glUniform3fv(color_negro_loc, 1, color_ojos_negros);
-            glBindVertexArray(VAOs[5]);
-            glDrawElements(GL_TRIANGLES, 9 * TRI_POR_CIRC * listaCirc.size() / 2, GL_UNSIGNED_INT, 0);
-        }                        
+        ourShader.set(transformLoc, transforms, 2);
+        ourShader.set(coloresLoc, colores, NUM_CLASES);
+        if (refinado) {
+            refinarCuadro(transforms);
+            subirRefinados(mallaRefinada, refinador.vertices().data(), refinador.vertices().size(), 3 * presupuesto);
+            ourShader4.use();
+            ourShader4.set(coloresRefinadoLoc, colores, NUM_CLASES);
+            mallaRefinada.dibujar();
+            ourShader.use();
+        }
+        else if (memoizado) {
+            // Cada prototipo se dibuja una vez por sector, con una instancia por triángulo
+            // grueso; el sector 0 (el protagonista) al final.
+            ourShader3.use();
+            ourShader3.set(transformMemoLoc, transforms, 2);
+            ourShader3.set(coloresMemoLoc, colores, NUM_CLASES);
+            for (int j = 1; j <= NUM_SECTORES; j++) {
+                ourShader3.set(matSectorLoc, matSectores[j % NUM_SECTORES]);
+                ourShader3.set(sectorLoc, j % NUM_SECTORES);
+                for (int c = 0; c < 2; c++)
+                    mallasMemo[c].dibujarRango(0, mallasMemo[c].numIndices, mallasMemo[c].numInstancias);
+            }
+            ourShader.use();
+        }
+        else {
+            ourShader.set(primerSectorLoc, 1);
+            mallaEmpacada.dibujarRango(0, (GLsizei)numIndTeselacion, NUM_SECTORES);
+        }
+
+        if (faseDibujaOjos(tiempoIndex)) {
+            // Los ojos ya tienen clases del protagonista; sólo necesitan la matriz identidad
+            // del sector 0.
+            ourShader.set(primerSectorLoc, 0);
+            mallaOjos.dibujar();
+        }
 
-        if (tiempoIndex >= 6 && tiempoIndex <= 8) {
+        if (faseDibujaFoco(tiempoIndex)) {
             // Render foco
             glBindTexture(GL_TEXTURE_2D, texture);
             ourShader2.use();
-            glBindVertexArray(VAOs[6]);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            mallaFoco.dibujar();
         }        
 
         // glfw: swap buffers
@@ -798,8 +907,15 @@ int main()
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    glDeleteVertexArrays(4, VAOs);
-    glDeleteBuffers(4, VBOs);
+    destruirMalla(mallaEmpacada);
+    destruirMalla(mallaOjos);
+    if (memoizado) {
+        destruirMalla(mallasMemo[0]);
+        destruirMalla(mallasMemo[1]);
+    }
+    if (refinado)
+        destruirMalla(mallaRefinada);
+    destruirMalla(mallaFoco);
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -813,6 +929,24 @@ void processInput(GLFWwindow* window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+
+    if (explorando) {
+        // Cada cuadro las flechas mueven la cámara un centésimo de la pantalla y Q / E la
+        // acercan o alejan un 2%.
+        double paso = 0.02 / escalaExplorador;
+        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+            desplazamientoX -= paso;
+        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+            desplazamientoX += paso;
+        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+            desplazamientoY -= paso;
+        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+            desplazamientoY += paso;
+        if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
+            factorZoom = min(factorZoom * 1.02, ESCALA_MAXIMA / ESCALA_MINIMA);
+        if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
+            factorZoom = max(factorZoom / 1.02, ESCALA_MINIMA / ESCALA_MAXIMA);
+    }
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
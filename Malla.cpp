@@ -0,0 +1,379 @@
+/*
+* Mallas de OpenGL y auditoría de llamadas de dibujo.
+*/
+#include "Malla.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+Malla crearMalla(const char* nombre, const float* vertices, size_t numFloats, initializer_list<int> atributos,
+    const unsigned int* indices, size_t numIndices) {
+    int floatsPorVertice = 0;
+    for (int a : atributos)
+        floatsPorVertice += a;
+
+    Malla malla;
+    malla.nombre = nombre;
+    malla.numVertices = (GLsizei)(numFloats / floatsPorVertice);
+    malla.numIndices = indices ? (GLsizei)numIndices : 0;
+
+    glGenVertexArrays(1, &malla.vao);
+    glGenBuffers(1, &malla.vbo);
+    glBindVertexArray(malla.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, malla.vbo);
+    glBufferData(GL_ARRAY_BUFFER, numFloats * sizeof(float), vertices, GL_STATIC_DRAW);
+    if (indices) {
+        glGenBuffers(1, &malla.ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, malla.ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    }
+
+    GLuint location = 0;
+    size_t desplazamiento = 0;
+    for (int a : atributos) {
+        glVertexAttribPointer(location, a, GL_FLOAT, GL_FALSE, floatsPorVertice * sizeof(float), (void*)desplazamiento);
+        glEnableVertexAttribArray(location);
+        location++;
+        desplazamiento += a * sizeof(float);
+    }
+    glBindVertexArray(0);
+    return malla;
+}
+
+Malla crearMallaEmpacada(const char* nombre, const VerticeEmpacado* vertices, size_t numVertices,
+    const uint32_t* indices, size_t numIndices) {
+    Malla malla;
+    malla.nombre = nombre;
+    malla.numVertices = (GLsizei)numVertices;
+    malla.numIndices = indices ? (GLsizei)numIndices : 0;
+
+    glGenVertexArrays(1, &malla.vao);
+    glGenBuffers(1, &malla.vbo);
+    glBindVertexArray(malla.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, malla.vbo);
+    glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(VerticeEmpacado), vertices, GL_STATIC_DRAW);
+    if (indices) {
+        glGenBuffers(1, &malla.ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, malla.ebo);
+        if (numVertices <= 0x10000) {
+            vector<uint16_t> cortos(indices, indices + numIndices);
+            malla.tipoIndice = GL_UNSIGNED_SHORT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(uint16_t), cortos.data(), GL_STATIC_DRAW);
+        }
+        else {
+            malla.tipoIndice = GL_UNSIGNED_INT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+        }
+    }
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, sizeof(VerticeEmpacado), (void*)offsetof(VerticeEmpacado, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, sizeof(VerticeEmpacado), (void*)offsetof(VerticeEmpacado, clase));
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(VerticeEmpacado), (void*)offsetof(VerticeEmpacado, borde));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    return malla;
+}
+
+Malla crearMallaMemoizada(const char* nombre, const Prototipo& prototipo, const vector<InstanciaTriangulo>& instancias) {
+    Malla malla = crearMallaEmpacada(nombre, prototipo.vertices.data(), prototipo.vertices.size(),
+        prototipo.indices.data(), prototipo.indices.size());
+    malla.numInstancias = (GLsizei)instancias.size();
+
+    glBindVertexArray(malla.vao);
+    glGenBuffers(1, &malla.vboInstancias);
+    glBindBuffer(GL_ARRAY_BUFFER, malla.vboInstancias);
+    glBufferData(GL_ARRAY_BUFFER, instancias.size() * sizeof(InstanciaTriangulo), instancias.data(), GL_STATIC_DRAW);
+    for (GLuint k = 0; k < 3; k++) {
+        glVertexAttribPointer(3 + k, 2, GL_SHORT, GL_FALSE, sizeof(InstanciaTriangulo),
+            (void*)(offsetof(InstanciaTriangulo, esquinas) + k * 2 * sizeof(int16_t)));
+        glEnableVertexAttribArray(3 + k);
+        glVertexAttribDivisor(3 + k, 1);
+    }
+    glVertexAttribIPointer(6, 3, GL_UNSIGNED_BYTE, sizeof(InstanciaTriangulo), (void*)offsetof(InstanciaTriangulo, bordes));
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+    glBindVertexArray(0);
+    return malla;
+}
+
+Malla crearMallaRefinada(const char* nombre, size_t capacidad) {
+    Malla malla;
+    malla.nombre = nombre;
+    glGenVertexArrays(1, &malla.vao);
+    glGenBuffers(1, &malla.vbo);
+    glBindVertexArray(malla.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, malla.vbo);
+    glBufferData(GL_ARRAY_BUFFER, capacidad * sizeof(VerticeRefinado), nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(VerticeRefinado), (void*)offsetof(VerticeRefinado, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, sizeof(VerticeRefinado), (void*)offsetof(VerticeRefinado, clase));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    return malla;
+}
+
+void subirRefinados(Malla& malla, const VerticeRefinado* vertices, size_t numVertices, size_t capacidad) {
+    numVertices = min(numVertices, capacidad);
+    glBindBuffer(GL_ARRAY_BUFFER, malla.vbo);
+    glBufferData(GL_ARRAY_BUFFER, capacidad * sizeof(VerticeRefinado), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, numVertices * sizeof(VerticeRefinado), vertices);
+    malla.numVertices = (GLsizei)numVertices;
+}
+
+void destruirMalla(Malla& malla) {
+    glDeleteVertexArrays(1, &malla.vao);
+    glDeleteBuffers(1, &malla.vbo);
+    if (malla.ebo)
+        glDeleteBuffers(1, &malla.ebo);
+    if (malla.vboInstancias)
+        glDeleteBuffers(1, &malla.vboInstancias);
+    malla.vao = malla.vbo = malla.ebo = malla.vboInstancias = 0;
+    malla.numVertices = malla.numIndices = malla.numInstancias = 0;
+}
+
+CasillasPedazos crearCasillasPedazos(size_t verticesPorCasilla) {
+    CasillasPedazos casillas;
+    casillas.verticesPorCasilla = verticesPorCasilla;
+    return casillas;
+}
+
+int subirPedazo(CasillasPedazos& casillas, const VerticeRefinado* vertices, size_t numVertices) {
+    if (casillas.libres.empty()) {
+        int primera = (int)casillas.bloques.size() * CASILLAS_POR_BLOQUE;
+        casillas.bloques.push_back(crearMallaRefinada("pedazos", CASILLAS_POR_BLOQUE * casillas.verticesPorCasilla));
+        casillas.cuentas.resize(casillas.cuentas.size() + CASILLAS_POR_BLOQUE, 0);
+        // Al revés, para que se den en orden.
+        for (int c = primera + CASILLAS_POR_BLOQUE - 1; c >= primera; c--)
+            casillas.libres.push_back(c);
+    }
+    int casilla = casillas.libres.back();
+    casillas.libres.pop_back();
+    numVertices = min(numVertices, casillas.verticesPorCasilla);
+
+    const Malla& bloque = casillas.bloques[casilla / CASILLAS_POR_BLOQUE];
+    GLintptr desplazamiento = (GLintptr)((casilla % CASILLAS_POR_BLOQUE) * casillas.verticesPorCasilla * sizeof(VerticeRefinado));
+    GLsizeiptr bytes = (GLsizeiptr)(numVertices * sizeof(VerticeRefinado));
+    glBindBuffer(GL_ARRAY_BUFFER, bloque.vbo);
+    bool copiado = false;
+    if (bytes > 0) {
+        void* destino = glMapBufferRange(GL_ARRAY_BUFFER, desplazamiento, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (destino) {
+            memcpy(destino, vertices, (size_t)bytes);
+            copiado = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+        }
+        // Si no se pudo mapear, o el contenido se perdió al desmapear, se sube normal.
+        if (!copiado)
+            glBufferSubData(GL_ARRAY_BUFFER, desplazamiento, bytes, vertices);
+    }
+    casillas.cuentas[casilla] = (GLsizei)numVertices;
+    return casilla;
+}
+
+void dibujarPedazo(const CasillasPedazos& casillas, int casilla) {
+    const Malla& bloque = casillas.bloques[casilla / CASILLAS_POR_BLOQUE];
+    bloque.dibujarRango((GLint)((casilla % CASILLAS_POR_BLOQUE) * casillas.verticesPorCasilla), casillas.cuentas[casilla]);
+}
+
+void soltarPedazo(CasillasPedazos& casillas, int casilla) {
+    casillas.cuentas[casilla] = 0;
+    casillas.soltadasCuadro.push_back(casilla);
+}
+
+void terminarCuadroPedazos(CasillasPedazos& casillas) {
+    if (!casillas.soltadasCuadro.empty()) {
+        CasillasPedazos::Soltadas s;
+        s.cerco = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        s.casillas.swap(casillas.soltadasCuadro);
+        casillas.enVuelo.push_back(s);
+    }
+    size_t pasaron = 0;
+    for (; pasaron < casillas.enVuelo.size(); pasaron++) {
+        CasillasPedazos::Soltadas& s = casillas.enVuelo[pasaron];
+        GLenum estado = glClientWaitSync(s.cerco, 0, 0);
+        if (estado != GL_ALREADY_SIGNALED && estado != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(s.cerco);
+        casillas.libres.insert(casillas.libres.end(), s.casillas.begin(), s.casillas.end());
+    }
+    casillas.enVuelo.erase(casillas.enVuelo.begin(), casillas.enVuelo.begin() + pasaron);
+}
+
+void destruirCasillasPedazos(CasillasPedazos& casillas) {
+    for (CasillasPedazos::Soltadas& s : casillas.enVuelo)
+        glDeleteSync(s.cerco);
+    for (Malla& m : casillas.bloques)
+        destruirMalla(m);
+    casillas = CasillasPedazos();
+}
+
+void Malla::dibujar() const {
+    glBindVertexArray(vao);
+    if (numIndices > 0)
+        dibujarElementos(nombre, GL_TRIANGLES, numIndices, tipoIndice, 0);
+    else
+        dibujarArreglos(nombre, GL_TRIANGLES, 0, numVertices);
+}
+
+void Malla::dibujarRango(GLint primero, GLsizei cuenta, GLsizei instancias) const {
+    glBindVertexArray(vao);
+    if (numIndices > 0) {
+        size_t tamIndice = tipoIndice == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        dibujarElementos(nombre, GL_TRIANGLES, cuenta, tipoIndice, primero * tamIndice, instancias);
+    }
+    else {
+        dibujarArreglos(nombre, GL_TRIANGLES, primero, cuenta, instancias);
+    }
+}
+
+static void emitirArreglos(GLenum modo, GLint primero, GLsizei cuenta, GLsizei instancias) {
+    if (instancias == 1)
+        glDrawArrays(modo, primero, cuenta);
+    else
+        glDrawArraysInstanced(modo, primero, cuenta, instancias);
+}
+
+static void emitirElementos(GLenum modo, GLsizei cuenta, GLenum tipo, size_t desplazamiento, GLsizei instancias) {
+    if (instancias == 1)
+        glDrawElements(modo, cuenta, tipo, (void*)desplazamiento);
+    else
+        glDrawElementsInstanced(modo, cuenta, tipo, (void*)desplazamiento, instancias);
+}
+
+#if AUDITAR_DIBUJO
+
+static size_t tamanoTipo(GLenum tipo) {
+    switch (tipo) {
+    case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+    case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: return 2;
+    case GL_DOUBLE: return 8;
+    default: return 4;
+    }
+}
+
+static GLint64 tamanoBuffer(GLuint buffer) {
+    // Se liga a GL_COPY_READ_BUFFER para no tocar GL_ARRAY_BUFFER ni el VAO.
+    GLint anterior;
+    glGetIntegerv(GL_COPY_READ_BUFFER, &anterior);    // Mismo valor que GL_COPY_READ_BUFFER_BINDING
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    GLint64 tam = 0;
+    glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &tam);
+    glBindBuffer(GL_COPY_READ_BUFFER, anterior);
+    return tam;
+}
+
+// Cada problema se reporta una sola vez por nombre; si no, una llamada mala en el ciclo
+// de render llenaría la consola en cada cuadro.
+static void reportar(const char* nombre, const string& mensaje) {
+    static set<string> reportados;
+    if (reportados.insert(string(nombre) + mensaje).second)
+        cerr << "[auditoria] " << nombre << ": " << mensaje << endl;
+}
+
+// Revisa que los vértices primero .. ultimo de cada atributo habilitado por vértice, y
+// las instancias 0 .. instancias - 1 de cada atributo por instancia, estén dentro de su
+// buffer.
+static void auditarVertices(const char* nombre, GLint primero, GLint64 ultimo, GLsizei instancias) {
+    GLint vao = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+    if (vao == 0) {
+        reportar(nombre, "no hay VAO ligado");
+        return;
+    }
+    if (primero < 0)
+        reportar(nombre, "primer vértice negativo");
+
+    GLint maxAtributos = 0;
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAtributos);
+    for (GLint i = 0; i < maxAtributos; i++) {
+        GLint habilitado = 0;
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &habilitado);
+        if (!habilitado)
+            continue;
+        GLint buffer = 0, componentes = 0, tipo = 0, stride = 0, divisor = 0;
+        void* puntero = nullptr;
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &componentes);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &tipo);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+        glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &puntero);
+        glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+        if (buffer == 0) {
+            reportar(nombre, "el atributo " + to_string(i) + " no tiene buffer");
+            continue;
+        }
+        GLint64 bytesAtributo = (GLint64)componentes * tamanoTipo(tipo);
+        GLint64 paso = stride ? stride : bytesAtributo;
+        GLint64 ultimoAtributo = divisor ? (instancias - 1) / divisor : ultimo;
+        GLint64 necesarios = (GLint64)(size_t)puntero + ultimoAtributo * paso + bytesAtributo;
+        GLint64 disponibles = tamanoBuffer(buffer);
+        if (necesarios > disponibles) {
+            reportar(nombre, "el atributo " + to_string(i) + " lee hasta el byte " + to_string(necesarios) +
+                " de un buffer de " + to_string(disponibles) + " (" + to_string(disponibles / paso) +
+                (divisor ? " instancias" : " vértices") + ", se pidió hasta el " + to_string(ultimoAtributo) + ")");
+        }
+    }
+}
+
+void dibujarArreglos(const char* nombre, GLenum modo, GLint primero, GLsizei cuenta, GLsizei instancias) {
+    if (cuenta > 0)
+        auditarVertices(nombre, primero, (GLint64)primero + cuenta - 1, instancias);
+    emitirArreglos(modo, primero, cuenta, instancias);
+}
+
+void dibujarElementos(const char* nombre, GLenum modo, GLsizei cuenta, GLenum tipo, size_t desplazamiento,
+    GLsizei instancias) {
+    GLint ebo = 0;
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &ebo);
+    if (ebo == 0) {
+        reportar(nombre, "glDrawElements sin EBO ligado");
+    }
+    else if (cuenta > 0) {
+        GLint64 tamIndice = (GLint64)tamanoTipo(tipo);
+        GLint64 disponibles = tamanoBuffer(ebo);
+        GLint64 necesarios = (GLint64)desplazamiento + cuenta * tamIndice;
+        if (necesarios > disponibles) {
+            reportar(nombre, "se piden " + to_string(cuenta) + " índices pero el EBO sólo tiene " +
+                to_string((disponibles - (GLint64)desplazamiento) / tamIndice));
+            cuenta = (GLsizei)max<GLint64>(0, (disponibles - (GLint64)desplazamiento) / tamIndice);
+        }
+
+        // Se leen los índices para saber hasta qué vértice llega la llamada.
+        vector<unsigned char> datos((size_t)(cuenta * tamIndice));
+        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, desplazamiento, datos.size(), datos.data());
+        GLint64 mayor = -1;
+        for (GLsizei k = 0; k < cuenta; k++) {
+            GLint64 indice;
+            if (tipo == GL_UNSIGNED_BYTE)
+                indice = datos[k];
+            else if (tipo == GL_UNSIGNED_SHORT)
+                indice = ((const unsigned short*)datos.data())[k];
+            else
+                indice = ((const unsigned int*)datos.data())[k];
+            mayor = max(mayor, indice);
+        }
+        if (mayor >= 0)
+            auditarVertices(nombre, 0, mayor, instancias);
+    }
+    emitirElementos(modo, cuenta, tipo, desplazamiento, instancias);
+}
+
+#else
+
+void dibujarArreglos(const char*, GLenum modo, GLint primero, GLsizei cuenta, GLsizei instancias) {
+    emitirArreglos(modo, primero, cuenta, instancias);
+}
+
+void dibujarElementos(const char*, GLenum modo, GLsizei cuenta, GLenum tipo, size_t desplazamiento,
+    GLsizei instancias) {
+    emitirElementos(modo, cuenta, tipo, desplazamiento, instancias);
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+* Mallas de OpenGL. Cada malla guarda su VAO, sus buffers y cuántos vértices e índices
+* se subieron, para que las llamadas de dibujo tomen el número de elementos de ahí y no
+* de cuentas hechas a mano.
+*/
+#ifndef MALLA_H
+#define MALLA_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "Instancias.h"
+#include "Vertice.h"
+
+// La auditoría de llamadas de dibujo está activa en la configuración Debug. También se
+// puede activar en Release definiendo AUDITAR_DIBUJO=1.
+#if !defined(AUDITAR_DIBUJO) && defined(_DEBUG)
+#define AUDITAR_DIBUJO 1
+#endif
+
+struct Malla {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;             // 0 si la malla no usa índices
+    GLsizei numVertices = 0;    // Vértices en el VBO (no floats)
+    GLsizei numIndices = 0;     // Índices en el EBO
+    GLuint vboInstancias = 0;   // 0 si la malla no tiene atributos por instancia
+    GLsizei numInstancias = 0;
+    GLenum tipoIndice = GL_UNSIGNED_INT;
+    const char* nombre = "";    // Para los mensajes de la auditoría
+
+    // glDrawElements si la malla tiene índices, glDrawArrays si no. Dibuja la malla
+    // completa con lo que tenga ligado el programa activo.
+    void dibujar() const;
+    // Dibuja sólo los elementos primero .. primero + cuenta - 1: índices si la malla
+    // tiene, vértices si no. Con más de una instancia usa las versiones Instanced.
+    void dibujarRango(GLint primero, GLsizei cuenta, GLsizei instancias = 1) const;
+};
+
+// Crea el VAO y sube los vértices (y los índices, si hay). 'atributos' es cuántos
+// floats tiene cada atributo, en el orden de sus location; por ejemplo {3} para sólo
+// posición o {3, 3, 2} para posición, color y coordenadas de textura.
+Malla crearMalla(const char* nombre, const float* vertices, size_t numFloats, std::initializer_list<int> atributos,
+    const unsigned int* indices = nullptr, size_t numIndices = 0);
+// Malla de vértices empacados (Vertice.h): location 0 es la posición (dos GL_SHORT sin
+// normalizar; el shader divide entre ESCALA_VERTICE), location 1 la clase de color y
+// location 2 el borde de sector, los dos como enteros. Si se dan índices y todos los vértices caben en 16 bits, el EBO se sube
+// con GL_UNSIGNED_SHORT para usar la mitad de memoria.
+Malla crearMallaEmpacada(const char* nombre, const VerticeEmpacado* vertices, size_t numVertices,
+    const uint32_t* indices = nullptr, size_t numIndices = 0);
+// Malla de un prototipo de la teselación memoizada (Instancias.h): los vértices del
+// prototipo como en crearMallaEmpacada (location 2 es el TipoVerticePrototipo) y un
+// buffer por instancia con las esquinas de los triángulos gruesos en las location 3, 4
+// y 5 y sus bordes de sector en la 6. Se dibuja con dibujarRango(0, numIndices,
+// numInstancias).
+Malla crearMallaMemoizada(const char* nombre, const Prototipo& prototipo, const std::vector<InstanciaTriangulo>& instancias);
+// Malla de la teselación refinada según la vista (VerticeRefinado, Vertice.h): location 0
+// es la posición en float y location 1 la clase como entero. No tiene índices; el VBO se
+// crea vacío con lugar para 'capacidad' vértices y cada cuadro se llena con
+// subirRefinados().
+Malla crearMallaRefinada(const char* nombre, size_t capacidad);
+// Reemplaza los vértices de una malla de crearMallaRefinada(). Primero se suelta el
+// almacenamiento anterior con glBufferData(nullptr) para que el driver no tenga que
+// esperar a que termine el cuadro que todavía lo usa.
+void subirRefinados(Malla& malla, const VerticeRefinado* vertices, size_t numVertices, size_t capacidad);
+void destruirMalla(Malla& malla);
+
+// Vértices de los pedazos del explorador (Explorador.h) en la GPU, subidos sin que el
+// cuadro espere al driver. En lugar de un VBO por pedazo, que cuesta un glBufferData (una
+// reserva nueva) por cada pedazo que aparece, los pedazos van en casillas de tamaño fijo
+// de unos pocos VBO grandes (bloques de CASILLAS_POR_BLOQUE) que se crean una sola vez.
+// Cada subida mapea sólo el rango de su casilla con GL_MAP_UNSYNCHRONIZED_BIT, así que
+// el driver ni reserva ni sincroniza: copia y regresa. Eso sólo es válido si la GPU ya
+// no lee la casilla, así que una casilla soltada no se vuelve a dar hasta que pasa el
+// cerco (glFenceSync) del cuadro en que se soltó.
+//
+// Con mapeo persistente (glBufferStorage) los hilos del explorador podrían copiar
+// directamente a la GPU, pero es de OpenGL 4.4 y el contexto es 3.3; aquí la copia se
+// hace en el hilo de render, que es un memcpy de pocos KB por pedazo.
+const int CASILLAS_POR_BLOQUE = 256;
+
+struct CasillasPedazos {
+    size_t verticesPorCasilla = 0;
+    std::vector<Malla> bloques;
+    std::vector<GLsizei> cuentas;       // Vértices de cada casilla
+    std::vector<int> libres;
+    std::vector<int> soltadasCuadro;    // Soltadas en el cuadro actual
+    struct Soltadas {
+        GLsync cerco;
+        std::vector<int> casillas;
+    };
+    std::vector<Soltadas> enVuelo;      // De la más vieja a la más nueva
+};
+
+CasillasPedazos crearCasillasPedazos(size_t verticesPorCasilla);
+// Copia los vértices de un pedazo (a lo más verticesPorCasilla) a una casilla libre,
+// creando otro bloque si hace falta, y regresa su número.
+int subirPedazo(CasillasPedazos& casillas, const VerticeRefinado* vertices, size_t numVertices);
+void dibujarPedazo(const CasillasPedazos& casillas, int casilla);
+// La casilla se podrá reutilizar cuando la GPU termine el cuadro actual.
+void soltarPedazo(CasillasPedazos& casillas, int casilla);
+// Va al final de cada cuadro, después de dibujar: pone el cerco de las casillas
+// soltadas en él y libera las de los cuadros cuyo cerco ya pasó, sin esperar.
+void terminarCuadroPedazos(CasillasPedazos& casillas);
+void destruirCasillasPedazos(CasillasPedazos& casillas);
+
+// Envolturas de glDrawArrays y glDrawElements. Con AUDITAR_DIBUJO, antes de dibujar
+// revisan contra el VAO ligado que ningún atributo habilitado se lea más allá del final
+// de su buffer (por vértice o por instancia, según su divisor) y que los índices quepan
+// en el EBO; si algo se sale, lo reportan por
+// std::cerr (una vez por nombre) en lugar de dejar que el driver lea basura.
+void dibujarArreglos(const char* nombre, GLenum modo, GLint primero, GLsizei cuenta, GLsizei instancias = 1);
+void dibujarElementos(const char* nombre, GLenum modo, GLsizei cuenta, GLenum tipo, size_t desplazamiento,
+    GLsizei instancias = 1);
+
+#endif
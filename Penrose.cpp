@@ -0,0 +1,369 @@
+/*
+* Motor de subdivisión de la teselación de Penrose.
+*/
+#include "Penrose.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "VectoresSimd.h"
+
+using namespace std;
+
+template <class V>
+static inline typename V::T puntoAureo(typename V::T origen, typename V::T hacia) {
+    return V::sumar(origen, V::entrePhi(V::restar(hacia, origen)));
+}
+
+// Triángulos tipo cero: P = A + (B - A) / phi
+//   hijo cero: (C, P, B)
+//   hijo uno:  (P, C, A)
+template <class V>
+static size_t kernelCeros(const BloqueSoAT<typename V::Elem>& p, size_t inicio, size_t fin,
+    const BloqueSoAT<typename V::Elem>& h0, const BloqueSoAT<typename V::Elem>& h1) {
+    typedef typename V::T T;
+    size_t i = inicio;
+    for (; i + V::ancho <= fin; i += V::ancho) {
+        T ax = V::cargar(p.ax + i), ay = V::cargar(p.ay + i);
+        T bx = V::cargar(p.bx + i), by = V::cargar(p.by + i);
+        T cx = V::cargar(p.cx + i), cy = V::cargar(p.cy + i);
+        T px = puntoAureo<V>(ax, bx), py = puntoAureo<V>(ay, by);
+
+        V::guardar(h0.ax + i, cx); V::guardar(h0.ay + i, cy);
+        V::guardar(h0.bx + i, px); V::guardar(h0.by + i, py);
+        V::guardar(h0.cx + i, bx); V::guardar(h0.cy + i, by);
+
+        V::guardar(h1.ax + i, px); V::guardar(h1.ay + i, py);
+        V::guardar(h1.bx + i, cx); V::guardar(h1.by + i, cy);
+        V::guardar(h1.cx + i, ax); V::guardar(h1.cy + i, ay);
+    }
+    return i;
+}
+
+// Triángulos tipo uno: Q = B + (A - B) / phi, R = B + (C - B) / phi
+//   hijo cero:         (R, Q, A)
+//   primer hijo uno:   (R, C, A)
+//   segundo hijo uno:  (Q, R, B)
+template <class V>
+static size_t kernelUnos(const BloqueSoAT<typename V::Elem>& p, size_t inicio, size_t fin,
+    const BloqueSoAT<typename V::Elem>& h0, const BloqueSoAT<typename V::Elem>& h1, const BloqueSoAT<typename V::Elem>& h2) {
+    typedef typename V::T T;
+    size_t i = inicio;
+    for (; i + V::ancho <= fin; i += V::ancho) {
+        T ax = V::cargar(p.ax + i), ay = V::cargar(p.ay + i);
+        T bx = V::cargar(p.bx + i), by = V::cargar(p.by + i);
+        T cx = V::cargar(p.cx + i), cy = V::cargar(p.cy + i);
+        T qx = puntoAureo<V>(bx, ax), qy = puntoAureo<V>(by, ay);
+        T rx = puntoAureo<V>(bx, cx), ry = puntoAureo<V>(by, cy);
+
+        V::guardar(h0.ax + i, rx); V::guardar(h0.ay + i, ry);
+        V::guardar(h0.bx + i, qx); V::guardar(h0.by + i, qy);
+        V::guardar(h0.cx + i, ax); V::guardar(h0.cy + i, ay);
+
+        V::guardar(h1.ax + i, rx); V::guardar(h1.ay + i, ry);
+        V::guardar(h1.bx + i, cx); V::guardar(h1.by + i, cy);
+        V::guardar(h1.cx + i, ax); V::guardar(h1.cy + i, ay);
+
+        V::guardar(h2.ax + i, qx); V::guardar(h2.ay + i, qy);
+        V::guardar(h2.bx + i, rx); V::guardar(h2.by + i, ry);
+        V::guardar(h2.cx + i, bx); V::guardar(h2.cy + i, by);
+    }
+    return i;
+}
+
+template <typename S>
+void subdividir(const GeneracionT<S>& origen, GeneracionT<S>& destino) {
+    typedef typename VecDe<S>::Simd Simd;
+    typedef VecEscalar<S> Esc;
+    const size_t z = origen.numCeros;
+    const size_t u = origen.numUnos;
+
+    BloqueSoAT<S> ceroDeCero = destino.ceros;
+    BloqueSoAT<S> unoDeCero = destino.unos;
+    BloqueSoAT<S> ceroDeUno = destino.ceros.desde(z);
+    BloqueSoAT<S> unoDeUno1 = destino.unos.desde(z);
+    BloqueSoAT<S> unoDeUno2 = destino.unos.desde(z + u);
+
+    // El kernel vectorial avanza mientras quepan registros completos y lo que sobra
+    // se termina con la versión escalar.
+    size_t i = kernelCeros<Simd>(origen.ceros, 0, z, ceroDeCero, unoDeCero);
+    kernelCeros<Esc>(origen.ceros, i, z, ceroDeCero, unoDeCero);
+    i = kernelUnos<Simd>(origen.unos, 0, u, ceroDeUno, unoDeUno1, unoDeUno2);
+    kernelUnos<Esc>(origen.unos, i, u, ceroDeUno, unoDeUno1, unoDeUno2);
+
+    destino.numCeros = z + u;
+    destino.numUnos = z + 2 * u;
+}
+
+// Tamaño mínimo de un pedazo de trabajo. Debajo de esto no vale la pena despertar a
+// los hilos.
+static const size_t TAM_PEDAZO = 16384;
+
+template <typename S>
+void subdividirParalelo(const GeneracionT<S>& origen, GeneracionT<S>& destino, PoolHilos& hilos) {
+    typedef typename VecDe<S>::Simd Simd;
+    typedef VecEscalar<S> Esc;
+    const size_t z = origen.numCeros;
+    const size_t u = origen.numUnos;
+    if (hilos.tamano() == 1 || z + u < 2 * TAM_PEDAZO) {
+        subdividir(origen, destino);
+        return;
+    }
+
+    BloqueSoAT<S> ceroDeCero = destino.ceros;
+    BloqueSoAT<S> unoDeCero = destino.unos;
+    BloqueSoAT<S> ceroDeUno = destino.ceros.desde(z);
+    BloqueSoAT<S> unoDeUno1 = destino.unos.desde(z);
+    BloqueSoAT<S> unoDeUno2 = destino.unos.desde(z + u);
+
+    // Unas cuantas tareas por hilo para balancear la carga. Los límites se redondean a
+    // múltiplos de 8 para que cada pedazo use registros completos salvo el último.
+    size_t numPedazos = 4 * (size_t)hilos.tamano();
+    size_t pedazoCeros = (z + numPedazos - 1) / numPedazos;
+    size_t pedazoUnos = (u + numPedazos - 1) / numPedazos;
+    pedazoCeros = (max(pedazoCeros, (size_t)1) + 7) & ~(size_t)7;
+    pedazoUnos = (max(pedazoUnos, (size_t)1) + 7) & ~(size_t)7;
+
+    hilos.paraCada(numPedazos, [&](size_t k) {
+        size_t inicio = min(k * pedazoCeros, z);
+        size_t fin = min(inicio + pedazoCeros, z);
+        size_t i = kernelCeros<Simd>(origen.ceros, inicio, fin, ceroDeCero, unoDeCero);
+        kernelCeros<Esc>(origen.ceros, i, fin, ceroDeCero, unoDeCero);
+
+        inicio = min(k * pedazoUnos, u);
+        fin = min(inicio + pedazoUnos, u);
+        i = kernelUnos<Simd>(origen.unos, inicio, fin, ceroDeUno, unoDeUno1, unoDeUno2);
+        kernelUnos<Esc>(origen.unos, i, fin, ceroDeUno, unoDeUno1, unoDeUno2);
+    });
+
+    destino.numCeros = z + u;
+    destino.numUnos = z + 2 * u;
+}
+
+triangulo trianguloDeRueda(int j) {
+    triangulo t;
+    t.color = 0;
+    t.A = complex<double>(0, 0);
+    t.B = polar(1.0, ((2 * j - 1) * pi) / 10.0);
+    t.C = polar(1.0, ((2 * j + 1) * pi) / 10.0);
+    if (j % 2 == 0) {
+        complex<double> aux = t.B;
+        t.B = t.C;
+        t.C = aux;
+    }
+    return t;
+}
+
+static inline complex<double> puntoAureo(const complex<double>& origen, const complex<double>& hacia) {
+    return complex<double>(puntoAureo<VecEscalar<double> >(origen.real(), hacia.real()),
+        puntoAureo<VecEscalar<double> >(origen.imag(), hacia.imag()));
+}
+
+int hijosDe(const triangulo& t, triangulo hijos[3]) {
+    if (t.color == 0) {
+        complex<double> P = puntoAureo(t.A, t.B);
+        triangulo h0 = { 0, t.C, P, t.B };
+        triangulo h1 = { 1, P, t.C, t.A };
+        hijos[0] = h0;
+        hijos[1] = h1;
+        return 2;
+    }
+    complex<double> Q = puntoAureo(t.B, t.A);
+    complex<double> R = puntoAureo(t.B, t.C);
+    triangulo h0 = { 0, R, Q, t.A };
+    triangulo h1 = { 1, R, t.C, t.A };
+    triangulo h2 = { 1, Q, R, t.B };
+    hijos[0] = h0;
+    hijos[1] = h1;
+    hijos[2] = h2;
+    return 3;
+}
+
+void matrizSector(int j, double m[4]) {
+    double c = cos(j * pi / 5.0);
+    double s = sin(j * pi / 5.0);
+    if (j % 2 == 0) {
+        m[0] = c; m[1] = -s;
+        m[2] = s; m[3] = c;
+    }
+    else {
+        // Primero se refleja (x, y) -> (x, -y) y luego se rota.
+        m[0] = c; m[1] = s;
+        m[2] = s; m[3] = -c;
+    }
+}
+
+int bordeDeSector(double x, double y, double tolerancia) {
+    if (x * x + y * y <= tolerancia * tolerancia)
+        return SIN_BORDE;
+    double c = cos(pi / 10.0);
+    double s = sin(pi / 10.0);
+    // Distancia a cada recta; los dos rayos están del lado x > 0.
+    if (x > 0 && fabs(x * s + y * c) <= tolerancia)
+        return BORDE_INFERIOR;
+    if (x > 0 && fabs(x * s - y * c) <= tolerancia)
+        return BORDE_SUPERIOR;
+    return SIN_BORDE;
+}
+
+int rayoDeBorde(int j, int borde) {
+    // El sector 0 tiene el borde inferior en el rayo -1 y el superior en el 0. Al rotar
+    // j * pi / 5 se recorren j rayos; la reflexión de los sectores impares los
+    // intercambia.
+    bool inferior = (borde == BORDE_INFERIOR) != (j % 2 == 1);
+    int k = inferior ? j - 1 : j;
+    return (k + NUM_SECTORES) % NUM_SECTORES;
+}
+
+void direccionDeRayo(int k, float& dx, float& dy) {
+    float angulo = (float)(2 * k + 1) * 3.14159265f / 10.0f;
+    dx = cos(angulo);
+    dy = sin(angulo);
+}
+
+Censo censoTriangulos(uint64_t ceros, uint64_t unos, int profundidad, const uint64_t hijos[2][2]) {
+    assert(profundidad >= 0);
+    // r = m^profundidad, con m = hijos por renglones {a, b, c, d}.
+    uint64_t r[4] = { 1, 0, 0, 1 };
+    uint64_t m[4] = { hijos[0][0], hijos[0][1], hijos[1][0], hijos[1][1] };
+    for (int n = profundidad; n > 0; n >>= 1) {
+        if (n & 1) {
+            uint64_t t[4] = { r[0] * m[0] + r[1] * m[2], r[0] * m[1] + r[1] * m[3],
+                r[2] * m[0] + r[3] * m[2], r[2] * m[1] + r[3] * m[3] };
+            memcpy(r, t, sizeof(t));
+        }
+        if (n > 1) {
+            uint64_t t[4] = { m[0] * m[0] + m[1] * m[2], m[0] * m[1] + m[1] * m[3],
+                m[2] * m[0] + m[3] * m[2], m[2] * m[1] + m[3] * m[3] };
+            memcpy(m, t, sizeof(t));
+        }
+    }
+    // (ceros, unos) multiplica por la izquierda: los de tipo t son ceros * r(0, t) + unos * r(1, t).
+    Censo c = { ceros * r[0] + unos * r[2], ceros * r[1] + unos * r[3] };
+    return c;
+}
+
+void capacidadesDeArena(size_t cerosIniciales, size_t unosIniciales, int generaciones, size_t capCeros[2],
+    size_t capUnos[2], const uint64_t hijos[2][2]) {
+    // La generación k vive en el buffer k % 2, así que a cada buffer le toca el tamaño
+    // de la generación más grande que va a guardar: la última y la penúltima.
+    Censo ultima = censoTriangulos(cerosIniciales, unosIniciales, generaciones, hijos);
+    capCeros[generaciones % 2] = (size_t)ultima.ceros;
+    capUnos[generaciones % 2] = (size_t)ultima.unos;
+    if (generaciones > 0) {
+        Censo penultima = censoTriangulos(cerosIniciales, unosIniciales, generaciones - 1, hijos);
+        capCeros[(generaciones - 1) % 2] = (size_t)penultima.ceros;
+        capUnos[(generaciones - 1) % 2] = (size_t)penultima.unos;
+    }
+    else {
+        capCeros[1] = capUnos[1] = 0;
+    }
+}
+
+const char* kernelSubdivision() {
+#if defined(PENROSE_AVX)
+    return "AVX";
+#elif defined(PENROSE_SSE2)
+    return "SSE2";
+#else
+    return "escalar";
+#endif
+}
+
+// ------------------------------------------------------------------------------------
+// Memoria alineada a 32 bytes para que los arreglos empiecen en frontera de registro.
+static void* reservarAlineado(size_t bytes) {
+    if (bytes == 0)
+        return nullptr;
+#if defined(PENROSE_AVX) || defined(PENROSE_SSE2)
+    return _mm_malloc(bytes, 32);
+#else
+    return malloc(bytes);
+#endif
+}
+
+static void liberarAlineado(void* p) {
+#if defined(PENROSE_AVX) || defined(PENROSE_SSE2)
+    _mm_free(p);
+#else
+    free(p);
+#endif
+}
+
+// Redondea hacia arriba a múltiplo de 8 para que cada arreglo quede alineado a 32 bytes
+// aun con coordenadas de 4 bytes.
+static size_t redondear(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+// Reparte un pedazo de buffer en los seis arreglos de un bloque.
+template <typename S>
+static BloqueSoAT<S> repartir(S* base, size_t cap) {
+    BloqueSoAT<S> b = { base, base + cap, base + 2 * cap, base + 3 * cap, base + 4 * cap, base + 5 * cap };
+    return b;
+}
+
+template <typename S>
+ArenaTriangulosT<S>::ArenaTriangulosT(size_t cerosIniciales, size_t unosIniciales, int generaciones,
+    const KernelSustitucionT<S>* reglas)
+    : gen(0), maxGeneraciones(generaciones), reglas(reglas) {
+    // Cada buffer se parte en la zona de ceros y la zona de unos.
+    capacidadesDeArena(cerosIniciales, unosIniciales, generaciones, capCeros, capUnos,
+        reglas ? reglas->hijos : HIJOS_ROBINSON);
+    for (int b = 0; b < 2; b++) {
+        capCeros[b] = redondear(capCeros[b]);
+        capUnos[b] = redondear(capUnos[b]);
+        buffers[b] = (S*)reservarAlineado(6 * (capCeros[b] + capUnos[b]) * sizeof(S));
+        gens[b].ceros = repartir(buffers[b], capCeros[b]);
+        gens[b].unos = repartir(buffers[b] + 6 * capCeros[b], capUnos[b]);
+        gens[b].numCeros = gens[b].numUnos = 0;
+    }
+}
+
+template <typename S>
+ArenaTriangulosT<S>::~ArenaTriangulosT() {
+    liberarAlineado(buffers[0]);
+    liberarAlineado(buffers[1]);
+}
+
+template <typename S>
+void ArenaTriangulosT<S>::agregar(const triangulo& t) {
+    assert(gen == 0);
+    GeneracionT<S>& g = gens[0];
+    if (t.color == 0) {
+        assert(g.numCeros < capCeros[0]);
+        g.ceros.poner(g.numCeros++, t);
+    }
+    else {
+        assert(g.numUnos < capUnos[0]);
+        g.unos.poner(g.numUnos++, t);
+    }
+}
+
+template <typename S>
+void ArenaTriangulosT<S>::subdividir(PoolHilos* hilos) {
+    assert(gen < maxGeneraciones);
+    const GeneracionT<S>& origen = gens[gen % 2];
+    gen++;
+    if (reglas && hilos != nullptr)
+        reglas->paralelo(origen, gens[gen % 2], *hilos);
+    else if (reglas)
+        reglas->serie(origen, gens[gen % 2]);
+    else if (hilos != nullptr)
+        subdividirParalelo(origen, gens[gen % 2], *hilos);
+    else
+        ::subdividir(origen, gens[gen % 2]);
+}
+
+// Instancias para los tres tipos de coordenada.
+template void subdividir<double>(const GeneracionT<double>&, GeneracionT<double>&);
+template void subdividir<float>(const GeneracionT<float>&, GeneracionT<float>&);
+template void subdividir<Fijo32>(const GeneracionT<Fijo32>&, GeneracionT<Fijo32>&);
+template void subdividirParalelo<double>(const GeneracionT<double>&, GeneracionT<double>&, PoolHilos&);
+template void subdividirParalelo<float>(const GeneracionT<float>&, GeneracionT<float>&, PoolHilos&);
+template void subdividirParalelo<Fijo32>(const GeneracionT<Fijo32>&, GeneracionT<Fijo32>&, PoolHilos&);
+template class ArenaTriangulosT<double>;
+template class ArenaTriangulosT<float>;
+template class ArenaTriangulosT<Fijo32>;
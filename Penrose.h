@@ -0,0 +1,257 @@
+/*
+* Motor de subdivisión de la teselación de Penrose.
+* Referencias: https://preshing.com/20110831/penrose-tiling-explained/
+*/
+#ifndef PENROSE_H
+#define PENROSE_H
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hilos.h"
+
+const double goldenRatio = (1 + std::sqrt(5.0)) / 2;
+const double pi = 3.1415926535897932384626433832795028841971;
+
+// Estructura que guarda la información de un triángulo suelto (por ejemplo, los de
+// la semilla). Para generaciones completas se usa BloqueSoA.
+struct triangulo {
+    int color;
+    std::complex<double> A;
+    std::complex<double> B;
+    std::complex<double> C;
+};
+
+// Triángulo j (0 a 9) de la rueda inicial: diez triángulos tipo cero alrededor del
+// origen, con los vértices B y C del círculo unitario alternados para que los
+// triángulos vecinos queden como espejo.
+triangulo trianguloDeRueda(int j);
+
+// Hijos de un triángulo con las mismas reglas y el mismo orden que subdividir(), para
+// quien subdivide un triángulo a la vez (Generador.h, Refinamiento.h). Regresa cuántos
+// son (2 o 3).
+int hijosDe(const triangulo& t, triangulo hijos[3]);
+
+// La rueda tiene simetría de orden 10: el triángulo j es el triángulo 0 reflejado sobre
+// el eje x (si j es impar) y rotado j * pi / 5. Como la subdivisión sólo hace
+// combinaciones afines de los vértices, sus subdivisiones guardan la misma relación
+// (triángulo por triángulo, en el mismo orden), así que basta con subdividir el sector 0
+// y dibujar los demás como copias transformadas.
+const int NUM_SECTORES = 10;
+
+// Matriz 2x2 por renglones {a, b, c, d} que lleva el sector 0 al sector j:
+// (x, y) -> (a x + b y, c x + d y).
+void matrizSector(int j, double m[4]);
+
+// Los vértices que caen en los bordes rectos del sector los comparte con el sector
+// vecino. Si cada sector los transformara con su propia matriz, el redondeo dejaría
+// grietas entre sectores; por eso esos vértices se marcan y se colocan sobre el rayo de
+// la rueda que les toca (direccionDeRayo), que es el mismo cálculo para los dos sectores.
+enum BordeSector {
+    SIN_BORDE = 0,
+    BORDE_INFERIOR,     // Rayo de ángulo -pi / 10 del sector 0
+    BORDE_SUPERIOR      // Rayo de ángulo pi / 10 del sector 0
+};
+
+// Borde del sector 0 en el que cae (x, y), a menos de 'tolerancia'. El origen es común a
+// todos los sectores y no cuenta como borde (cualquier matriz lo deja en su lugar).
+int bordeDeSector(double x, double y, double tolerancia);
+// Rayo k de la rueda (el de ángulo (2k + 1) pi / 10) en el que queda el borde dado del
+// sector j.
+int rayoDeBorde(int j, int borde);
+// Dirección unitaria del rayo k, en float para que el rasterizador haga la misma cuenta
+// que proyecto1.vs.
+void direccionDeRayo(int k, float& dx, float& dy);
+
+// ------------------------------------------------------------------------------------
+// Tipo de las coordenadas. La subdivisión está escrita una sola vez como plantilla y se
+// instancia para double (la referencia), float (la mitad de memoria y el doble de
+// triángulos por registro vectorial) y punto fijo de 32 bits.
+
+// Punto fijo con BITS fraccionarios: alcanza para |x| < 2, y todos los vértices y
+// diferencias entre vértices de la teselación (en el círculo unitario) caben.
+struct Fijo32 {
+    static const int BITS = 30;
+    int32_t v;
+};
+
+// Conversiones entre el tipo de coordenada y double, y tamaño de celda con el que
+// SoldadorVertices debe soldar los vértices de ese tipo: unas cuantas veces el error que
+// acumula la subdivisión a las profundidades que se dibujan.
+template <typename S> struct Escalar;
+
+template <> struct Escalar<double> {
+    static double aDouble(double x) { return x; }
+    static double deDouble(double x) { return x; }
+    static const char* nombre() { return "double"; }
+    static double celdaSoldadura() { return 1e-7; }
+};
+
+template <> struct Escalar<float> {
+    static double aDouble(float x) { return x; }
+    static float deDouble(double x) { return (float)x; }
+    static const char* nombre() { return "float"; }
+    static double celdaSoldadura() { return 1e-5; }
+};
+
+template <> struct Escalar<Fijo32> {
+    static double aDouble(Fijo32 x) { return std::ldexp((double)x.v, -Fijo32::BITS); }
+    static Fijo32 deDouble(double x) {
+        Fijo32 f = { (int32_t)std::llround(std::ldexp(x, Fijo32::BITS)) };
+        return f;
+    }
+    static const char* nombre() { return "fijo32"; }
+    static double celdaSoldadura() { return 1e-7; }
+};
+
+// Triángulos de un mismo color guardados como estructura de arreglos: un arreglo por
+// cada coordenada de cada vértice. Así el kernel de subdivisión lee y escribe memoria
+// contigua y puede procesar varios triángulos por instrucción.
+template <typename S>
+struct BloqueSoAT {
+    S* ax;
+    S* ay;
+    S* bx;
+    S* by;
+    S* cx;
+    S* cy;
+
+    // Vista del mismo bloque recorrida 'k' triángulos.
+    BloqueSoAT desde(size_t k) const {
+        BloqueSoAT b = { ax + k, ay + k, bx + k, by + k, cx + k, cy + k };
+        return b;
+    }
+    triangulo obtener(size_t i, int color) const {
+        typedef Escalar<S> E;
+        triangulo t;
+        t.color = color;
+        t.A = std::complex<double>(E::aDouble(ax[i]), E::aDouble(ay[i]));
+        t.B = std::complex<double>(E::aDouble(bx[i]), E::aDouble(by[i]));
+        t.C = std::complex<double>(E::aDouble(cx[i]), E::aDouble(cy[i]));
+        return t;
+    }
+    void poner(size_t i, const triangulo& t) {
+        typedef Escalar<S> E;
+        ax[i] = E::deDouble(t.A.real()); ay[i] = E::deDouble(t.A.imag());
+        bx[i] = E::deDouble(t.B.real()); by[i] = E::deDouble(t.B.imag());
+        cx[i] = E::deDouble(t.C.real()); cy[i] = E::deDouble(t.C.imag());
+    }
+};
+
+// Una generación de la teselación, partida por color.
+template <typename S>
+struct GeneracionT {
+    BloqueSoAT<S> ceros;
+    BloqueSoAT<S> unos;
+    size_t numCeros;
+    size_t numUnos;
+};
+
+typedef BloqueSoAT<double> BloqueSoA;
+typedef GeneracionT<double> Generacion;
+
+// Censo de una generación: cada triángulo tipo cero deja un cero y un uno y cada tipo uno
+// deja un cero y dos unos, así que (ceros, unos) después de n subdivisiones es
+// [[1, 1], [1, 2]]^n (ceros, unos) y las entradas de la potencia son números de
+// Fibonacci. Se calcula por cuadrados repetidos en O(log n) y sin generar nada, para
+// dimensionar de antemano arenas, buffers y archivos. Con una semilla de la rueda los
+// conteos caben en 64 bits hasta PROFUNDIDAD_MAXIMA_CENSO.
+const int PROFUNDIDAD_MAXIMA_CENSO = 44;
+
+// Matriz de sustitución: hijos[p][t] es cuántos hijos de tipo t deja un triángulo de
+// tipo p. Ésta es la de las reglas de subdividir(); las de otras teselaciones salen de
+// sus reglas (Sustitucion.h).
+const uint64_t HIJOS_ROBINSON[2][2] = { { 1, 1 }, { 1, 2 } };
+
+struct Censo {
+    uint64_t ceros;
+    uint64_t unos;
+
+    uint64_t total() const { return ceros + unos; }
+};
+
+Censo censoTriangulos(uint64_t ceros, uint64_t unos, int profundidad, const uint64_t hijos[2][2] = HIJOS_ROBINSON);
+
+// Capacidad de cada uno de los dos buffers de una arena (ver ArenaTriangulosT) que
+// empieza con esa semilla y se subdivide 'generaciones' veces.
+void capacidadesDeArena(size_t cerosIniciales, size_t unosIniciales, int generaciones, size_t capCeros[2],
+    size_t capUnos[2], const uint64_t hijos[2][2] = HIJOS_ROBINSON);
+
+// Método para subdividir una generación completa. 'destino' debe tener espacio para
+// origen.numCeros + origen.numUnos ceros y origen.numCeros + 2 * origen.numUnos unos.
+// Los hijos quedan en bloques contiguos según el tipo de padre:
+//   ceros: [hijos cero de padres cero | hijos cero de padres uno]
+//   unos:  [hijos uno de padres cero | primer hijo uno de padres uno | segundo hijo uno de padres uno]
+// Internamente usa AVX o SSE2 si el compilador los tiene habilitados (el punto fijo va
+// en escalar). Está instanciada para double, float y Fijo32.
+template <typename S>
+void subdividir(const GeneracionT<S>& origen, GeneracionT<S>& destino);
+
+// Igual que subdividir(), pero repartiendo los padres en pedazos entre los hilos del
+// grupo. Como en cada bloque de hijos el hijo del padre i va en la posición i, cada
+// pedazo sabe de antemano dónde escribir y el resultado es idéntico bit a bit al de la
+// versión serial.
+template <typename S>
+void subdividirParalelo(const GeneracionT<S>& origen, GeneracionT<S>& destino, PoolHilos& hilos);
+
+// Nombre del conjunto de instrucciones con el que se compiló el kernel.
+const char* kernelSubdivision();
+
+// Kernel de subdivisión de otras reglas de sustitución con los mismos tipos de triángulo
+// (ver Sustitucion.h), para usarlo en una arena en lugar de subdividir().
+template <typename S>
+struct KernelSustitucionT {
+    uint64_t hijos[2][2];       // Matriz de sustitución, para el tamaño de los buffers
+    void (*serie)(const GeneracionT<S>& origen, GeneracionT<S>& destino);
+    void (*paralelo)(const GeneracionT<S>& origen, GeneracionT<S>& destino, PoolHilos& hilos);
+};
+
+// Arena de triángulos para subdividir varias generaciones sin pedir memoria en cada
+// paso. Como cada triángulo tipo cero produce un cero y un uno, y cada triángulo tipo
+// uno produce un cero y dos unos, sabemos desde el principio cuántos triángulos va a
+// tener cada generación. Con eso reservamos dos buffers (uno para la generación actual
+// y otro para la siguiente) que se van alternando, así que sin importar la profundidad
+// sólo se hacen dos reservaciones de memoria y todo se libera en el destructor.
+template <typename S>
+class ArenaTriangulosT {
+public:
+    // Recibe cuántos triángulos de cada color tendrá la semilla y cuántas veces se va a
+    // subdividir, para poder calcular el tamaño de los buffers. Sin 'reglas' se
+    // subdivide con subdividir(); el kernel tiene que vivir lo mismo que la arena.
+    ArenaTriangulosT(size_t cerosIniciales, size_t unosIniciales, int generaciones,
+        const KernelSustitucionT<S>* reglas = nullptr);
+    ~ArenaTriangulosT();
+
+    ArenaTriangulosT(const ArenaTriangulosT&) = delete;
+    ArenaTriangulosT& operator=(const ArenaTriangulosT&) = delete;
+
+    // Agrega un triángulo a la semilla (generación cero).
+    void agregar(const triangulo& t);
+    // Sustituye la generación actual por su subdivisión. Si se le pasa un grupo de
+    // hilos y la generación es grande, la subdivisión se hace en paralelo.
+    void subdividir(PoolHilos* hilos = nullptr);
+
+    const GeneracionT<S>& actual() const { return gens[gen % 2]; }
+    size_t size() const { return numCeros() + numUnos(); }
+    size_t numCeros() const { return actual().numCeros; }
+    size_t numUnos() const { return actual().numUnos; }
+    int generacion() const { return gen; }
+    // Memoria de los dos buffers, en bytes.
+    size_t bytesReservados() const { return 6 * sizeof(S) * (capCeros[0] + capUnos[0] + capCeros[1] + capUnos[1]); }
+
+private:
+    S* buffers[2];
+    GeneracionT<S> gens[2];
+    size_t capCeros[2];
+    size_t capUnos[2];
+    int gen;
+    int maxGeneraciones;
+    const KernelSustitucionT<S>* reglas;
+};
+
+typedef ArenaTriangulosT<double> ArenaTriangulos;
+
+#endif
@@ -0,0 +1,212 @@
+/*
+* Generación directa por el método de la pentarrejilla.
+*/
+#include "Pentarrejilla.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Generador.h"
+
+using namespace std;
+
+// Direcciones e_j de las cinco familias de rectas.
+static const double COS_FAMILIA[5] = { 1, cos(2 * pi / 5), cos(4 * pi / 5), cos(6 * pi / 5), cos(8 * pi / 5) };
+static const double SIN_FAMILIA[5] = { 0, sin(2 * pi / 5), sin(4 * pi / 5), sin(6 * pi / 5), sin(8 * pi / 5) };
+
+// Como sum_j (x . e_j) e_j = 5 x / 2, el rombo de un cruce x queda en 5 x / 2 +
+// sum_j gamma_j e_j más una combinación de las e_j con coeficientes entre 0 y 1, que
+// mide a lo más phi. Las celdas buscan cruces con este margen de sobra, en lados de
+// rombo.
+static const double MARGEN_CRUCES = 2;
+// Cota de la distancia del centro de un rombo a sus vértices. La exacta es la mitad de
+// la diagonal larga del rombo delgado, cos(pi / 10) = 0.951; se usa 1 para que el
+// redondeo no deje fuera un rombo que apenas toca la región, a cambio de unas celdas
+// más en el borde.
+static const double RADIO_ROMBO = 1;
+// Área promedio de un rombo de lado 1: hay phi gruesos (sen 72) por cada delgado
+// (sen 36).
+static const double AREA_ROMBO = (goldenRatio * sin(2 * pi / 5) + sin(pi / 5)) / (goldenRatio + 1);
+
+GeneradorPentarrejilla::GeneradorPentarrejilla(const RegionPlano& r, double lado) : lado(lado) {
+    region.x0 = min(r.x0, r.x1);
+    region.x1 = max(r.x0, r.x1);
+    region.y0 = min(r.y0, r.y1);
+    region.y1 = max(r.y0, r.y1);
+    // Los rombos que tocan la región tienen el centro a menos de RADIO_ROMBO de ella.
+    celdaX0 = (int64_t)floor((region.x0 / lado - RADIO_ROMBO) / CELDA_PENTARREJILLA);
+    celdaY0 = (int64_t)floor((region.y0 / lado - RADIO_ROMBO) / CELDA_PENTARREJILLA);
+    celdasX = (int64_t)floor((region.x1 / lado + RADIO_ROMBO) / CELDA_PENTARREJILLA) - celdaX0 + 1;
+    celdasY = (int64_t)floor((region.y1 / lado + RADIO_ROMBO) / CELDA_PENTARREJILLA) - celdaY0 + 1;
+}
+
+size_t GeneradorPentarrejilla::estimarTriangulos() const {
+    double ancho = (region.x1 - region.x0) / lado + 2 * RADIO_ROMBO;
+    double alto = (region.y1 - region.y0) / lado + 2 * RADIO_ROMBO;
+    return (size_t)(2 * ancho * alto / AREA_ROMBO) + 16;
+}
+
+// Los vértices que comparten dos rombos salen de los mismos índices, así que con la
+// misma cuenta quedan exactamente en el mismo punto y no se abren grietas.
+void GeneradorPentarrejilla::puntoDeIndices(const int64_t K[5], complex<double>& v) const {
+    double x = 0, y = 0;
+    for (int j = 0; j < 5; j++) {
+        x += (double)K[j] * COS_FAMILIA[j];
+        y += (double)K[j] * SIN_FAMILIA[j];
+    }
+    v = complex<double>(x * lado, y * lado);
+}
+
+bool GeneradorPentarrejilla::tocaRegion(const triangulo& t) const {
+    double xMin = min(t.A.real(), min(t.B.real(), t.C.real())), xMax = max(t.A.real(), max(t.B.real(), t.C.real()));
+    double yMin = min(t.A.imag(), min(t.B.imag(), t.C.imag())), yMax = max(t.A.imag(), max(t.B.imag(), t.C.imag()));
+    return xMin <= region.x1 && xMax >= region.x0 && yMin <= region.y1 && yMax >= region.y0;
+}
+
+void GeneradorPentarrejilla::generarCelda(size_t i, vector<triangulo>& salida) const {
+    const double* gamma = DESPLAZAMIENTOS_PENTARREJILLA;
+    const int64_t cx = celdaX0 + (int64_t)(i % (size_t)celdasX), cy = celdaY0 + (int64_t)(i / (size_t)celdasX);
+
+    // Caja de la celda en la pentarrejilla, donde pueden estar los cruces de sus rombos.
+    double gx = 0, gy = 0;
+    for (int j = 0; j < 5; j++) {
+        gx += gamma[j] * COS_FAMILIA[j];
+        gy += gamma[j] * SIN_FAMILIA[j];
+    }
+    const double caja[4] = {
+        ((double)cx * CELDA_PENTARREJILLA - gx - MARGEN_CRUCES) / 2.5,
+        ((double)cy * CELDA_PENTARREJILLA - gy - MARGEN_CRUCES) / 2.5,
+        ((double)(cx + 1) * CELDA_PENTARREJILLA - gx + MARGEN_CRUCES) / 2.5,
+        ((double)(cy + 1) * CELDA_PENTARREJILLA - gy + MARGEN_CRUCES) / 2.5
+    };
+
+    for (int r = 0; r < 5; r++) {
+        for (int s = r + 1; s < 5; s++) {
+            // Familias a 144 grados: rombo delgado (tipo cero); a 72: grueso (tipo uno).
+            const int color = (s - r == 2 || s - r == 3) ? 0 : 1;
+
+            // Rectas de la familia r que pasan por la caja.
+            double fMin = INFINITY, fMax = -INFINITY;
+            for (int esquina = 0; esquina < 4; esquina++) {
+                double f = caja[2 * (esquina & 1)] * COS_FAMILIA[r] + caja[1 + (esquina & 2)] * SIN_FAMILIA[r];
+                fMin = min(fMin, f);
+                fMax = max(fMax, f);
+            }
+            for (int64_t kr = (int64_t)ceil(fMin + gamma[r]); kr <= (int64_t)floor(fMax + gamma[r]); kr++) {
+                // La recta es q + t u, con u perpendicular a e_r. Se recorta contra la caja.
+                const double qx = (kr - gamma[r]) * COS_FAMILIA[r], qy = (kr - gamma[r]) * SIN_FAMILIA[r];
+                const double ux = -SIN_FAMILIA[r], uy = COS_FAMILIA[r];
+                double t0 = -INFINITY, t1 = INFINITY;
+                const double q[2] = { qx, qy }, u[2] = { ux, uy };
+                for (int eje = 0; eje < 2; eje++) {
+                    double lo = caja[eje], hi = caja[2 + eje];
+                    if (fabs(u[eje]) < 1e-12) {
+                        if (q[eje] < lo || q[eje] > hi)
+                            t0 = INFINITY;
+                        continue;
+                    }
+                    double a = (lo - q[eje]) / u[eje], b = (hi - q[eje]) / u[eje];
+                    t0 = max(t0, min(a, b));
+                    t1 = min(t1, max(a, b));
+                }
+                if (t0 > t1)
+                    continue;
+
+                // Rectas de la familia s que la cruzan dentro de la caja.
+                const double qs = qx * COS_FAMILIA[s] + qy * SIN_FAMILIA[s] + gamma[s];
+                const double us = ux * COS_FAMILIA[s] + uy * SIN_FAMILIA[s];
+                const double f0 = qs + t0 * us, f1 = qs + t1 * us;
+                for (int64_t ks = (int64_t)ceil(min(f0, f1)); ks <= (int64_t)floor(max(f0, f1)); ks++) {
+                    double t = (ks - qs) / us;
+                    double px = qx + t * ux, py = qy + t * uy;
+                    int64_t K[5];
+                    for (int j = 0; j < 5; j++)
+                        K[j] = (int64_t)ceil(px * COS_FAMILIA[j] + py * SIN_FAMILIA[j] + gamma[j]);
+                    K[r] = kr;
+                    K[s] = ks;
+
+                    // El rombo es de la celda de su centro, sum_j K_j e_j + (e_r + e_s) / 2.
+                    double centroX = 0.5 * (COS_FAMILIA[r] + COS_FAMILIA[s]), centroY = 0.5 * (SIN_FAMILIA[r] + SIN_FAMILIA[s]);
+                    for (int j = 0; j < 5; j++) {
+                        centroX += (double)K[j] * COS_FAMILIA[j];
+                        centroY += (double)K[j] * SIN_FAMILIA[j];
+                    }
+                    if ((int64_t)floor(centroX / CELDA_PENTARREJILLA) != cx || (int64_t)floor(centroY / CELDA_PENTARREJILLA) != cy)
+                        continue;
+
+                    // V00 y V11 son los extremos de la diagonal BC; V10 y V01 los vértices A.
+                    complex<double> v00, v10, v01, v11;
+                    puntoDeIndices(K, v00);
+                    K[r]++;
+                    puntoDeIndices(K, v10);
+                    K[s]++;
+                    puntoDeIndices(K, v11);
+                    K[r]--;
+                    puntoDeIndices(K, v01);
+                    int64_t indice = K[0] + K[1] + K[2] + K[3] + K[4] - 1;    // Índice de V00: 1 o 2
+                    const complex<double>& B = indice == 2 ? v00 : v11;
+                    const complex<double>& C = indice == 2 ? v11 : v00;
+
+                    triangulo h0 = { color, v10, B, C };
+                    triangulo h1 = { color, v01, B, C };
+                    if (tocaRegion(h0))
+                        salida.push_back(h0);
+                    if (tocaRegion(h1))
+                        salida.push_back(h1);
+                }
+            }
+        }
+    }
+}
+
+void generarPentarrejilla(const RegionPlano& region, double lado, vector<triangulo>& salida, PoolHilos* hilos) {
+    GeneradorPentarrejilla generador(region, lado);
+    size_t n = generador.numCeldas();
+    salida.clear();
+    if (!hilos || n == 1) {
+        salida.reserve(generador.estimarTriangulos());
+        for (size_t i = 0; i < n; i++)
+            generador.generarCelda(i, salida);
+        return;
+    }
+
+    vector<vector<triangulo> > celdas(n);
+    hilos->paraCada(n, [&](size_t i) { generador.generarCelda(i, celdas[i]); });
+    size_t total = 0;
+    for (const vector<triangulo>& c : celdas)
+        total += c.size();
+    salida.reserve(total);
+    for (const vector<triangulo>& c : celdas)
+        salida.insert(salida.end(), c.begin(), c.end());
+}
+
+bool exportarRegion(const char* ruta, const RegionPlano& region, int profundidad, PoolHilos& hilos, uint64_t& escritos) {
+    escritos = 0;
+    FILE* f = fopen(ruta, "wb");
+    if (!f)
+        return false;
+
+    GeneradorPentarrejilla generador(region, pow(goldenRatio, -profundidad));
+    const size_t n = generador.numCeldas();
+    const size_t TAM_TANDA = 4 * (size_t)hilos.tamano();
+    vector<vector<triangulo> > tanda(TAM_TANDA);
+    vector<TrianguloExportado> registros;
+    bool ok = true;
+    for (size_t inicio = 0; ok && inicio < n; inicio += TAM_TANDA) {
+        size_t cuenta = min(TAM_TANDA, n - inicio);
+        hilos.paraCada(cuenta, [&](size_t k) {
+            tanda[k].clear();
+            generador.generarCelda(inicio + k, tanda[k]);
+        });
+        for (size_t k = 0; ok && k < cuenta; k++) {
+            registros.resize(tanda[k].size());
+            for (size_t i = 0; i < tanda[k].size(); i++)
+                registros[i] = TrianguloExportado::de(tanda[k][i]);
+            ok = fwrite(registros.data(), sizeof(TrianguloExportado), registros.size(), f) == registros.size();
+            if (ok)
+                escritos += registros.size();
+        }
+    }
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,89 @@
+/*
+* Generación directa de la teselación de rombos por el método de la pentarrejilla de de
+* Bruijn: en lugar de subdividir desde la rueda, se enumeran los rombos que caen en una
+* región rectangular cualquiera del plano, sin recursión y sin generar nada fuera de
+* ella.
+* Referencias: N. G. de Bruijn, "Algebraic theory of Penrose's non-periodic tilings of
+* the plane" (1981).
+*/
+#ifndef PENTARREJILLA_H
+#define PENTARREJILLA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hilos.h"
+#include "Penrose.h"
+
+// La pentarrejilla son cinco familias de rectas paralelas, x . e_j + gamma_j = k con k
+// entero y e_j = (cos 2 pi j / 5, sin 2 pi j / 5). Cada cruce de una recta de la familia
+// r con una de la familia s es un rombo, y sus vértices son sum_j K_j e_j, donde K_j es
+// la franja de la familia j en la que cae el cruce (K_j = ceil(x . e_j + gamma_j)) y
+// K_r, K_s toman los dos valores de las franjas que se juntan en él. Las familias a 72
+// grados dan rombos gruesos y las de a 144 rombos delgados. Con sum gamma_j = 0 la
+// teselación es de Penrose; los desplazamientos de aquí son genéricos (nunca se cruzan
+// tres rectas en un punto), así que no hay casos ambiguos.
+const double DESPLAZAMIENTOS_PENTARREJILLA[5] = { 0.2, 0.35, -0.1, 0.05, -0.5 };
+
+// Cada rombo sale como los dos triángulos que deja su diagonal BC, con la misma
+// convención que subdividir(): A es el vértice del ángulo de 36 grados (tipo cero, la
+// mitad de un rombo delgado) o de 108 grados (tipo uno, la mitad de un grueso), y B y C
+// son los extremos de la diagonal. Cuál es B sale del índice del vértice, sum_j K_j:
+// B tiene índice 2 o 3 y C 1 o 4. Así la vecindad de cada vértice es una de las que
+// aparecen al subdividir la rueda, y los triángulos se pueden seguir subdividiendo.
+//
+// Para repartir el trabajo, el plano se parte en celdas cuadradas de CELDA_PENTARREJILLA
+// lados de rombo, fijas respecto al origen, y cada rombo es de la celda en la que cae su
+// centro. Cada celda busca sólo los cruces de rectas cercanos a ella y no depende de
+// ninguna otra, así que las celdas se pueden generar en cualquier orden, en cualquier
+// hilo o incluso en otro proceso, y dan siempre los mismos triángulos.
+const int CELDA_PENTARREJILLA = 64;
+
+struct RegionPlano {
+    double x0;
+    double y0;
+    double x1;
+    double y1;
+};
+
+class GeneradorPentarrejilla {
+public:
+    // 'lado' es el largo de los lados de los rombos, en coordenadas del plano; con
+    // phi^-n los triángulos miden lo mismo que los de la rueda subdividida n veces. Se
+    // generan los triángulos cuya caja envolvente toca la región.
+    GeneradorPentarrejilla(const RegionPlano& region, double lado);
+
+    size_t numCeldas() const { return (size_t)celdasX * celdasY; }
+    // Agrega al final de 'salida' los triángulos de los rombos de la celda i (por
+    // renglones, de abajo hacia arriba).
+    void generarCelda(size_t i, std::vector<triangulo>& salida) const;
+    // Cota del número de triángulos de la región, para reservar memoria.
+    size_t estimarTriangulos() const;
+
+private:
+    void puntoDeIndices(const int64_t K[5], std::complex<double>& v) const;
+    bool tocaRegion(const triangulo& t) const;
+
+    RegionPlano region;
+    double lado;
+    int64_t celdaX0;    // Índices de la primera celda, contados desde el origen
+    int64_t celdaY0;
+    int64_t celdasX;
+    int64_t celdasY;
+};
+
+// Genera todos los triángulos de la región repartiendo las celdas entre los hilos. Los
+// pone en 'salida' en el orden de las celdas, así que el resultado es el mismo con
+// cualquier número de hilos.
+void generarPentarrejilla(const RegionPlano& region, double lado, std::vector<triangulo>& salida,
+    PoolHilos* hilos = nullptr);
+
+// Escribe los triángulos de la región con el formato de exportarTeselacion()
+// (Generador.h) y lados de rombo de phi^-profundidad. Genera las celdas por tandas en
+// paralelo y escribe cada tanda antes de generar la siguiente, así que la memoria no
+// crece con el tamaño de la región.
+bool exportarRegion(const char* ruta, const RegionPlano& region, int profundidad, PoolHilos& hilos,
+    uint64_t& escritos);
+
+#endif
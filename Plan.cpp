@@ -0,0 +1,112 @@
+/*
+* Planeación de memoria.
+*/
+#include "Plan.h"
+
+#include "Cache.h"
+#include "Direcciones.h"
+#include "Generador.h"
+#include "Instancias.h"
+#include "Rombos.h"
+#include "Soldadura.h"
+#include "Vertice.h"
+
+#include <cstdio>
+
+using namespace std;
+
+static uint64_t bytesIndices(uint64_t indices, uint64_t vertices) {
+    // Misma regla que crearMallaEmpacada().
+    return indices * (vertices <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+static uint64_t bytesArena(size_t ceros, size_t unos, int generaciones, size_t bytesPorPunto,
+    const uint64_t hijos[2][2] = HIJOS_ROBINSON) {
+    size_t capCeros[2], capUnos[2];
+    capacidadesDeArena(ceros, unos, generaciones, capCeros, capUnos, hijos);
+    return 3 * bytesPorPunto * (uint64_t)(capCeros[0] + capUnos[0] + capCeros[1] + capUnos[1]);
+}
+
+PlanMemoria planearMemoria(int profundidad, size_t bytesPorPunto, int profundidadPrototipo,
+    const uint64_t hijos[2][2]) {
+    PlanMemoria p;
+    p.profundidad = profundidad;
+    p.sector = censoTriangulos(1, 0, profundidad, hijos);
+    p.bytesArena = bytesArena(1, 0, profundidad, bytesPorPunto, hijos);
+
+    p.vertices = cotaVerticesSoldados(p.sector.total(), profundidad);
+    p.indices = 3 * p.sector.total();
+    p.bytesSoldador = SoldadorVertices::bytesReservados((size_t)p.vertices) + p.indices * sizeof(uint32_t);
+    p.bytesRombos = bytesJuntarRombos((size_t)p.sector.total());
+    p.rombos = p.sector.total() / 2;
+    p.bytesVbo = p.vertices * sizeof(VerticeEmpacado);
+    p.bytesEbo = bytesIndices(p.indices, p.vertices);
+    p.bytesCache = tamanoCache((size_t)p.vertices, (size_t)p.indices);
+
+    // --exportar-teselacion no usa --reglas.
+    uint64_t rueda = NUM_SECTORES * censoTriangulos(1, 0, profundidad).total();
+    p.bytesExportacion = rueda * BYTES_TRIANGULO_EXPORTADO;
+    p.bytesDirecciones = profundidad <= PROFUNDIDAD_MAXIMA_DIRECCION ?
+        rueda * (uint64_t)((bitsDeDireccion(profundidad) + 7) / 8) : 0;
+
+    p.profundidadPrototipo = 0;
+    p.verticesPrototipos = p.indicesPrototipos = p.bytesPrototipos = 0;
+    p.instancias = p.bytesInstancias = p.bytesPicoMemoizado = p.bytesGpuPrototipos = 0;
+    if (profundidadPrototipo > 0 && profundidadPrototipo <= profundidad) {
+        // Lo mismo que TeselacionMemoizada: un prototipo por color y una instancia por
+        // triángulo grueso, con las esquinas soldadas.
+        p.profundidadPrototipo = profundidadPrototipo;
+        for (int c = 0; c < 2; c++) {
+            uint64_t t = censoTriangulos(c == 0, c == 1, profundidadPrototipo).total();
+            uint64_t v = cotaVerticesSoldados(t, profundidadPrototipo);
+            p.verticesPrototipos += v;
+            p.indicesPrototipos += 3 * t;
+            p.bytesGpuPrototipos += v * sizeof(VerticeEmpacado) + bytesIndices(3 * t, v);
+        }
+        p.bytesPrototipos = p.verticesPrototipos * sizeof(VerticeEmpacado) + p.indicesPrototipos * sizeof(uint32_t);
+        int profundidadInstancias = profundidad - profundidadPrototipo;
+        p.instancias = censoTriangulos(1, 0, profundidadInstancias).total();
+        p.bytesInstancias = p.instancias * sizeof(InstanciaTriangulo);
+        uint64_t esquinas = cotaVerticesSoldados(p.instancias, profundidadInstancias);
+        p.bytesPicoMemoizado = p.bytesPrototipos + bytesArena(1, 0, profundidadInstancias, 2 * sizeof(double)) +
+            SoldadorVertices::bytesReservados((size_t)esquinas) + 3 * p.instancias * sizeof(uint32_t) + p.bytesInstancias;
+    }
+    return p;
+}
+
+static double mb(uint64_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+void imprimirPlan(const PlanMemoria& p) {
+    printf("Profundidad %d\n", p.profundidad);
+    printf("  Sector 0:             %llu triángulos (%llu ceros, %llu unos)\n", (unsigned long long)p.sector.total(),
+        (unsigned long long)p.sector.ceros, (unsigned long long)p.sector.unos);
+    printf("  Rueda completa:       %llu triángulos\n", (unsigned long long)(NUM_SECTORES * p.sector.total()));
+    if (p.profundidadPrototipo > 0) {
+        printf("  Prototipos:           %12.1f MB (profundidad %d; hasta %llu vértices, %llu índices)\n",
+            mb(p.bytesPrototipos), p.profundidadPrototipo, (unsigned long long)p.verticesPrototipos,
+            (unsigned long long)p.indicesPrototipos);
+        printf("  Instancias:           %12.1f MB (%llu triángulos gruesos de profundidad %d)\n", mb(p.bytesInstancias),
+            (unsigned long long)p.instancias, p.profundidad - p.profundidadPrototipo);
+        printf("  Pico de generación:   %12.1f MB (arena y soldadura de las instancias, con los prototipos)\n",
+            mb(p.bytesPicoMemoizado));
+        printf("  Subida a la GPU:      %12.1f MB (prototipos %.1f MB, instancias %.1f MB)\n",
+            mb(p.bytesGpuPrototipos + p.bytesInstancias), mb(p.bytesGpuPrototipos), mb(p.bytesInstancias));
+    }
+    else {
+        printf("  Arena del sector:     %12.1f MB\n", mb(p.bytesArena));
+        printf("  Soldadura:            %12.1f MB (hasta %llu vértices, %llu índices)\n", mb(p.bytesSoldador),
+            (unsigned long long)p.vertices, (unsigned long long)p.indices);
+        printf("  Pico de generación:   %12.1f MB (la arena sigue viva mientras se suelda)\n",
+            mb(p.bytesArena + p.bytesSoldador));
+        printf("  Juntar rombos:        %12.1f MB (con el soldador vivo; hasta %llu rombos)\n", mb(p.bytesRombos),
+            (unsigned long long)p.rombos);
+        printf("  Subida a la GPU:      %12.1f MB (VBO %.1f MB, EBO %.1f MB)\n", mb(p.bytesVbo + p.bytesEbo),
+            mb(p.bytesVbo), mb(p.bytesEbo));
+        printf("  Archivo de caché:     %12.1f MB\n", mb(p.bytesCache));
+    }
+    printf("  Exportar teselación:  %12.1f MB\n", mb(p.bytesExportacion));
+    if (p.bytesDirecciones)
+        printf("  Como direcciones:     %12.1f MB\n", mb(p.bytesDirecciones));
+}
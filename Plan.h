@@ -0,0 +1,54 @@
+/*
+* Planeación de memoria: lo que van a ocupar la subdivisión, la soldadura, los buffers
+* de OpenGL y los archivos de salida, calculado sólo con el censo (Penrose.h) antes de
+* generar nada.
+*/
+#ifndef PLAN_H
+#define PLAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Penrose.h"
+
+// Todos los tamaños son en bytes, salvo los conteos. Los vértices son una cota
+// (cotaVerticesSoldados); lo demás es exacto.
+struct PlanMemoria {
+    int profundidad;
+    Censo sector;                   // Triángulos del sector 0 a esa profundidad
+    uint64_t bytesArena;            // Los dos buffers de la arena del sector
+    uint64_t vertices;              // Vértices soldados del sector
+    uint64_t indices;
+    uint64_t bytesSoldador;         // Tabla hash y vértices del soldador
+    uint64_t bytesRombos;           // Trabajo de juntarRombos() (Rombos.h), ya sin la arena
+    uint64_t rombos;                // Cota de rombos del sector (la mitad de los triángulos)
+    uint64_t bytesVbo;              // Lo que se sube a la GPU: vértices empacados...
+    uint64_t bytesEbo;              // ...e índices (de 16 bits si caben)
+    uint64_t bytesCache;            // Archivo de --cache
+    uint64_t bytesExportacion;      // Archivo de --exportar-teselacion (la rueda P3 completa)
+    uint64_t bytesDirecciones;      // La rueda P3 completa como direcciones (Direcciones.h)
+
+    // Con --memoizar (profundidadPrototipo > 0) no hay arena ni soldadura del sector: se
+    // generan los dos prototipos y los triángulos gruesos, y eso es lo que se sube.
+    int profundidadPrototipo;
+    uint64_t verticesPrototipos;    // Cota de vértices de los dos prototipos
+    uint64_t indicesPrototipos;
+    uint64_t bytesPrototipos;       // Vértices e índices de los dos prototipos
+    uint64_t instancias;            // Triángulos gruesos de profundidad - profundidadPrototipo
+    uint64_t bytesInstancias;
+    uint64_t bytesPicoMemoizado;    // Arena y soldadura de las instancias, con los prototipos vivos
+    uint64_t bytesGpuPrototipos;    // VBO y EBO de los prototipos
+};
+
+// 'bytesPorPunto' es lo que ocupa un vértice en la arena: 2 * sizeof del tipo de
+// coordenada, o 16 con coordenadas exactas. 'profundidadPrototipo' es la de --memoizar
+// ya resuelta (0 si no se va a memoizar); los prototipos y las instancias siempre se
+// subdividen en double. 'hijos' es la matriz de sustitución de --reglas
+// (KernelSustitucionT); la exportación y las direcciones siempre son de P3.
+PlanMemoria planearMemoria(int profundidad, size_t bytesPorPunto, int profundidadPrototipo = 0,
+    const uint64_t hijos[2][2] = HIJOS_ROBINSON);
+
+// Reporte legible del plan (--dry-run de Main.cpp).
+void imprimirPlan(const PlanMemoria& plan);
+
+#endif
@@ -0,0 +1,210 @@
+/*
+* Escritura de imágenes PNG sin dependencias externas.
+* Referencias: RFC 1950 (zlib), RFC 1951 (deflate), especificación PNG.
+*/
+#include "Png.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Escribe bits en el orden de deflate (el primer bit va en el bit menos significativo).
+// Los códigos Huffman van empezando por su bit más significativo, así que se guardan
+// invertidos.
+struct EscritorBits {
+    vector<unsigned char>& out;
+    uint32_t acumulado;
+    int numBits;
+
+    explicit EscritorBits(vector<unsigned char>& o) : out(o), acumulado(0), numBits(0) {}
+
+    void escribir(uint32_t valor, int bits) {
+        acumulado |= valor << numBits;
+        numBits += bits;
+        while (numBits >= 8) {
+            out.push_back((unsigned char)(acumulado & 0xFF));
+            acumulado >>= 8;
+            numBits -= 8;
+        }
+    }
+    void terminar() {
+        if (numBits > 0)
+            out.push_back((unsigned char)(acumulado & 0xFF));
+        acumulado = 0;
+        numBits = 0;
+    }
+};
+
+// Invierte el orden de los primeros 'bits' bits.
+static uint32_t invertir(uint32_t codigo, int bits) {
+    uint32_t invertido = 0;
+    for (int i = 0; i < bits; i++)
+        invertido |= ((codigo >> i) & 1) << (bits - 1 - i);
+    return invertido;
+}
+
+// Códigos fijos de literal/longitud (RFC 1951, sección 3.2.6), ya invertidos para
+// escribirlos directamente.
+struct TablaFija {
+    uint32_t codigo[288];
+    int bits[288];
+    TablaFija() {
+        for (int s = 0; s < 288; s++) {
+            if (s < 144) { codigo[s] = 0x30 + s; bits[s] = 8; }
+            else if (s < 256) { codigo[s] = 0x190 + s - 144; bits[s] = 9; }
+            else if (s < 280) { codigo[s] = s - 256; bits[s] = 7; }
+            else { codigo[s] = 0xC0 + s - 280; bits[s] = 8; }
+            codigo[s] = invertir(codigo[s], bits[s]);
+        }
+    }
+};
+
+static void simboloFijo(EscritorBits& bits, int simbolo) {
+    static const TablaFija tabla;
+    bits.escribir(tabla.codigo[simbolo], tabla.bits[simbolo]);
+}
+
+static const int BASE_LONGITUD[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int EXTRA_LONGITUD[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+// Repetición de 'longitud' bytes a distancia 1 (el byte anterior).
+static void repeticion(EscritorBits& bits, int longitud) {
+    int k = 28;
+    while (BASE_LONGITUD[k] > longitud)
+        k--;
+    simboloFijo(bits, 257 + k);
+    if (EXTRA_LONGITUD[k] > 0)
+        bits.escribir(longitud - BASE_LONGITUD[k], EXTRA_LONGITUD[k]);
+    bits.escribir(0, 5);  // código de distancia 0 = distancia 1 (invertido sigue siendo 0)
+}
+
+// Flujo zlib con un solo bloque deflate de Huffman fijo.
+static void comprimir(const vector<unsigned char>& datos, vector<unsigned char>& out) {
+    out.push_back(0x78);
+    out.push_back(0x01);
+    EscritorBits bits(out);
+    bits.escribir(1, 1);  // BFINAL
+    bits.escribir(1, 2);  // BTYPE = 01, Huffman fijo
+    size_t n = datos.size();
+    size_t i = 0;
+    while (i < n) {
+        if (i > 0) {
+            size_t r = 0;
+            while (r < 258 && i + r < n && datos[i + r] == datos[i - 1])
+                r++;
+            if (r >= 3) {
+                repeticion(bits, (int)r);
+                i += r;
+                continue;
+            }
+        }
+        simboloFijo(bits, datos[i]);
+        i++;
+    }
+    simboloFijo(bits, 256);  // fin de bloque
+    bits.terminar();
+
+    // Adler-32, reduciendo cada 5552 bytes (lo más que cabe sin desbordar 32 bits).
+    uint32_t a = 1, b = 0;
+    for (size_t k = 0; k < n;) {
+        size_t fin = min(n, k + 5552);
+        for (; k < fin; k++) {
+            a += datos[k];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    uint32_t adler = (b << 16) | a;
+    for (int s = 24; s >= 0; s -= 8)
+        out.push_back((unsigned char)(adler >> s));
+}
+
+struct TablaCrc {
+    uint32_t valores[256];
+    TablaCrc() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            valores[i] = c;
+        }
+    }
+};
+
+static uint32_t crc32(const unsigned char* p, size_t n) {
+    static const TablaCrc tabla;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; i++)
+        crc = tabla.valores[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void escribir32(vector<unsigned char>& out, uint32_t v) {
+    for (int s = 24; s >= 0; s -= 8)
+        out.push_back((unsigned char)(v >> s));
+}
+
+static void bloquePng(vector<unsigned char>& out, const char* tipo, const vector<unsigned char>& datos) {
+    escribir32(out, (uint32_t)datos.size());
+    size_t inicio = out.size();
+    out.insert(out.end(), tipo, tipo + 4);
+    out.insert(out.end(), datos.begin(), datos.end());
+    escribir32(out, crc32(&out[inicio], out.size() - inicio));
+}
+
+void codificarPng(int ancho, int alto, const uint32_t* rgba, vector<unsigned char>& salida) {
+    const size_t bytesFila = (size_t)ancho * 4;
+    vector<unsigned char> crudo((bytesFila + 1) * alto);
+    unsigned char* out = crudo.data();
+    for (int y = 0; y < alto; y++) {
+        const unsigned char* fila = (const unsigned char*)(rgba + (size_t)y * ancho);
+        const unsigned char* anterior = y > 0 ? (const unsigned char*)(rgba + (size_t)(y - 1) * ancho) : nullptr;
+        // Si la fila es igual a la anterior, Up la deja en puros ceros; si no, Sub
+        // convierte cada tramo de un solo color en ceros.
+        if (anterior && memcmp(fila, anterior, bytesFila) == 0) {
+            *out++ = 2;
+            memset(out, 0, bytesFila);
+        }
+        else {
+            *out++ = 1;
+            for (size_t i = 0; i < 4 && i < bytesFila; i++)
+                out[i] = fila[i];
+            for (size_t i = 4; i < bytesFila; i++)
+                out[i] = (unsigned char)(fila[i] - fila[i - 4]);
+        }
+        out += bytesFila;
+    }
+
+    static const unsigned char firma[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    salida.assign(firma, firma + 8);
+
+    vector<unsigned char> ihdr;
+    escribir32(ihdr, (uint32_t)ancho);
+    escribir32(ihdr, (uint32_t)alto);
+    ihdr.push_back(8);  // bits por canal
+    ihdr.push_back(6);  // RGBA
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    bloquePng(salida, "IHDR", ihdr);
+
+    vector<unsigned char> idat;
+    comprimir(crudo, idat);
+    bloquePng(salida, "IDAT", idat);
+    bloquePng(salida, "IEND", vector<unsigned char>());
+}
+
+bool guardarPng(const char* ruta, int ancho, int alto, const uint32_t* rgba) {
+    vector<unsigned char> datos;
+    codificarPng(ancho, alto, rgba, datos);
+    FILE* f = fopen(ruta, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(datos.data(), 1, datos.size(), f) == datos.size();
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,19 @@
+/*
+* Escritura de imágenes PNG sin dependencias externas.
+*/
+#ifndef PNG_H
+#define PNG_H
+
+#include <cstdint>
+#include <vector>
+
+// Codifica una imagen RGBA (un uint32_t por pixel, bytes R, G, B, A, fila 0 arriba) como
+// PNG. La compresión es deflate con códigos Huffman fijos y sólo busca repeticiones del
+// byte anterior, que es lo que abunda en imágenes de colores planos como las de la
+// teselación; a cambio es rápida y siempre produce exactamente los mismos bytes.
+void codificarPng(int ancho, int alto, const uint32_t* rgba, std::vector<unsigned char>& salida);
+
+// Codifica y escribe el archivo. Regresa false si no se pudo escribir.
+bool guardarPng(const char* ruta, int ancho, int alto, const uint32_t* rgba);
+
+#endif
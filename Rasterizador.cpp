@@ -0,0 +1,412 @@
+/*
+* Rasterizador por software para dibujar la animación sin GPU ni ventana.
+*/
+#include "Rasterizador.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Precisión subpixel de los vértices, como en el hardware (1/16 de pixel).
+static const int BITS_SUBPIXEL = 4;
+static const int64_t UNO = (int64_t)1 << BITS_SUBPIXEL;
+// Los vértices más allá de esto (en NDC) desbordarían las funciones de borde. OpenGL
+// los recortaría; aquí simplemente se descarta el triángulo.
+static const float LIMITE_NDC = 4096.0f;
+
+static uint8_t aByte(float c) {
+    c = min(max(c, 0.0f), 1.0f);
+    return (uint8_t)(c * 255.0f + 0.5f);
+}
+
+static uint32_t empacarColor(float r, float g, float b, float a) {
+    return (uint32_t)aByte(r) | ((uint32_t)aByte(g) << 8) | ((uint32_t)aByte(b) << 16) | ((uint32_t)aByte(a) << 24);
+}
+
+bool cargarTextura(const char* ruta, Textura& tex) {
+    int canales;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(ruta, &tex.ancho, &tex.alto, &canales, 4);
+    if (!data)
+        return false;
+    tex.rgba.assign(data, data + (size_t)tex.ancho * tex.alto * 4);
+    stbi_image_free(data);
+    return true;
+}
+
+// Muestreo bilineal con GL_CLAMP_TO_EDGE.
+static void muestrear(const Textura& tex, float u, float v, float rgba[4]) {
+    float x = u * tex.ancho - 0.5f;
+    float y = v * tex.alto - 0.5f;
+    int x0 = (int)floor(x), y0 = (int)floor(y);
+    float fx = x - x0, fy = y - y0;
+    int xs[2] = { min(max(x0, 0), tex.ancho - 1), min(max(x0 + 1, 0), tex.ancho - 1) };
+    int ys[2] = { min(max(y0, 0), tex.alto - 1), min(max(y0 + 1, 0), tex.alto - 1) };
+    float pesos[4] = { (1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy };
+    for (int c = 0; c < 4; c++)
+        rgba[c] = 0.0f;
+    for (int k = 0; k < 4; k++) {
+        const unsigned char* p = &tex.rgba[((size_t)ys[k / 2] * tex.ancho + xs[k % 2]) * 4];
+        for (int c = 0; c < 4; c++)
+            rgba[c] += pesos[k] * p[c] / 255.0f;
+    }
+}
+
+Rasterizador::Rasterizador(int ancho, int alto, PoolHilos& hilos)
+    : anchoPx(ancho), altoPx(alto), hilos(hilos), fondo(0) {
+    mosaicosX = (ancho + TAM_MOSAICO - 1) / TAM_MOSAICO;
+    mosaicosY = (alto + TAM_MOSAICO - 1) / TAM_MOSAICO;
+    buffer.assign((size_t)ancho * alto, 0);
+}
+
+void Rasterizador::limpiar(float r, float g, float b) {
+    fondo = empacarColor(r, g, b, 1.0f);
+    tris.clear();
+}
+
+// Transformación de viewport: de coordenadas de recorte a pantalla en punto fijo, con
+// la fila 0 arriba.
+bool Rasterizador::aPantalla(const glm::vec4& clip, int64_t& x, int64_t& y) const {
+    float nx = clip.x / clip.w, ny = clip.y / clip.w;
+    if (!(fabs(nx) < LIMITE_NDC && fabs(ny) < LIMITE_NDC))
+        return false;
+    x = (int64_t)llround((nx + 1.0f) * 0.5f * anchoPx * UNO);
+    y = (int64_t)llround((1.0f - ny) * 0.5f * altoPx * UNO);
+    return true;
+}
+
+// Lleva los tres vértices a pantalla y los deja con área positiva; orden[k] es el vértice
+// de 'clip' que quedó en la posición k. Regresa false si el triángulo se descarta.
+bool Rasterizador::trianguloAPantalla(const glm::vec4 clip[3], int64_t x[3], int64_t y[3], int orden[3]) const {
+    for (int k = 0; k < 3; k++)
+        if (!aPantalla(clip[k], x[k], y[k]))
+            return false;
+    // Dejamos todos los triángulos con la misma orientación (sin culling).
+    int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0)
+        return false;
+    orden[0] = 0;
+    orden[1] = 1;
+    orden[2] = 2;
+    if (area < 0) {
+        swap(x[1], x[2]);
+        swap(y[1], y[2]);
+        orden[1] = 2;
+        orden[2] = 1;
+    }
+    return true;
+}
+
+// Caja de los n vértices recortada a la pantalla. Regresa false si queda vacía.
+bool Rasterizador::caja(TriPantalla& t, int n) const {
+    int64_t minX = t.x[0], minY = t.y[0], maxX = t.x[0], maxY = t.y[0];
+    for (int k = 1; k < n; k++) {
+        minX = min(minX, t.x[k]);
+        minY = min(minY, t.y[k]);
+        maxX = max(maxX, t.x[k]);
+        maxY = max(maxY, t.y[k]);
+    }
+    t.minX = (int)max<int64_t>(0, minX >> BITS_SUBPIXEL);
+    t.minY = (int)max<int64_t>(0, minY >> BITS_SUBPIXEL);
+    t.maxX = (int)min<int64_t>(anchoPx - 1, maxX >> BITS_SUBPIXEL);
+    t.maxY = (int)min<int64_t>(altoPx - 1, maxY >> BITS_SUBPIXEL);
+    return t.minX <= t.maxX && t.minY <= t.maxY;
+}
+
+void Rasterizador::agregar(const glm::vec4 clip[3], uint32_t color, const Textura* tex, const float* uv) {
+    TriPantalla t;
+    t.par = false;
+    int orden[3];
+    if (!trianguloAPantalla(clip, t.x, t.y, orden) || !caja(t, 3))
+        return;
+    t.color = color;
+    t.textura = tex;
+    for (int k = 0; k < 3; k++) {
+        t.u[k] = uv ? uv[2 * orden[k]] : 0.0f;
+        t.v[k] = uv ? uv[2 * orden[k] + 1] : 0.0f;
+    }
+    tris.push_back(t);
+}
+
+void Rasterizador::agregarPar(const glm::vec4 clip[6], uint32_t color) {
+    TriPantalla t;
+    t.par = true;
+    int orden[3];
+    bool mitad0 = trianguloAPantalla(clip, t.x, t.y, orden);
+    bool mitad1 = trianguloAPantalla(clip + 3, t.x + 3, t.y + 3, orden);
+    // Si una mitad se descarta (degenerada en pantalla o fuera del límite), la otra va
+    // sola, igual que si se hubieran mandado por separado.
+    if (!mitad0 || !mitad1) {
+        if (mitad0)
+            agregar(clip, color, nullptr, nullptr);
+        if (mitad1)
+            agregar(clip + 3, color, nullptr, nullptr);
+        return;
+    }
+    if (!caja(t, 6))
+        return;
+    t.color = color;
+    t.textura = nullptr;
+    for (int k = 0; k < 3; k++)
+        t.u[k] = t.v[k] = 0.0f;
+    tris.push_back(t);
+}
+
+static int claseEnSector(int clase, int sector) {
+    return sector == 0 && clase < CLASE_CEROS_PROTAG ? clase + CLASE_CEROS_PROTAG : clase;
+}
+
+// Punto en punto fijo del sector 0 llevado al sector dado, igual que en los shaders: los
+// vértices del borde van sobre su rayo para que los dos sectores que los comparten los
+// pongan en el mismo lugar.
+static glm::vec2 aSector(int16_t x, int16_t y, int borde, const glm::mat4& matSector, int sector) {
+    glm::vec2 p(x / ESCALA_VERTICE, y / ESCALA_VERTICE);
+    if (borde == SIN_BORDE)
+        return glm::vec2(matSector * glm::vec4(p, 0.0f, 1.0f));
+    float dx, dy;
+    direccionDeRayo(rayoDeBorde(sector, borde), dx, dy);
+    float r = sqrt(p.x * p.x + p.y * p.y);
+    return glm::vec2(r * dx, r * dy);
+}
+
+void Rasterizador::dibujarEmpacados(const VerticeEmpacado* vertices, const uint32_t* indices, size_t numIndices,
+    const glm::mat4 transforms[2], const float colores[NUM_CLASES][3], const glm::mat4 sectores[NUM_SECTORES],
+    int primerSector, int instancias, size_t rombos) {
+    if (numIndices == 0)
+        return;
+    uint32_t tabla[NUM_CLASES];
+    for (int c = 0; c < NUM_CLASES; c++)
+        tabla[c] = empacarColor(colores[c][0], colores[c][1], colores[c][2], 1.0f);
+
+    // Primero se transforman todos los vértices del rango que tocan los índices.
+    uint32_t menor = indices[0], mayor = indices[0];
+    for (size_t i = 1; i < numIndices; i++) {
+        menor = min(menor, indices[i]);
+        mayor = max(mayor, indices[i]);
+    }
+    transformados.resize((size_t)mayor - menor + 1);
+
+    for (int instancia = 0; instancia < instancias; instancia++) {
+        int sector = (instancia + primerSector) % NUM_SECTORES;
+        for (uint32_t j = menor; j <= mayor; j++) {
+            const VerticeEmpacado& v = vertices[j];
+            glm::vec2 p = aSector(v.x, v.y, v.borde, sectores[sector], sector);
+            transformados[j - menor] = transforms[transformacionDeClase(claseEnSector(v.clase, sector))] *
+                glm::vec4(p, 0.0f, 1.0f);
+        }
+
+        const size_t finPares = min(6 * rombos, numIndices - numIndices % 6);
+        for (size_t i = 0; i < finPares; i += 6) {
+            // Las dos mitades de un rombo tienen la misma clase.
+            int clase = claseEnSector(vertices[indices[i]].clase, sector);
+            glm::vec4 clip[6];
+            for (int k = 0; k < 6; k++)
+                clip[k] = transformados[indices[i + k] - menor];
+            agregarPar(clip, tabla[clase]);
+        }
+        for (size_t i = finPares; i + 3 <= numIndices; i += 3) {
+            // Los tres vértices de un triángulo tienen la misma clase (en el shader es 'flat').
+            int clase = claseEnSector(vertices[indices[i]].clase, sector);
+            glm::vec4 clip[3];
+            for (int k = 0; k < 3; k++)
+                clip[k] = transformados[indices[i + k] - menor];
+            agregar(clip, tabla[clase], nullptr, nullptr);
+        }
+    }
+}
+
+void Rasterizador::dibujarMemoizado(const Prototipo& prototipo, const vector<InstanciaTriangulo>& instancias,
+    const glm::mat4 transforms[2], const float colores[NUM_CLASES][3], const glm::mat4& matSector, int sector) {
+    uint32_t tabla[NUM_CLASES];
+    for (int c = 0; c < NUM_CLASES; c++)
+        tabla[c] = empacarColor(colores[c][0], colores[c][1], colores[c][2], 1.0f);
+    const vector<VerticeEmpacado>& verts = prototipo.vertices;
+    const vector<uint32_t>& indices = prototipo.indices;
+    transformados.resize(verts.size());
+
+    for (const InstanciaTriangulo& t : instancias) {
+        glm::vec2 esq[3];
+        for (int k = 0; k < 3; k++)
+            esq[k] = aSector(t.esquinas[k][0], t.esquinas[k][1], t.bordes[k], matSector, sector);
+
+        // Misma cuenta que memoizado.vs.
+        for (size_t j = 0; j < verts.size(); j++) {
+            const VerticeEmpacado& v = verts[j];
+            glm::vec2 p;
+            int q = -1;     // Parámetro en punto fijo si el vértice está en una arista
+            glm::vec2 a, b;
+            switch (v.borde) {
+            case ESQUINA_A: p = esq[0]; break;
+            case ESQUINA_B: p = esq[1]; break;
+            case ESQUINA_C: p = esq[2]; break;
+            case ARISTA_AB: a = esq[0]; b = esq[1]; q = v.x; break;
+            case ARISTA_BC: a = esq[1]; b = esq[2]; q = v.y; break;
+            case ARISTA_CA: a = esq[2]; b = esq[0]; q = (int)ESCALA_VERTICE - v.y; break;
+            default:
+                p = esq[0] + (v.x / ESCALA_VERTICE) * (esq[1] - esq[0]) + (v.y / ESCALA_VERTICE) * (esq[2] - esq[0]);
+            }
+            if (q >= 0) {
+                // Desde el triángulo vecino la arista va al revés y s cambia de signo, así que
+                // el resultado es el mismo bit a bit.
+                float s = (float)(2 * q - (int)ESCALA_VERTICE) / (2.0f * ESCALA_VERTICE);
+                p = 0.5f * (a + b) + s * (b - a);
+            }
+            transformados[j] = transforms[transformacionDeClase(claseEnSector(v.clase, sector))] * glm::vec4(p, 0.0f, 1.0f);
+        }
+
+        for (size_t i = 0; i + 3 <= indices.size(); i += 3) {
+            int clase = claseEnSector(verts[indices[i]].clase, sector);
+            glm::vec4 clip[3];
+            for (int k = 0; k < 3; k++)
+                clip[k] = transformados[indices[i + k]];
+            agregar(clip, tabla[clase], nullptr, nullptr);
+        }
+    }
+}
+
+void Rasterizador::dibujarRefinados(const VerticeRefinado* vertices, size_t numVertices,
+    const float colores[NUM_CLASES][3]) {
+    uint32_t tabla[NUM_CLASES];
+    for (int c = 0; c < NUM_CLASES; c++)
+        tabla[c] = empacarColor(colores[c][0], colores[c][1], colores[c][2], 1.0f);
+    for (size_t i = 0; i + 3 <= numVertices; i += 3) {
+        glm::vec4 clip[3];
+        for (int k = 0; k < 3; k++)
+            clip[k] = glm::vec4(vertices[i + k].x, vertices[i + k].y, 0.0f, 1.0f);
+        agregar(clip, tabla[vertices[i].clase], nullptr, nullptr);
+    }
+}
+
+void Rasterizador::dibujarTexturado(const float* vertices, const unsigned int* indices, size_t numIndices, const Textura& tex) {
+    if (tex.rgba.empty())
+        return;
+    for (size_t i = 0; i + 3 <= numIndices; i += 3) {
+        glm::vec4 clip[3];
+        float uv[6];
+        for (int k = 0; k < 3; k++) {
+            const float* p = vertices + 8 * (size_t)indices[i + k];
+            clip[k] = glm::vec4(p[0], p[1], p[2], 1.0f);
+            uv[2 * k] = p[6];
+            uv[2 * k + 1] = p[7];
+        }
+        agregar(clip, 0, &tex, uv);
+    }
+}
+
+// Rasteriza el triángulo sólo dentro del rectángulo [x0, x1) x [y0, y1) del mosaico.
+void Rasterizador::rasterizar(const TriPantalla& t, int x0, int y0, int x1, int y1) {
+    int minX = max(t.minX, x0), maxX = min(t.maxX, x1 - 1);
+    int minY = max(t.minY, y0), maxY = min(t.maxY, y1 - 1);
+    if (minX > maxX || minY > maxY)
+        return;
+
+    // E_k(p) = a_k * px + b_k * py + c_k, positiva dentro del triángulo. En los pixeles
+    // que caen justo sobre un borde, el sesgo hace que sólo uno de los dos triángulos
+    // que lo comparten lo pinte (regla arriba-izquierda). Un par lleva las funciones de
+    // sus dos mitades y un pixel se pinta si cae en cualquiera de las dos, así que la
+    // diagonal se resuelve con la misma regla que si fueran dos triángulos.
+    int64_t a[6], b[6], c[6];
+    const int n = t.par ? 6 : 3;
+    for (int m = 0; m < n; m += 3) {
+        for (int k = 0; k < 3; k++) {
+            int i = m + (k + 1) % 3, j = m + (k + 2) % 3;
+            a[m + k] = t.y[i] - t.y[j];
+            b[m + k] = t.x[j] - t.x[i];
+            c[m + k] = t.x[i] * t.y[j] - t.y[i] * t.x[j];
+            bool arribaIzquierda = a[m + k] < 0 || (a[m + k] == 0 && b[m + k] < 0);
+            if (!arribaIzquierda)
+                c[m + k] -= 1;
+        }
+    }
+    // E_0 + E_1 + E_2 es el producto cruz de dos lados del triángulo, así que E_k entre
+    // ese producto es la coordenada baricéntrica del vértice k.
+    float areaInv = 0.0f;
+    if (t.textura) {
+        int64_t area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+        areaInv = (float)(1.0 / (double)area);
+    }
+
+    int64_t px0 = ((int64_t)minX << BITS_SUBPIXEL) + UNO / 2;
+    int64_t py = ((int64_t)minY << BITS_SUBPIXEL) + UNO / 2;
+    if (t.par) {
+        for (int y = minY; y <= maxY; y++, py += UNO) {
+            int64_t e[6];
+            for (int k = 0; k < 6; k++)
+                e[k] = a[k] * px0 + b[k] * py + c[k];
+            uint32_t* fila = &buffer[(size_t)y * anchoPx];
+            for (int x = minX; x <= maxX; x++) {
+                if ((e[0] | e[1] | e[2]) >= 0 || (e[3] | e[4] | e[5]) >= 0)
+                    fila[x] = t.color;
+                for (int k = 0; k < 6; k++)
+                    e[k] += a[k] * UNO;
+            }
+        }
+        return;
+    }
+    for (int y = minY; y <= maxY; y++, py += UNO) {
+        int64_t e[3];
+        for (int k = 0; k < 3; k++)
+            e[k] = a[k] * px0 + b[k] * py + c[k];
+        uint32_t* fila = &buffer[(size_t)y * anchoPx];
+        for (int x = minX; x <= maxX; x++) {
+            if ((e[0] | e[1] | e[2]) >= 0) {
+                if (!t.textura) {
+                    fila[x] = t.color;
+                }
+                else {
+                    float l0 = e[0] * areaInv;
+                    float l1 = e[1] * areaInv;
+                    float l2 = 1.0f - l0 - l1;
+                    float u = l0 * t.u[0] + l1 * t.u[1] + l2 * t.u[2];
+                    float v = l0 * t.v[0] + l1 * t.v[1] + l2 * t.v[2];
+                    float rgba[4];
+                    muestrear(*t.textura, u, v, rgba);
+                    // if(texColor.a < 0.1) discard;
+                    if (rgba[3] >= 0.1f)
+                        fila[x] = empacarColor(rgba[0], rgba[1], rgba[2], 1.0f);
+                }
+            }
+            for (int k = 0; k < 3; k++)
+                e[k] += a[k] * UNO;
+        }
+    }
+}
+
+void Rasterizador::terminar() {
+    const size_t numMosaicos = (size_t)mosaicosX * mosaicosY;
+    const size_t numPedazos = max<size_t>(1, min<size_t>(4 * (size_t)hilos.tamano(), tris.size() / 256 + 1));
+    const size_t tamPedazo = (tris.size() + numPedazos - 1) / numPedazos;
+
+    // 1. Cada pedazo de triángulos se reparte en las listas de los mosaicos que toca.
+    //    Como cada pedazo tiene sus propias listas no hace falta sincronizar nada.
+    listas.resize(numPedazos);
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        vector<vector<uint32_t> >& mias = listas[p];
+        mias.resize(numMosaicos);
+        for (vector<uint32_t>& l : mias)
+            l.clear();
+        size_t fin = min(tris.size(), (p + 1) * tamPedazo);
+        for (size_t i = p * tamPedazo; i < fin; i++) {
+            const TriPantalla& t = tris[i];
+            for (int my = t.minY / TAM_MOSAICO; my <= t.maxY / TAM_MOSAICO; my++)
+                for (int mx = t.minX / TAM_MOSAICO; mx <= t.maxX / TAM_MOSAICO; mx++)
+                    mias[(size_t)my * mosaicosX + mx].push_back((uint32_t)i);
+        }
+    });
+
+    // 2. Cada mosaico se limpia y se rasteriza recorriendo los pedazos en orden, así
+    //    que los triángulos quedan uno sobre otro igual que en OpenGL.
+    hilos.paraCada(numMosaicos, [&](size_t m) {
+        int x0 = (int)(m % mosaicosX) * TAM_MOSAICO, y0 = (int)(m / mosaicosX) * TAM_MOSAICO;
+        int x1 = min(x0 + TAM_MOSAICO, anchoPx), y1 = min(y0 + TAM_MOSAICO, altoPx);
+        for (int y = y0; y < y1; y++)
+            fill(&buffer[(size_t)y * anchoPx + x0], &buffer[(size_t)y * anchoPx + x1], fondo);
+        for (size_t p = 0; p < numPedazos; p++)
+            for (uint32_t i : listas[p][m])
+                rasterizar(tris[i], x0, y0, x1, y1);
+    });
+    tris.clear();
+}
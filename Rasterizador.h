@@ -0,0 +1,111 @@
+/*
+* Rasterizador por software para dibujar la animación sin GPU ni ventana.
+* Reproduce lo que hacen los shaders proyecto1.vs/.fs (triángulos empacados con su
+* clase de color) y shaderAux.vs/.fs (cuadro texturizado que descarta
+* los pixeles con alfa < 0.1).
+*/
+#ifndef RASTERIZADOR_H
+#define RASTERIZADOR_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hilos.h"
+#include "Instancias.h"
+#include "Penrose.h"
+#include "Vertice.h"
+
+// Textura RGBA de 8 bits por canal. La fila 0 es la de abajo, igual que en OpenGL
+// cuando se carga con stbi_set_flip_vertically_on_load(true).
+struct Textura {
+    int ancho = 0;
+    int alto = 0;
+    std::vector<unsigned char> rgba;
+};
+
+// Carga una imagen con stb_image y la convierte a RGBA. Regresa false si no se pudo.
+bool cargarTextura(const char* ruta, Textura& tex);
+
+// Rasterizador de triángulos por mosaicos. Las llamadas de dibujo sólo transforman y
+// guardan los triángulos; terminar() los reparte en mosaicos de TAM_MOSAICO pixeles y
+// cada hilo rasteriza mosaicos completos con funciones de borde, respetando el orden
+// en que se mandaron a dibujar.
+class Rasterizador {
+public:
+    static const int TAM_MOSAICO = 64;
+
+    Rasterizador(int ancho, int alto, PoolHilos& hilos);
+
+    // Equivalente a glClearColor + glClear. Descarta lo que estuviera encolado.
+    void limpiar(float r, float g, float b);
+
+    // glDrawElementsInstanced(GL_TRIANGLES) con proyecto1.vs/.fs: se dibujan
+    // numIndices / 3 triángulos de vértices empacados por instancia; cada uno toma su
+    // transformación y su color de la tabla según la clase de sus vértices. La instancia
+    // i se lleva al sector (i + primerSector) % NUM_SECTORES con 'sectores', y en el
+    // sector 0 las clases de la teselación principal se cambian por las del protagonista.
+    // Cada vértice que usan los índices se transforma una sola vez por instancia, sin
+    // importar cuántos triángulos lo compartan. Los primeros 6 * rombos índices son pares
+    // de mitades de rombo de juntarRombos() (Rombos.h) y cada par se encola y se reparte
+    // en mosaicos como una sola primitiva, que pinta exactamente los mismos pixeles que
+    // sus dos mitades.
+    void dibujarEmpacados(const VerticeEmpacado* vertices, const uint32_t* indices, size_t numIndices,
+        const glm::mat4 transforms[2], const float colores[NUM_CLASES][3],
+        const glm::mat4 sectores[NUM_SECTORES], int primerSector = 0, int instancias = 1, size_t rombos = 0);
+    // Las llamadas glDrawElementsInstanced de un prototipo con memoizado.vs/proyecto1.fs:
+    // una instancia del prototipo por cada triángulo grueso, todas en el sector dado.
+    void dibujarMemoizado(const Prototipo& prototipo, const std::vector<InstanciaTriangulo>& instancias,
+        const glm::mat4 transforms[2], const float colores[NUM_CLASES][3], const glm::mat4& matSector, int sector);
+    // glDrawArrays(GL_TRIANGLES) con refinado.vs/proyecto1.fs: los vértices ya vienen
+    // en coordenadas de recorte, tres por triángulo, con su clase de color.
+    void dibujarRefinados(const VerticeRefinado* vertices, size_t numVertices, const float colores[NUM_CLASES][3]);
+    // glDrawElements(GL_TRIANGLES) con shaderAux.vs/.fs: cada vértice trae posición,
+    // color y coordenadas de textura (8 floats) y la posición ya está en NDC.
+    void dibujarTexturado(const float* vertices, const unsigned int* indices, size_t numIndices, const Textura& tex);
+
+    // Rasteriza todo lo encolado desde el último limpiar().
+    void terminar();
+
+    int ancho() const { return anchoPx; }
+    int alto() const { return altoPx; }
+    // Pixeles RGBA (un uint32_t por pixel, bytes en orden R, G, B, A). La fila 0 es la
+    // de arriba.
+    const std::vector<uint32_t>& pixeles() const { return buffer; }
+
+private:
+    // Triángulo ya en coordenadas de pantalla, en punto fijo con BITS_SUBPIXEL bits. Con
+    // 'par' son las dos mitades de un rombo (vértices 0 a 2 y 3 a 5), sin textura.
+    struct TriPantalla {
+        bool par;
+        int64_t x[6];
+        int64_t y[6];
+        int minX, minY, maxX, maxY;
+        uint32_t color;
+        const Textura* textura;
+        float u[3];
+        float v[3];
+    };
+
+    bool aPantalla(const glm::vec4& clip, int64_t& x, int64_t& y) const;
+    bool trianguloAPantalla(const glm::vec4 clip[3], int64_t x[3], int64_t y[3], int orden[3]) const;
+    bool caja(TriPantalla& t, int n) const;
+    void agregar(const glm::vec4 clip[3], uint32_t color, const Textura* tex, const float* uv);
+    void agregarPar(const glm::vec4 clip[6], uint32_t color);
+    void rasterizar(const TriPantalla& t, int x0, int y0, int x1, int y1);
+
+    int anchoPx;
+    int altoPx;
+    int mosaicosX;
+    int mosaicosY;
+    PoolHilos& hilos;
+    uint32_t fondo;
+    std::vector<uint32_t> buffer;
+    std::vector<TriPantalla> tris;
+    std::vector<std::vector<std::vector<uint32_t> > > listas;  // [pedazo][mosaico] -> triángulos
+    std::vector<glm::vec4> transformados;                       // Vértices ya transformados de dibujarEmpacados y dibujarMemoizado
+};
+
+#endif
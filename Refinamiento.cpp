@@ -0,0 +1,142 @@
+/*
+* Subdivisión perezosa según la vista.
+*/
+#include "Refinamiento.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+
+RefinadorVista::RefinadorVista(int anchoPx, int altoPx, double tamPixeles, size_t presupuesto, int profundidadMaxima)
+    : mitadAncho(0.5 * anchoPx), mitadAlto(0.5 * altoPx), tamPixeles(tamPixeles), presupuesto(presupuesto),
+    profundidadMaxima(min(profundidadMaxima, PROFUNDIDAD_MAXIMA_REFINADO)), numHojas(0), nivelMaximo(0), numDescartados(0) {
+    frontera.reserve(presupuesto);
+    siguiente.reserve(presupuesto);
+    salida.reserve(3 * presupuesto);
+}
+
+void RefinadorVista::limpiar() {
+    vistas.clear();
+    frontera.clear();
+    for (vector<VerticeRefinado>& h : hojas)
+        h.clear();
+    salida.clear();
+    numHojas = 0;
+    nivelMaximo = 0;
+    numDescartados = 0;
+}
+
+void RefinadorVista::agregar(const triangulo& semilla, const glm::mat4& vista, int claseCeros) {
+    assert(vistas.size() < 256);
+    // glm guarda por columnas: [columna][renglón].
+    Afin f = { vista[0][0], vista[1][0], vista[0][1], vista[1][1], vista[3][0], vista[3][1] };
+    vistas.push_back(f);
+    if (hojas.size() < vistas.size())
+        hojas.resize(vistas.size());
+    Nodo n;
+    n.t = semilla;
+    n.vista = (uint8_t)(vistas.size() - 1);
+    n.claseCeros = (uint8_t)claseCeros;
+    n.nivel = 0;
+    aRecorte(n);
+    if (!visible(n))
+        numDescartados++;
+    else if (frontera.size() < presupuesto)
+        frontera.push_back(n);
+}
+
+void RefinadorVista::aRecorte(Nodo& n) const {
+    const Afin& f = vistas[n.vista];
+    const complex<double>* v[3] = { &n.t.A, &n.t.B, &n.t.C };
+    for (int k = 0; k < 3; k++) {
+        n.x[k] = f.a * v[k]->real() + f.b * v[k]->imag() + f.tx;
+        n.y[k] = f.c * v[k]->real() + f.d * v[k]->imag() + f.ty;
+    }
+}
+
+// Círculo con centro en el centroide que pasa por el vértice más lejano, contra el
+// cuadrado [-1, 1] x [-1, 1].
+bool RefinadorVista::visible(const Nodo& n) const {
+    double cx = (n.x[0] + n.x[1] + n.x[2]) / 3, cy = (n.y[0] + n.y[1] + n.y[2]) / 3;
+    double r2 = 0;
+    for (int k = 0; k < 3; k++)
+        r2 = max(r2, (n.x[k] - cx) * (n.x[k] - cx) + (n.y[k] - cy) * (n.y[k] - cy));
+    double dx = max(fabs(cx) - 1, 0.0), dy = max(fabs(cy) - 1, 0.0);
+    return dx * dx + dy * dy <= r2;
+}
+
+// Cuadrado del largo de los lados iguales, en pixeles: la mediana de las tres aristas.
+double RefinadorVista::tamEnPixeles2(const Nodo& n) const {
+    double l[3];
+    for (int k = 0; k < 3; k++) {
+        int s = (k + 1) % 3;
+        double dx = (n.x[s] - n.x[k]) * mitadAncho, dy = (n.y[s] - n.y[k]) * mitadAlto;
+        l[k] = dx * dx + dy * dy;
+    }
+    return max(min(l[0], l[1]), min(max(l[0], l[1]), l[2]));
+}
+
+// Los vértices que comparten dos triángulos se calculan por separado, desde cada uno, y
+// pueden diferir en el último bit. Se redondean a una rejilla de SUBPIXELES_REFINADO
+// por pixel (más fina que la del rasterizador y la de la GPU) para que los dos lados
+// queden en el mismo punto y no se abra una grieta entre ellos.
+static const double SUBPIXELES_REFINADO = 256;
+
+void RefinadorVista::agregarHoja(const Nodo& n) {
+    vector<VerticeRefinado>& h = hojas[n.vista];
+    const double ex = mitadAncho * SUBPIXELES_REFINADO, ey = mitadAlto * SUBPIXELES_REFINADO;
+    for (int k = 0; k < 3; k++) {
+        VerticeRefinado v = { (float)(nearbyint(n.x[k] * ex) / ex), (float)(nearbyint(n.y[k] * ey) / ey),
+            (uint8_t)(n.claseCeros + n.t.color), { 0, 0, 0 } };
+        h.push_back(v);
+    }
+    numHojas++;
+    nivelMaximo = max(nivelMaximo, (int)n.nivel);
+}
+
+void RefinadorVista::refinar() {
+    // Cada pasada baja un nivel. Un triángulo que no se parte en una pasada ya no se
+    // parte en ninguna (la cuenta sólo crece), así que pasa directo a las hojas de su
+    // vista y las pasadas siguientes sólo recorren lo que falta refinar. Se parte sólo si
+    // sus hijos caben en el presupuesto aunque ninguno se descarte, así que el total
+    // nunca lo rebasa.
+    const double tam2 = tamPixeles * tamPixeles;
+    while (!frontera.empty()) {
+        siguiente.clear();
+        size_t cuenta = numHojas + frontera.size();
+        for (const Nodo& n : frontera) {
+            size_t hijos = n.t.color == 0 ? 2 : 3;
+            if (n.nivel >= profundidadMaxima || tamEnPixeles2(n) <= tam2 || cuenta + hijos - 1 > presupuesto) {
+                agregarHoja(n);
+                continue;
+            }
+
+            triangulo partes[3];
+            hijosDe(n.t, partes);
+            Nodo h[3];
+            cuenta--;
+            for (size_t k = 0; k < hijos; k++) {
+                h[k].t = partes[k];
+                h[k].vista = n.vista;
+                h[k].claseCeros = n.claseCeros;
+                h[k].nivel = (uint8_t)(n.nivel + 1);
+                aRecorte(h[k]);
+                if (visible(h[k])) {
+                    siguiente.push_back(h[k]);
+                    cuenta++;
+                }
+                else {
+                    numDescartados++;
+                }
+            }
+        }
+        swap(frontera, siguiente);
+    }
+
+    // Dentro de una vista los triángulos no se enciman, así que sólo importa el orden
+    // entre vistas.
+    for (size_t v = 0; v < vistas.size(); v++)
+        salida.insert(salida.end(), hojas[v].begin(), hojas[v].end());
+}
@@ -0,0 +1,100 @@
+/*
+* Subdivisión perezosa según la vista: en lugar de subir la teselación completa a una
+* profundidad fija, cada cuadro se refina sólo lo que se ve, hasta que los triángulos
+* midan en pantalla menos que un tamaño dado.
+*/
+#ifndef REFINAMIENTO_H
+#define REFINAMIENTO_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Penrose.h"
+#include "Vertice.h"
+
+// Con double, a esta profundidad los triángulos miden phi^-60 = 3e-13 y todavía quedan
+// tres órdenes de magnitud por encima del redondeo de las coordenadas.
+const int PROFUNDIDAD_MAXIMA_REFINADO = 60;
+// Triángulos por cuadro por default: 4.5 MB de vértices, de sobra para llenar una
+// pantalla de 1000 x 1000 con triángulos de 10 pixeles.
+const size_t PRESUPUESTO_REFINADO = 1 << 17;
+
+// La jerarquía de sustitución queda implícita: no se guarda ningún árbol, sólo la
+// frontera de triángulos visibles del cuadro actual. Se empieza con las semillas y en
+// cada pasada se cambia cada triángulo de la frontera que todavía mida más de
+// 'tamPixeles' por sus hijos, con las mismas reglas que subdividir(). Los hijos cuyo
+// círculo envolvente queda fuera de [-1, 1] x [-1, 1] en coordenadas de recorte se
+// descartan con todo su subárbol. La subdivisión sólo parte triángulos en otros más
+// chicos, así que un subárbol nunca se sale de su triángulo.
+//
+// Lo que se mide es el largo de los dos lados iguales del triángulo, no su arista más
+// larga: en un mismo nivel es igual para los dos colores (el tipo uno tiene la base
+// larga y el tipo cero los lados largos), así que con una vista que no deforma todos los
+// triángulos visibles de una semilla bajan al mismo nivel y no quedan vértices en T,
+// que abrirían grietas de un pixel entre un triángulo grueso y sus vecinos finos.
+//
+// Como la frontera se refina por niveles, si el presupuesto no alcanza los triángulos
+// que se quedan sin partir son todos del mismo nivel y están repartidos por toda la
+// pantalla, en lugar de quedar una región fina y otra gruesa; en ese caso sí puede
+// perderse algún pixel suelto en las aristas entre los dos niveles. Con el tamaño en
+// pantalla fijo, el número de triángulos sólo depende del área visible y no del
+// acercamiento.
+class RefinadorVista {
+public:
+    RefinadorVista(int anchoPx, int altoPx, double tamPixeles, size_t presupuesto = PRESUPUESTO_REFINADO,
+        int profundidadMaxima = PROFUNDIDAD_MAXIMA_REFINADO);
+
+    // Empieza un cuadro: descarta la frontera del anterior.
+    void limpiar();
+    // Agrega una semilla que se ve con la transformación afín 'vista' (la z se ignora) y
+    // cuyos triángulos tipo cero y uno se dibujan con las clases claseCeros y
+    // claseCeros + 1. Las semillas se dibujan en el orden en que se agregan.
+    void agregar(const triangulo& semilla, const glm::mat4& vista, int claseCeros);
+    // Refina la frontera y llena vertices() con tres vértices por triángulo visible.
+    void refinar();
+
+    const std::vector<VerticeRefinado>& vertices() const { return salida; }
+    size_t numTriangulos() const { return numHojas; }
+    // Nivel del triángulo más profundo del último cuadro y subárboles descartados.
+    int profundidadAlcanzada() const { return nivelMaximo; }
+    size_t descartados() const { return numDescartados; }
+
+private:
+    // (x, y) -> (a x + b y + tx, c x + d y + ty), en double para que el acercamiento
+    // no pierda precisión antes de tiempo.
+    struct Afin {
+        double a, b, c, d, tx, ty;
+    };
+    struct Nodo {
+        triangulo t;
+        double x[3];            // Vértices en coordenadas de recorte
+        double y[3];
+        uint8_t vista;          // Índice en 'vistas'
+        uint8_t claseCeros;
+        uint8_t nivel;
+    };
+
+    void aRecorte(Nodo& n) const;
+    bool visible(const Nodo& n) const;
+    double tamEnPixeles2(const Nodo& n) const;
+    void agregarHoja(const Nodo& n);
+
+    double mitadAncho;
+    double mitadAlto;
+    double tamPixeles;
+    size_t presupuesto;
+    int profundidadMaxima;
+    std::vector<Afin> vistas;
+    std::vector<Nodo> frontera;
+    std::vector<Nodo> siguiente;
+    std::vector<std::vector<VerticeRefinado> > hojas;  // [vista] -> triángulos terminados
+    std::vector<VerticeRefinado> salida;
+    size_t numHojas;
+    int nivelMaximo;
+    size_t numDescartados;
+};
+
+#endif
@@ -0,0 +1,375 @@
+/*
+* Regiones de un mismo color.
+*/
+#include "Regiones.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+#include "Penrose.h"
+#include "Rombos.h"
+
+using namespace std;
+
+// Una arista de un triángulo, dirigida de 'desde' a 'hasta' con el triángulo a la
+// izquierda. La llave son los dos índices, el menor arriba.
+struct Arista {
+    uint64_t llave;
+    uint32_t triangulo;
+    uint32_t desde;
+};
+
+// Arista del contorno de una región, que se identifica con su raíz en el union-find.
+struct AristaBorde {
+    uint32_t raiz;
+    uint32_t desde;
+    uint32_t hasta;
+};
+
+static uint32_t hastaDe(const Arista& a) {
+    uint32_t menor = (uint32_t)(a.llave >> 32), mayor = (uint32_t)a.llave;
+    return a.desde == menor ? mayor : menor;
+}
+
+// Union-find sin candados. Un nodo es raíz si es su propio padre; las raíces sólo se
+// cuelgan de una raíz de menor índice, así que no se forman ciclos y al final la raíz de
+// cada conjunto es su elemento menor.
+class UnionFind {
+public:
+    explicit UnionFind(size_t n) : padre(n) {
+        for (size_t i = 0; i < n; i++)
+            padre[i].store((uint32_t)i, memory_order_relaxed);
+    }
+
+    // Con compresión a medias: cada nodo que se visita pasa a apuntar a su abuelo. Si
+    // otro hilo ya lo cambió, el compare-and-swap falla y no pasa nada.
+    uint32_t encontrar(uint32_t i) {
+        for (;;) {
+            uint32_t p = padre[i].load(memory_order_relaxed);
+            if (p == i)
+                return i;
+            uint32_t abuelo = padre[p].load(memory_order_relaxed);
+            if (abuelo != p)
+                padre[i].compare_exchange_weak(p, abuelo, memory_order_relaxed);
+            i = abuelo;
+        }
+    }
+
+    void unir(uint32_t a, uint32_t b) {
+        for (;;) {
+            a = encontrar(a);
+            b = encontrar(b);
+            if (a == b)
+                return;
+            if (a < b)
+                swap(a, b);
+            // Si 'a' dejó de ser raíz mientras tanto, se vuelve a intentar.
+            uint32_t esperado = a;
+            if (padre[a].compare_exchange_strong(esperado, b, memory_order_relaxed))
+                return;
+        }
+    }
+
+private:
+    vector<atomic<uint32_t> > padre;
+};
+
+static int64_t cruz(int64_t ax, int64_t ay, int64_t bx, int64_t by) {
+    return ax * by - ay * bx;
+}
+
+// Un lado recto entre a y c pasa por b (el redondeo del punto fijo lo puede mover una
+// unidad o dos) y b está entre los dos.
+static bool enMedio(const VerticeEmpacado& a, const VerticeEmpacado& b, const VerticeEmpacado& c) {
+    int64_t ux = b.x - a.x, uy = b.y - a.y, vx = c.x - b.x, vy = c.y - b.y;
+    int64_t cr = cruz(ux, uy, vx, vy);
+    int64_t wx = ux + vx, wy = uy + vy;
+    return ux * vx + uy * vy > 0 && cr * cr <= 4 * (wx * wx + wy * wy);
+}
+
+// Traza los anillos de una región a partir de sus aristas de borde, ordenadas por
+// 'desde'. Donde la región se toca a sí misma en un vértice hay varias aristas que salen
+// de él; se toma la primera en el sentido de las manecillas del reloj desde la arista
+// por la que se llegó, que es la que cierra el mismo pedazo de región, así que cada
+// anillo queda simple.
+static void trazarRegion(const VerticeEmpacado* vertices, const AristaBorde* borde, size_t n,
+    vector<RegionesTeselacion::Anillo>& anillos, vector<uint32_t>& puntos) {
+    vector<bool> usada(n, false);
+    vector<uint32_t> anillo;
+    struct Trazado {
+        size_t primero;
+        size_t cuantos;
+        int64_t area;
+    };
+    vector<Trazado> trazados;
+    vector<uint32_t> todos;
+
+    for (size_t inicio = 0; inicio < n; inicio++) {
+        if (usada[inicio])
+            continue;
+        anillo.clear();
+        size_t e = inicio;
+        for (;;) {
+            usada[e] = true;
+            anillo.push_back(borde[e].desde);
+            uint32_t v = borde[e].hasta;
+            if (v == borde[inicio].desde)
+                break;
+            // Aristas que salen de v.
+            const AristaBorde* prim = lower_bound(borde, borde + n, v,
+                [](const AristaBorde& a, uint32_t d) { return a.desde < d; });
+            size_t mejor = n;
+            double mejorAngulo = 0;
+            const VerticeEmpacado& pv = vertices[v];
+            const VerticeEmpacado& pa = vertices[borde[e].desde];
+            for (const AristaBorde* s = prim; s < borde + n && s->desde == v; s++) {
+                size_t k = (size_t)(s - borde);
+                if (usada[k])
+                    continue;
+                const VerticeEmpacado& ps = vertices[s->hasta];
+                double rx = pa.x - pv.x, ry = pa.y - pv.y, dx = ps.x - pv.x, dy = ps.y - pv.y;
+                double angulo = atan2(rx * dy - ry * dx, rx * dx + ry * dy);
+                if (angulo < 0)
+                    angulo += 2 * pi;
+                angulo = 2 * pi - angulo;   // Sentido de las manecillas desde la de llegada
+                if (mejor == n || angulo < mejorAngulo) {
+                    mejor = k;
+                    mejorAngulo = angulo;
+                }
+            }
+            if (mejor == n)
+                break;      // Contorno abierto: sólo con vértices degenerados
+            e = mejor;
+        }
+
+        // Quita los vértices intermedios de los lados rectos.
+        size_t m = anillo.size(), primero = todos.size();
+        for (size_t i = 0; i < m; i++) {
+            uint32_t antes = todos.size() > primero ? todos.back() : anillo[m - 1];
+            if (!enMedio(vertices[antes], vertices[anillo[i]], vertices[anillo[(i + 1) % m]]))
+                todos.push_back(anillo[i]);
+        }
+        while (todos.size() - primero > 3 &&
+            enMedio(vertices[todos.back()], vertices[todos[primero]], vertices[todos[primero + 1]]))
+            todos.erase(todos.begin() + (ptrdiff_t)primero);
+        if (todos.size() - primero < 3) {
+            todos.resize(primero);
+            continue;
+        }
+        int64_t area = 0;
+        for (size_t i = primero; i < todos.size(); i++) {
+            const VerticeEmpacado& a = vertices[todos[i]];
+            const VerticeEmpacado& b = vertices[todos[i + 1 < todos.size() ? i + 1 : primero]];
+            area += cruz(a.x, a.y, b.x, b.y);
+        }
+        Trazado t = { primero, todos.size() - primero, area };
+        trazados.push_back(t);
+    }
+
+    // El contorno exterior más grande primero; después los demás en el orden en que
+    // salieron.
+    size_t exterior = 0;
+    for (size_t i = 1; i < trazados.size(); i++)
+        if (trazados[i].area > trazados[exterior].area)
+            exterior = i;
+    for (size_t j = 0; j < trazados.size(); j++) {
+        const Trazado& t = trazados[j == 0 ? exterior : (j <= exterior ? j - 1 : j)];
+        RegionesTeselacion::Anillo a = { (uint32_t)puntos.size(), (uint32_t)t.cuantos };
+        anillos.push_back(a);
+        puntos.insert(puntos.end(), todos.begin() + (ptrdiff_t)t.primero, todos.begin() + (ptrdiff_t)(t.primero + t.cuantos));
+    }
+}
+
+void unirRegiones(const VerticeEmpacado* vertices, const uint32_t* indices, size_t numIndices, PoolHilos& hilos,
+    RegionesTeselacion& salida) {
+    salida.regiones.clear();
+    salida.anillos.clear();
+    salida.puntos.clear();
+    const size_t n = numIndices / 3;
+    if (n == 0)
+        return;
+    const size_t numPedazos = min<size_t>(4 * (size_t)hilos.tamano(), n / 1024 + 1);
+    const size_t tamPedazo = (n + numPedazos - 1) / numPedazos;
+
+    // 1. Las tres aristas de cada triángulo, con el triángulo a la izquierda.
+    vector<Arista> aristas(3 * n);
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        for (size_t t = p * tamPedazo; t < min(n, (p + 1) * tamPedazo); t++) {
+            uint32_t v[3] = { indices[3 * t], indices[3 * t + 1], indices[3 * t + 2] };
+            const VerticeEmpacado &a = vertices[v[0]], &b = vertices[v[1]], &c = vertices[v[2]];
+            if (cruz(b.x - a.x, b.y - a.y, c.x - a.x, c.y - a.y) < 0)
+                swap(v[1], v[2]);
+            for (int k = 0; k < 3; k++) {
+                uint32_t d = v[k], h = v[(k + 1) % 3];
+                Arista e = { ((uint64_t)min(d, h) << 32) | max(d, h), (uint32_t)t, d };
+                aristas[3 * t + k] = e;
+            }
+        }
+    });
+
+    // 2. Las aristas iguales quedan juntas; sus triángulos son vecinos del mismo color.
+    ordenarParalelo(aristas, hilos, [](const Arista& a, const Arista& b) { return a.llave < b.llave; });
+    const size_t numAristas = aristas.size();
+    const size_t tamPedazoAristas = (numAristas + numPedazos - 1) / numPedazos;
+    UnionFind conjuntos(n);
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        size_t fin = min(numAristas, (p + 1) * tamPedazoAristas);
+        for (size_t i = p * tamPedazoAristas; i < fin; i++)
+            if (i + 1 < numAristas && aristas[i].llave == aristas[i + 1].llave)
+                conjuntos.unir(aristas[i].triangulo, aristas[i + 1].triangulo);
+    });
+
+    // 3. Las aristas sin vecino son el borde de su región.
+    vector<vector<AristaBorde> > bordes(numPedazos);
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        size_t fin = min(numAristas, (p + 1) * tamPedazoAristas);
+        for (size_t i = p * tamPedazoAristas; i < fin; i++) {
+            bool repetida = (i > 0 && aristas[i - 1].llave == aristas[i].llave) ||
+                (i + 1 < numAristas && aristas[i + 1].llave == aristas[i].llave);
+            if (!repetida) {
+                AristaBorde b = { conjuntos.encontrar(aristas[i].triangulo), aristas[i].desde, hastaDe(aristas[i]) };
+                bordes[p].push_back(b);
+            }
+        }
+    });
+    vector<Arista>().swap(aristas);
+    vector<AristaBorde> borde;
+    for (const vector<AristaBorde>& b : bordes)
+        borde.insert(borde.end(), b.begin(), b.end());
+    vector<vector<AristaBorde> >().swap(bordes);
+    ordenarParalelo(borde, hilos, [](const AristaBorde& a, const AristaBorde& b) {
+        return a.raiz != b.raiz ? a.raiz < b.raiz : (a.desde != b.desde ? a.desde < b.desde : a.hasta < b.hasta);
+    });
+
+    // 4. Cada región es un tramo de aristas con la misma raíz, que es su primer
+    //    triángulo. Los tramos se trazan por pedazos en paralelo y se juntan en orden.
+    vector<size_t> tramos;
+    for (size_t i = 0; i < borde.size(); i++)
+        if (i == 0 || borde[i].raiz != borde[i - 1].raiz)
+            tramos.push_back(i);
+    tramos.push_back(borde.size());
+    const size_t numRegiones = tramos.size() - 1;
+    const size_t pedazosRegiones = min<size_t>(4 * (size_t)hilos.tamano(), numRegiones / 64 + 1);
+    const size_t tamPedazoRegiones = (numRegiones + pedazosRegiones - 1) / pedazosRegiones;
+    struct Trazo {
+        vector<RegionesTeselacion::Region> regiones;
+        vector<RegionesTeselacion::Anillo> anillos;
+        vector<uint32_t> puntos;
+    };
+    vector<Trazo> trazos(pedazosRegiones);
+    hilos.paraCada(pedazosRegiones, [&](size_t p) {
+        Trazo& t = trazos[p];
+        for (size_t r = p * tamPedazoRegiones; r < min(numRegiones, (p + 1) * tamPedazoRegiones); r++) {
+            const AristaBorde* b = borde.data() + tramos[r];
+            size_t primerAnillo = t.anillos.size();
+            trazarRegion(vertices, b, tramos[r + 1] - tramos[r], t.anillos, t.puntos);
+            if (t.anillos.size() == primerAnillo)
+                continue;
+            RegionesTeselacion::Region region = { vertices[b->desde].clase, (uint32_t)primerAnillo,
+                (uint32_t)(t.anillos.size() - primerAnillo) };
+            t.regiones.push_back(region);
+        }
+    });
+    for (const Trazo& t : trazos) {
+        uint32_t baseAnillos = (uint32_t)salida.anillos.size(), basePuntos = (uint32_t)salida.puntos.size();
+        for (RegionesTeselacion::Region r : t.regiones) {
+            r.primerAnillo += baseAnillos;
+            salida.regiones.push_back(r);
+        }
+        for (RegionesTeselacion::Anillo a : t.anillos) {
+            a.primerPunto += basePuntos;
+            salida.anillos.push_back(a);
+        }
+        salida.puntos.insert(salida.puntos.end(), t.puntos.begin(), t.puntos.end());
+    }
+}
+
+// ------------------------------------------------------------------------------------
+// SVG. El eje y del SVG va hacia abajo, así que se invierte. Los caminos van con
+// coordenadas relativas, que son números cortos.
+
+static FILE* abrirSvg(const char* ruta) {
+    FILE* f = fopen(ruta, "w");
+    if (!f)
+        return nullptr;
+    const int lado = (int)ESCALA_VERTICE;
+    fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"%d %d %d %d\" width=\"1000\" height=\"1000\">\n",
+        -lado, -lado, 2 * lado, 2 * lado);
+    return f;
+}
+
+static void abrirGrupo(FILE* f, const float color[3]) {
+    fprintf(f, "<g fill=\"#%02x%02x%02x\">\n", (int)lround(color[0] * 255), (int)lround(color[1] * 255),
+        (int)lround(color[2] * 255));
+}
+
+static void escribirAnillo(FILE* f, const VerticeEmpacado* vertices, const uint32_t* anillo, size_t n) {
+    int x = vertices[anillo[0]].x, y = -vertices[anillo[0]].y;
+    fprintf(f, "M%d %d", x, y);
+    for (size_t i = 1; i < n; i++) {
+        int nx = vertices[anillo[i]].x, ny = -vertices[anillo[i]].y;
+        fprintf(f, "l%d %d", nx - x, ny - y);
+        x = nx;
+        y = ny;
+    }
+    fputc('z', f);
+}
+
+static bool cerrarSvg(FILE* f) {
+    fprintf(f, "</svg>\n");
+    bool ok = !ferror(f);
+    return fclose(f) == 0 && ok;
+}
+
+bool exportarSvg(const char* ruta, const VerticeEmpacado* vertices, const RegionesTeselacion& regiones,
+    const float colores[2][3]) {
+    FILE* f = abrirSvg(ruta);
+    if (!f)
+        return false;
+    for (int clase = CLASE_CEROS; clase <= CLASE_UNOS; clase++) {
+        abrirGrupo(f, colores[clase - CLASE_CEROS]);
+        for (const RegionesTeselacion::Region& r : regiones.regiones) {
+            if ((int)r.clase != clase)
+                continue;
+            fprintf(f, "<path d=\"");
+            for (uint32_t k = 0; k < r.numAnillos; k++) {
+                const RegionesTeselacion::Anillo& a = regiones.anillos[r.primerAnillo + k];
+                escribirAnillo(f, vertices, &regiones.puntos[a.primerPunto], a.numPuntos);
+            }
+            fprintf(f, "\"/>\n");
+        }
+        fprintf(f, "</g>\n");
+    }
+    return cerrarSvg(f);
+}
+
+bool exportarSvgTriangulos(const char* ruta, const VerticeEmpacado* vertices, const uint32_t* indices,
+    size_t numIndices, size_t rombos, const float colores[2][3]) {
+    FILE* f = abrirSvg(ruta);
+    if (!f)
+        return false;
+    const size_t finPares = min(6 * rombos, numIndices - numIndices % 6);
+    for (int clase = CLASE_CEROS; clase <= CLASE_UNOS; clase++) {
+        abrirGrupo(f, colores[clase - CLASE_CEROS]);
+        for (size_t i = 0; i < finPares; i += 6) {
+            if (vertices[indices[i]].clase != clase)
+                continue;
+            uint32_t v[4];
+            verticesDeRombo(indices, i / 6, v);
+            fprintf(f, "<path d=\"");
+            escribirAnillo(f, vertices, v, 4);
+            fprintf(f, "\"/>\n");
+        }
+        for (size_t i = finPares; i + 3 <= numIndices; i += 3) {
+            if (vertices[indices[i]].clase != clase)
+                continue;
+            fprintf(f, "<path d=\"");
+            escribirAnillo(f, vertices, indices + i, 3);
+            fprintf(f, "\"/>\n");
+        }
+        fprintf(f, "</g>\n");
+    }
+    return cerrarSvg(f);
+}
@@ -0,0 +1,57 @@
+/*
+* Regiones de un mismo color: une los triángulos vecinos del mismo color y saca el
+* contorno de cada región como polígono (con hoyos), para exportar la teselación en
+* vectores sin un polígono por triángulo.
+*/
+#ifndef REGIONES_H
+#define REGIONES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hilos.h"
+#include "Vertice.h"
+
+// Polígonos de las regiones. Cada región es un conjunto de triángulos de la misma clase
+// unidos por aristas; su contorno son uno o más anillos cerrados de índices de vértices
+// (sin repetir el primero al final). Con el eje y hacia arriba, los contornos exteriores
+// van en sentido contrario a las manecillas del reloj y los hoyos en el sentido de las
+// manecillas; el primer anillo de cada región es su contorno exterior más grande. Los
+// vértices intermedios de lados rectos se quitan.
+struct RegionesTeselacion {
+    struct Region {
+        uint32_t clase;
+        uint32_t primerAnillo;
+        uint32_t numAnillos;
+    };
+    struct Anillo {
+        uint32_t primerPunto;
+        uint32_t numPuntos;
+    };
+    std::vector<Region> regiones;
+    std::vector<Anillo> anillos;
+    std::vector<uint32_t> puntos;
+};
+
+// Une las regiones de los triángulos de un buffer de índices soldado (SoldadorVertices).
+// Como el soldador suelda por clase, dos triángulos comparten una arista (los mismos dos
+// índices) sólo si son vecinos del mismo color, así que la adyacencia sale de ordenar
+// las aristas por sus índices. Las uniones se hacen en paralelo sobre un union-find sin
+// candados (compare-and-swap; la raíz de mayor índice se cuelga de la de menor), y los
+// contornos de las regiones se trazan en paralelo. Las regiones quedan en el orden de su
+// primer triángulo, así que el resultado no depende del número de hilos.
+void unirRegiones(const VerticeEmpacado* vertices, const uint32_t* indices, size_t numIndices, PoolHilos& hilos,
+    RegionesTeselacion& salida);
+
+// Escriben la teselación como SVG, con coordenadas enteras del punto fijo de
+// VerticeEmpacado y un color por clase (colores[0] para CLASE_CEROS y colores[1] para
+// CLASE_UNOS). exportarSvg() escribe un camino por región; exportarSvgTriangulos() uno
+// por triángulo, o por rombo para los primeros 'rombos' pares de un buffer de
+// juntarRombos() (Rombos.h). Regresan false si no se pudo escribir.
+bool exportarSvg(const char* ruta, const VerticeEmpacado* vertices, const RegionesTeselacion& regiones,
+    const float colores[2][3]);
+bool exportarSvgTriangulos(const char* ruta, const VerticeEmpacado* vertices, const uint32_t* indices,
+    size_t numIndices, size_t rombos, const float colores[2][3]);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+* Juntar mitades de rombo.
+*/
+#include "Rombos.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static const uint32_t SIN_PAREJA = 0xFFFFFFFFu;
+
+static size_t hashBase(uint64_t llave) {
+    uint64_t h = llave * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 32;
+    return (size_t)h;
+}
+
+// Tabla de bases con direccionamiento abierto y factor de carga máximo de 1/2. Las bases
+// se quedan en la tabla después de encontrar pareja; como cada una aparece a lo más dos
+// veces, no estorban.
+struct EntradaBase {
+    uint64_t llave;
+    uint32_t triangulo;     // SIN_PAREJA si la entrada está libre
+};
+
+static size_t tamTabla(size_t numTriangulos) {
+    size_t tam = 16;
+    while (tam < 2 * numTriangulos)
+        tam *= 2;
+    return tam;
+}
+
+size_t bytesJuntarRombos(size_t numTriangulos) {
+    return tamTabla(numTriangulos) * sizeof(EntradaBase) + numTriangulos * 4 * sizeof(uint32_t);
+}
+
+size_t juntarRombos(vector<uint32_t>& indices) {
+    const size_t n = indices.size() / 3;
+    if (n < 2)
+        return 0;
+
+    const size_t tam = tamTabla(n);
+    const size_t mascara = tam - 1;
+    EntradaBase vacia = { 0, SIN_PAREJA };
+    vector<EntradaBase> tabla(tam, vacia);
+    vector<uint32_t> pareja(n, SIN_PAREJA);
+
+    size_t rombos = 0;
+    for (size_t t = 0; t < n; t++) {
+        uint32_t b = indices[3 * t + 1], c = indices[3 * t + 2];
+        if (b == c)
+            continue;
+        uint64_t llave = ((uint64_t)min(b, c) << 32) | max(b, c);
+        size_t i = hashBase(llave) & mascara;
+        while (tabla[i].triangulo != SIN_PAREJA && tabla[i].llave != llave)
+            i = (i + 1) & mascara;
+        if (tabla[i].triangulo == SIN_PAREJA) {
+            EntradaBase e = { llave, (uint32_t)t };
+            tabla[i] = e;
+        }
+        else if (pareja[tabla[i].triangulo] == SIN_PAREJA) {
+            pareja[t] = tabla[i].triangulo;
+            pareja[tabla[i].triangulo] = (uint32_t)t;
+            rombos++;
+        }
+    }
+    if (rombos == 0)
+        return 0;
+
+    // Cada rombo va en el lugar de su primera mitad; los sueltos, al final.
+    vector<uint32_t> reordenados(indices.size());
+    uint32_t* par = reordenados.data();
+    uint32_t* suelto = par + 6 * rombos;
+    for (size_t t = 0; t < n; t++) {
+        const uint32_t* tri = &indices[3 * t];
+        if (pareja[t] == SIN_PAREJA) {
+            suelto[0] = tri[0];
+            suelto[1] = tri[1];
+            suelto[2] = tri[2];
+            suelto += 3;
+        }
+        else if (pareja[t] > t) {
+            par[0] = tri[0];
+            par[1] = tri[1];
+            par[2] = tri[2];
+            par[3] = indices[3 * (size_t)pareja[t]];
+            par[4] = tri[2];
+            par[5] = tri[1];
+            par += 6;
+        }
+    }
+    indices.swap(reordenados);
+    return rombos;
+}
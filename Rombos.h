@@ -0,0 +1,46 @@
+/*
+* Junta las mitades de rombo de la teselación soldada. Cada rombo de P3 sale de la
+* subdivisión como dos triángulos del mismo color que comparten la base BC, uno a cada
+* lado; juntarlos deja la mitad de primitivas para el rasterizador y las exportaciones.
+*/
+#ifndef ROMBOS_H
+#define ROMBOS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reordena los triángulos de un buffer de índices ya soldado (tres índices por
+// triángulo, como los deja SoldadorVertices) para que los rombos queden al principio:
+// cada rombo son sus dos mitades seguidas, (A, B, C) y (A', C, B), y después vienen los
+// triángulos que no encontraron pareja (los del borde de la teselación) en el orden en
+// que estaban. Regresa el número de rombos; los primeros 6 * rombos índices son los
+// pares.
+//
+// Dos triángulos son pareja si su base BC son los mismos dos índices. Como el soldador
+// da el mismo índice a un mismo punto, la llave es exacta, y como suelda por clase, sólo
+// se juntan triángulos del mismo color. Cada arista la comparten a lo más dos
+// triángulos, así que cada base tiene a lo más una pareja. Tiempo lineal: cada base se
+// busca una vez en una tabla hash.
+//
+// El buffer sigue siendo de triángulos, así que se dibuja igual que antes con
+// GL_TRIANGLES; las dos mitades seguidas comparten dos vértices, que la GPU toma del
+// caché de vértices transformados. El rasterizador por software (Rasterizador.h) sí
+// toma cada par como una sola primitiva.
+size_t juntarRombos(std::vector<uint32_t>& indices);
+
+// Memoria de trabajo de juntarRombos() con ese número de triángulos, en bytes: la tabla
+// de bases, las parejas y la copia reordenada de los índices.
+size_t bytesJuntarRombos(size_t numTriangulos);
+
+// Los cuatro vértices del rombo k de un buffer reordenado, en orden alrededor de él:
+// A, B, A', C.
+inline void verticesDeRombo(const uint32_t* indices, size_t k, uint32_t v[4]) {
+    const uint32_t* par = indices + 6 * k;
+    v[0] = par[0];
+    v[1] = par[1];
+    v[2] = par[3];
+    v[3] = par[2];
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+* Soldadura de vértices.
+*/
+#include "Soldadura.h"
+
+#include <cmath>
+
+using namespace std;
+
+constexpr double SoldadorVertices::TAM_CELDA;
+
+static size_t potenciaDeDos(size_t n) {
+    size_t p = 16;
+    while (p < n)
+        p *= 2;
+    return p;
+}
+
+static size_t hashCelda(int64_t cx, int64_t cy, int clase) {
+    uint64_t h = (uint64_t)cx * 0x9E3779B97F4A7C15ull;
+    h ^= (uint64_t)cy * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+    h ^= (uint64_t)clase * 0x165667B19E3779F9ull;
+    h ^= h >> 32;
+    return (size_t)h;
+}
+
+SoldadorVertices::SoldadorVertices(size_t capacidad, double tamCelda) : tamCelda(tamCelda) {
+    // Factor de carga máximo de 1/2.
+    Entrada vacia = { 0, 0, 0, VACIA };
+    tabla.assign(potenciaDeDos(2 * capacidad), vacia);
+    verts.reserve(capacidad);
+}
+
+size_t SoldadorVertices::bytesReservados(size_t capacidad) {
+    return potenciaDeDos(2 * capacidad) * sizeof(Entrada) + capacidad * sizeof(VerticeEmpacado);
+}
+
+uint32_t SoldadorVertices::buscar(int64_t cx, int64_t cy, int clase) const {
+    size_t mascara = tabla.size() - 1;
+    for (size_t i = hashCelda(cx, cy, clase) & mascara;; i = (i + 1) & mascara) {
+        const Entrada& e = tabla[i];
+        if (e.indice == VACIA)
+            return VACIA;
+        if (e.cx == cx && e.cy == cy && e.clase == (uint32_t)clase)
+            return e.indice;
+    }
+}
+
+void SoldadorVertices::insertar(int64_t cx, int64_t cy, int clase, uint32_t indice) {
+    size_t mascara = tabla.size() - 1;
+    size_t i = hashCelda(cx, cy, clase) & mascara;
+    while (tabla[i].indice != VACIA)
+        i = (i + 1) & mascara;
+    Entrada e = { cx, cy, (uint32_t)clase, indice };
+    tabla[i] = e;
+}
+
+void SoldadorVertices::crecer() {
+    vector<Entrada> anterior;
+    anterior.swap(tabla);
+    Entrada vacia = { 0, 0, 0, VACIA };
+    tabla.assign(2 * anterior.size(), vacia);
+    for (const Entrada& e : anterior)
+        if (e.indice != VACIA)
+            insertar(e.cx, e.cy, (int)e.clase, e.indice);
+}
+
+uint32_t SoldadorVertices::agregar(double x, double y, int clase) {
+    double fx = x / tamCelda;
+    double fy = y / tamCelda;
+    int64_t cx = (int64_t)floor(fx);
+    int64_t cy = (int64_t)floor(fy);
+    // Celda vecina del lado más cercano en cada eje: un punto a menos de media celda de
+    // distancia sólo puede estar en la misma celda o en esas.
+    int64_t dx = fx - cx < 0.5 ? -1 : 1;
+    int64_t dy = fy - cy < 0.5 ? -1 : 1;
+    uint32_t indice = buscar(cx, cy, clase);
+    if (indice == VACIA)
+        indice = buscar(cx + dx, cy, clase);
+    if (indice == VACIA)
+        indice = buscar(cx, cy + dy, clase);
+    if (indice == VACIA)
+        indice = buscar(cx + dx, cy + dy, clase);
+    if (indice != VACIA)
+        return indice;
+
+    indice = (uint32_t)verts.size();
+    verts.push_back(empacarVertice(x, y, clase));
+    if (2 * verts.size() > tabla.size())
+        crecer();
+    insertar(cx, cy, clase, indice);
+    return indice;
+}
+
+void SoldadorVertices::marcarBordesDeSector() {
+    // Se trabaja con las coordenadas ya empacadas, que es lo que va a usar el shader; dos
+    // unidades de punto fijo de tolerancia cubren el redondeo.
+    const double tolerancia = 2.0 / ESCALA_VERTICE;
+    for (VerticeEmpacado& v : verts)
+        if (v.clase < CLASE_CEROS_PROTAG)
+            v.borde = (uint8_t)bordeDeSector(v.x / ESCALA_VERTICE, v.y / ESCALA_VERTICE, tolerancia);
+}
+
+uint32_t SoldadorVertices::agregar(const PuntoExacto& p, int clase) {
+    int64_t cx = (int64_t)(((uint64_t)(uint32_t)p.c[0] << 32) | (uint32_t)p.c[1]);
+    int64_t cy = (int64_t)(((uint64_t)(uint32_t)p.c[2] << 32) | (uint32_t)p.c[3]);
+    uint32_t indice = buscar(cx, cy, clase);
+    if (indice != VACIA)
+        return indice;
+
+    double x, y;
+    aReales(p, x, y);
+    indice = (uint32_t)verts.size();
+    verts.push_back(empacarVertice(x, y, clase));
+    if (2 * verts.size() > tabla.size())
+        crecer();
+    insertar(cx, cy, clase, indice);
+    return indice;
+}
+
+void SoldadorVertices::agregarBloque(const BloqueExacto& bloque, size_t n, int clase, vector<uint32_t>& indices) {
+    size_t base = indices.size();
+    indices.resize(base + 3 * n);
+    uint32_t* out = indices.data() + base;
+    for (size_t i = 0; i < n; i++, out += 3) {
+        out[0] = agregar(bloque.punto(bloque.a, i), clase);
+        out[1] = agregar(bloque.punto(bloque.b, i), clase);
+        out[2] = agregar(bloque.punto(bloque.c, i), clase);
+    }
+}
+
+size_t cotaVerticesSoldados(uint64_t triangulos, int profundidad, int semillas) {
+    return (size_t)triangulos + (size_t)semillas * (size_t)(2 * pow(goldenRatio, profundidad) + 3);
+}
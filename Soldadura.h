@@ -0,0 +1,90 @@
+/*
+* Soldadura de vértices: junta los vértices repetidos de triángulos vecinos para dibujar
+* la teselación con un buffer de índices.
+*/
+#ifndef SOLDADURA_H
+#define SOLDADURA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Exacto.h"
+#include "Penrose.h"
+#include "Vertice.h"
+
+// Junta vértices que caen en el mismo punto (y tienen la misma clase de color) en uno
+// solo. Cada punto se busca en una tabla hash con las coordenadas cuantizadas a una
+// rejilla de TAM_CELDA. Las divisiones repetidas entre goldenRatio hacen que un mismo
+// vértice calculado desde dos triángulos distintos difiera en unos cuantos ulps; si esa
+// diferencia lo deja justo del otro lado de una frontera de celda, también se revisan
+// las celdas vecinas, así que dos puntos a menos de TAM_CELDA / 2 siempre se sueldan.
+// TAM_CELDA está muy por debajo de la distancia entre vértices distintos aun a
+// profundidades grandes (1 / goldenRatio^k). Con coordenadas de menos precisión que
+// double (BloqueSoAT<float>, por ejemplo) la celda se agranda con el constructor.
+class SoldadorVertices {
+public:
+    static constexpr double TAM_CELDA = 1e-7;
+
+    // 'capacidad' es un estimado de cuántos vértices distintos habrá; la tabla crece si
+    // se queda corta. 'tamCelda' reemplaza a TAM_CELDA.
+    explicit SoldadorVertices(size_t capacidad = 1024, double tamCelda = TAM_CELDA);
+
+    // Regresa el índice del vértice (x, y) de la clase dada, agregándolo si no estaba.
+    uint32_t agregar(double x, double y, int clase);
+
+    // Agrega los n triángulos del bloque y sus índices al final de 'indices'.
+    template <typename S>
+    void agregarBloque(const BloqueSoAT<S>& bloque, size_t n, int clase, std::vector<uint32_t>& indices) {
+        size_t base = indices.size();
+        indices.resize(base + 3 * n);
+        uint32_t* out = indices.data() + base;
+        for (size_t i = 0; i < n; i++, out += 3) {
+            out[0] = agregar(Escalar<S>::aDouble(bloque.ax[i]), Escalar<S>::aDouble(bloque.ay[i]), clase);
+            out[1] = agregar(Escalar<S>::aDouble(bloque.bx[i]), Escalar<S>::aDouble(bloque.by[i]), clase);
+            out[2] = agregar(Escalar<S>::aDouble(bloque.cx[i]), Escalar<S>::aDouble(bloque.cy[i]), clase);
+        }
+    }
+
+    // Versiones para coordenadas exactas (Exacto.h). Los cuatro coeficientes son la llave
+    // de la tabla, así que no hace falta rejilla ni celdas vecinas: dos vértices se
+    // sueldan si y sólo si son iguales. No se deben mezclar con las de double en el
+    // mismo soldador.
+    uint32_t agregar(const PuntoExacto& p, int clase);
+    void agregarBloque(const BloqueExacto& bloque, size_t n, int clase, std::vector<uint32_t>& indices);
+
+    // Memoria que reserva el constructor con esa capacidad, en bytes.
+    static size_t bytesReservados(size_t capacidad);
+
+    // Marca con su BordeSector los vértices de las clases de la teselación principal que
+    // caen en los bordes rectos del sector 0 (ver matrizSector() en Penrose.h).
+    void marcarBordesDeSector();
+
+    const std::vector<VerticeEmpacado>& vertices() const { return verts; }
+    size_t size() const { return verts.size(); }
+
+private:
+    struct Entrada {
+        int64_t cx, cy;     // Celda del vértice (o coeficientes exactos, dos por llave)
+        uint32_t clase;
+        uint32_t indice;    // VACIA si la entrada está libre
+    };
+    static const uint32_t VACIA = 0xFFFFFFFFu;
+
+    uint32_t buscar(int64_t cx, int64_t cy, int clase) const;
+    void insertar(int64_t cx, int64_t cy, int clase, uint32_t indice);
+    void crecer();
+
+    double tamCelda;
+    std::vector<Entrada> tabla;     // Direccionamiento abierto; el tamaño es potencia de 2
+    std::vector<VerticeEmpacado> verts;
+};
+
+// Cota de los vértices que quedan al soldar por clase los triángulos de 'semillas'
+// semillas subdivididas 'profundidad' veces, para la capacidad del soldador. Casi todos
+// los vértices interiores los comparten varios triángulos y hay menos vértices que
+// triángulos; lo que sobra son los vértices repetidos entre las dos clases en la
+// frontera de cada región, que crece como goldenRatio^profundidad.
+size_t cotaVerticesSoldados(uint64_t triangulos, int profundidad, int semillas = 1);
+
+#endif
@@ -0,0 +1,358 @@
+/*
+* Reglas de sustitución y sus kernels especializados.
+*
+* Para agregar una teselación: se escriben sus reglas como las de abajo (con constexpr,
+* para que el compilador vea todos los coeficientes), se agregan a TABLA_REGLAS y se
+* revisan con validarReglas(); Main.cpp lo hace al escogerlas con --reglas.
+*/
+#include "Sustitucion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "VectoresSimd.h"
+
+using namespace std;
+
+// goldenRatio no es constexpr (usa sqrt); éste es el mismo double.
+static constexpr double PHI = 1.6180339887498948482;
+static constexpr double RAIZ_CINCO = 2.2360679774997896964;
+
+// Rombos (P3), las mismas reglas y el mismo orden de hijos que subdividir(). El tipo
+// cero tiene 36 grados en A y el tipo uno 108; los dos tienen lados AB y AC de 1.
+static constexpr ReglasSustitucion REGLAS_P3 = {
+    "p3", "rombos de Penrose (P3)", 2, PHI,
+    { { 0, 0, 1, 0, 0.80901699437494742410, 0.58778525229247312917 },
+      { 0, 0, 1, 0, -0.30901699437494742410, 0.95105651629515357212 } },
+    { 2, 3 },
+    { { { 0, { vertice(VERTICE_C), haciaVertice(VERTICE_A, VERTICE_B, PHI), vertice(VERTICE_B) } },
+        { 1, { haciaVertice(VERTICE_A, VERTICE_B, PHI), vertice(VERTICE_C), vertice(VERTICE_A) } } },
+      { { 0, { haciaVertice(VERTICE_B, VERTICE_C, PHI), haciaVertice(VERTICE_B, VERTICE_A, PHI), vertice(VERTICE_A) } },
+        { 1, { haciaVertice(VERTICE_B, VERTICE_C, PHI), vertice(VERTICE_C), vertice(VERTICE_A) } },
+        { 1, { haciaVertice(VERTICE_B, VERTICE_A, PHI), haciaVertice(VERTICE_B, VERTICE_C, PHI), vertice(VERTICE_B) } } } }
+};
+
+// Cometas y dardos (P2). El tipo cero es media cometa (36 grados en A, lados AB y AC de
+// phi) y el tipo uno medio dardo (108 grados en A, lados AB y AC de 1). Las medias
+// cometas se juntan por AB y los medios dardos también, así que la rueda de
+// trianguloDeRueda() es el sol de cinco cometas.
+static constexpr ReglasSustitucion REGLAS_P2 = {
+    "p2", "cometas y dardos de Penrose (P2)", 2, PHI,
+    { { 0, 0, PHI, 0, PHI * 0.80901699437494742410, PHI * 0.58778525229247312917 },
+      { 0, 0, 1, 0, -0.30901699437494742410, 0.95105651629515357212 } },
+    { 3, 2 },
+    { { { 0, { vertice(VERTICE_C), haciaVertice(VERTICE_A, VERTICE_B, PHI), vertice(VERTICE_B) } },
+        { 0, { vertice(VERTICE_C), haciaVertice(VERTICE_A, VERTICE_B, PHI), haciaVertice(VERTICE_C, VERTICE_A, PHI) } },
+        { 1, { haciaVertice(VERTICE_C, VERTICE_A, PHI), vertice(VERTICE_A), haciaVertice(VERTICE_A, VERTICE_B, PHI) } } },
+      { { 0, { vertice(VERTICE_B), vertice(VERTICE_A), haciaVertice(VERTICE_B, VERTICE_C, PHI) } },
+        { 1, { haciaVertice(VERTICE_B, VERTICE_C, PHI), vertice(VERTICE_C), vertice(VERTICE_A) } } } }
+};
+
+// Molinete: un triángulo rectángulo de catetos 1 y 2 (A en el ángulo chico, B en el
+// recto) se parte en cinco copias reducidas raíz de cinco veces. La altura desde B
+// (F = A + (C - A) / 1.25) deja una copia y un triángulo del doble de tamaño, que se
+// parte en cuatro por los puntos medios. Los hijos salen girados en ángulos que no son
+// múltiplos racionales de pi, así que el molinete tiene orientaciones en todas
+// direcciones. No es de lado a lado (hay vértices a media arista del vecino), así que al
+// dibujarlo pueden verse grietas de un pixel.
+static constexpr PuntoRegla MOLINETE_F = haciaVertice(VERTICE_A, VERTICE_C, 1.25);
+static constexpr PuntoRegla MOLINETE_AB = haciaVertice(VERTICE_A, VERTICE_B, 2);
+static constexpr PuntoRegla MOLINETE_AF = haciaVertice(VERTICE_A, VERTICE_C, 2.5);
+static constexpr PuntoRegla MOLINETE_BF = haciaDosVertices(VERTICE_B, VERTICE_A, 10, VERTICE_C, 2.5);
+
+static constexpr ReglasSustitucion REGLAS_MOLINETE = {
+    "molinete", "molinete (pinwheel) de Conway y Radin", 1, RAIZ_CINCO,
+    { { 0, 0, 2, 0, 2, 1 } },
+    { 5 },
+    { { { 0, { vertice(VERTICE_B), MOLINETE_F, vertice(VERTICE_C) } },
+        { 0, { vertice(VERTICE_A), MOLINETE_AF, MOLINETE_AB } },
+        { 0, { MOLINETE_AB, MOLINETE_BF, vertice(VERTICE_B) } },
+        { 0, { MOLINETE_AF, MOLINETE_F, MOLINETE_BF } },
+        { 0, { MOLINETE_BF, MOLINETE_AB, MOLINETE_AF } } } }
+};
+
+// ------------------------------------------------------------------------------------
+// Kernel. Las reglas llegan como referencia constante en el parámetro de la plantilla,
+// así que cada coeficiente es una constante de compilación: los términos con divisor 0
+// desaparecen, los puntos que usan varios hijos se calculan una vez y lo que queda es la
+// misma secuencia de operaciones que el kernel escrito a mano.
+
+template <const ReglasSustitucion& R, int P, int K, int J>
+struct PuntoDe {
+    static constexpr int origen = R.hijos[P][K].v[J].origen;
+    static constexpr int hacia = R.hijos[P][K].v[J].hacia;
+    static constexpr double divisor = R.hijos[P][K].v[J].divisor;
+    static constexpr int hacia2 = R.hijos[P][K].v[J].hacia2;
+    static constexpr double divisor2 = R.hijos[P][K].v[J].divisor2;
+};
+
+template <const ReglasSustitucion& R, int P>
+struct HijosDe {
+    static constexpr int numero = P < R.numTipos ? R.numHijos[P] : 0;
+};
+
+template <class V, class Punto>
+static inline typename V::T evaluar(const typename V::T c[3]) {
+    typename V::T r = c[Punto::origen];
+    if (Punto::divisor != 0)
+        r = V::sumar(r, V::dividir(V::restar(c[Punto::hacia], c[Punto::origen]), Punto::divisor));
+    if (Punto::divisor2 != 0)
+        r = V::sumar(r, V::dividir(V::restar(c[Punto::hacia2], c[Punto::origen]), Punto::divisor2));
+    return r;
+}
+
+template <class V, const ReglasSustitucion& R, int P, int K>
+static inline void guardarHijo(const typename V::T x[3], const typename V::T y[3], const BloqueSoAT<typename V::Elem>& h,
+    size_t i) {
+    V::guardar(h.ax + i, evaluar<V, PuntoDe<R, P, K, 0> >(x)); V::guardar(h.ay + i, evaluar<V, PuntoDe<R, P, K, 0> >(y));
+    V::guardar(h.bx + i, evaluar<V, PuntoDe<R, P, K, 1> >(x)); V::guardar(h.by + i, evaluar<V, PuntoDe<R, P, K, 1> >(y));
+    V::guardar(h.cx + i, evaluar<V, PuntoDe<R, P, K, 2> >(x)); V::guardar(h.cy + i, evaluar<V, PuntoDe<R, P, K, 2> >(y));
+}
+
+template <class V, const ReglasSustitucion& R, int P, size_t... K>
+static inline void guardarHijos(const typename V::T x[3], const typename V::T y[3], const BloqueSoAT<typename V::Elem>* h,
+    size_t i, index_sequence<K...>) {
+    int expandir[] = { 0, (guardarHijo<V, R, P, (int)K>(x, y, h[K], i), 0)... };
+    (void)expandir;
+    (void)x; (void)y; (void)h; (void)i;    // Sin uso en los tipos que las reglas no tienen
+}
+
+// Todos los padres de tipo P de inicio a fin; h[k] es el bloque del hijo k.
+template <class V, const ReglasSustitucion& R, int P>
+static size_t kernelTipo(const BloqueSoAT<typename V::Elem>& p, size_t inicio, size_t fin, const BloqueSoAT<typename V::Elem>* h) {
+    typedef typename V::T T;
+    size_t i = inicio;
+    for (; i + V::ancho <= fin; i += V::ancho) {
+        T x[3] = { V::cargar(p.ax + i), V::cargar(p.bx + i), V::cargar(p.cx + i) };
+        T y[3] = { V::cargar(p.ay + i), V::cargar(p.by + i), V::cargar(p.cy + i) };
+        guardarHijos<V, R, P>(x, y, h, i, make_index_sequence<HijosDe<R, P>::numero>());
+    }
+    return i;
+}
+
+// Reparte el destino en los bloques de hijos y deja sus tamaños.
+template <typename S, const ReglasSustitucion& R>
+static void bloquesDeHijos(const GeneracionT<S>& origen, GeneracionT<S>& destino,
+    BloqueSoAT<S> h[MAX_TIPOS_SUSTITUCION][MAX_HIJOS_SUSTITUCION]) {
+    const size_t padres[2] = { origen.numCeros, R.numTipos > 1 ? origen.numUnos : 0 };
+    size_t usados[2] = { 0, 0 };
+    for (int p = 0; p < R.numTipos; p++) {
+        for (int k = 0; k < R.numHijos[p]; k++) {
+            int t = R.hijos[p][k].tipo;
+            h[p][k] = (t == 0 ? destino.ceros : destino.unos).desde(usados[t]);
+            usados[t] += padres[p];
+        }
+    }
+    destino.numCeros = usados[0];
+    destino.numUnos = usados[1];
+}
+
+// Procesa los padres de inicio a fin de cada tipo, con registros completos y lo que
+// sobra en escalar.
+template <typename S, const ReglasSustitucion& R>
+static void subdividirRango(const GeneracionT<S>& origen, const size_t inicio[2], const size_t fin[2],
+    BloqueSoAT<S> h[MAX_TIPOS_SUSTITUCION][MAX_HIJOS_SUSTITUCION]) {
+    typedef typename VecDe<S>::Simd Simd;
+    typedef VecEscalar<S> Esc;
+    size_t i = kernelTipo<Simd, R, 0>(origen.ceros, inicio[0], fin[0], h[0]);
+    kernelTipo<Esc, R, 0>(origen.ceros, i, fin[0], h[0]);
+    if (R.numTipos > 1) {
+        i = kernelTipo<Simd, R, 1>(origen.unos, inicio[1], fin[1], h[1]);
+        kernelTipo<Esc, R, 1>(origen.unos, i, fin[1], h[1]);
+    }
+}
+
+template <typename S, const ReglasSustitucion& R>
+static void subdividirCon(const GeneracionT<S>& origen, GeneracionT<S>& destino) {
+    BloqueSoAT<S> h[MAX_TIPOS_SUSTITUCION][MAX_HIJOS_SUSTITUCION];
+    bloquesDeHijos<S, R>(origen, destino, h);
+    const size_t inicio[2] = { 0, 0 };
+    const size_t fin[2] = { origen.numCeros, origen.numUnos };
+    subdividirRango<S, R>(origen, inicio, fin, h);
+}
+
+// Igual que subdividirParalelo(): pedazos de padres de cada tipo, redondeados a múltiplos
+// de 8, y debajo de TAM_PEDAZO_SUSTITUCION en serie.
+static const size_t TAM_PEDAZO_SUSTITUCION = 16384;
+
+template <typename S, const ReglasSustitucion& R>
+static void subdividirConParalelo(const GeneracionT<S>& origen, GeneracionT<S>& destino, PoolHilos& hilos) {
+    const size_t z = origen.numCeros;
+    const size_t u = origen.numUnos;
+    if (hilos.tamano() == 1 || z + u < 2 * TAM_PEDAZO_SUSTITUCION) {
+        subdividirCon<S, R>(origen, destino);
+        return;
+    }
+
+    BloqueSoAT<S> h[MAX_TIPOS_SUSTITUCION][MAX_HIJOS_SUSTITUCION];
+    bloquesDeHijos<S, R>(origen, destino, h);
+    size_t numPedazos = 4 * (size_t)hilos.tamano();
+    size_t pedazo[2] = { (z + numPedazos - 1) / numPedazos, (u + numPedazos - 1) / numPedazos };
+    for (int t = 0; t < 2; t++)
+        pedazo[t] = (max(pedazo[t], (size_t)1) + 7) & ~(size_t)7;
+
+    hilos.paraCada(numPedazos, [&](size_t k) {
+        const size_t inicio[2] = { min(k * pedazo[0], z), min(k * pedazo[1], u) };
+        const size_t fin[2] = { min(inicio[0] + pedazo[0], z), min(inicio[1] + pedazo[1], u) };
+        subdividirRango<S, R>(origen, inicio, fin, h);
+    });
+}
+
+template <typename S, const ReglasSustitucion& R>
+static KernelSustitucionT<S> kernelDe() {
+    KernelSustitucionT<S> k;
+    memset(k.hijos, 0, sizeof(k.hijos));
+    for (int p = 0; p < R.numTipos; p++)
+        for (int j = 0; j < R.numHijos[p]; j++)
+            k.hijos[p][R.hijos[p][j].tipo]++;
+    k.serie = &subdividirCon<S, R>;
+    k.paralelo = &subdividirConParalelo<S, R>;
+    return k;
+}
+
+// ------------------------------------------------------------------------------------
+
+struct EntradaReglas {
+    const ReglasSustitucion* reglas;
+    KernelSustitucionT<double> kernelDouble;
+    KernelSustitucionT<float> kernelFloat;
+    KernelSustitucionT<Fijo32> kernelFijo;
+};
+
+static const EntradaReglas TABLA_REGLAS[] = {
+    { &REGLAS_P3, kernelDe<double, REGLAS_P3>(), kernelDe<float, REGLAS_P3>(), kernelDe<Fijo32, REGLAS_P3>() },
+    { &REGLAS_P2, kernelDe<double, REGLAS_P2>(), kernelDe<float, REGLAS_P2>(), kernelDe<Fijo32, REGLAS_P2>() },
+    { &REGLAS_MOLINETE, kernelDe<double, REGLAS_MOLINETE>(), kernelDe<float, REGLAS_MOLINETE>(),
+        kernelDe<Fijo32, REGLAS_MOLINETE>() },
+};
+
+static const EntradaReglas* buscarEntrada(const ReglasSustitucion& reglas) {
+    for (const EntradaReglas& e : TABLA_REGLAS)
+        if (e.reglas == &reglas)
+            return &e;
+    return nullptr;
+}
+
+const ReglasSustitucion* buscarReglas(const char* nombre) {
+    for (const EntradaReglas& e : TABLA_REGLAS)
+        if (strcmp(e.reglas->nombre, nombre) == 0)
+            return e.reglas;
+    return nullptr;
+}
+
+string nombresDeReglas() {
+    string nombres;
+    for (const EntradaReglas& e : TABLA_REGLAS) {
+        if (!nombres.empty())
+            nombres += ", ";
+        nombres += e.reglas->nombre;
+    }
+    return nombres;
+}
+
+template <>
+const KernelSustitucionT<double>* kernelSustitucion<double>(const ReglasSustitucion& reglas) {
+    const EntradaReglas* e = buscarEntrada(reglas);
+    return e ? &e->kernelDouble : nullptr;
+}
+
+template <>
+const KernelSustitucionT<float>* kernelSustitucion<float>(const ReglasSustitucion& reglas) {
+    const EntradaReglas* e = buscarEntrada(reglas);
+    return e ? &e->kernelFloat : nullptr;
+}
+
+template <>
+const KernelSustitucionT<Fijo32>* kernelSustitucion<Fijo32>(const ReglasSustitucion& reglas) {
+    const EntradaReglas* e = buscarEntrada(reglas);
+    return e ? &e->kernelFijo : nullptr;
+}
+
+// ------------------------------------------------------------------------------------
+
+triangulo prototipo(const ReglasSustitucion& reglas, int tipo) {
+    const double* v = reglas.prototipos[tipo];
+    triangulo t = { tipo, complex<double>(v[0], v[1]), complex<double>(v[2], v[3]), complex<double>(v[4], v[5]) };
+    return t;
+}
+
+triangulo semillaDeSector(const ReglasSustitucion& reglas) {
+    triangulo p = prototipo(reglas, 0);
+    complex<double> ab = p.B - p.A, ac = p.C - p.A;
+    if (fabs(abs(ab) - abs(ac)) < 1e-9 * abs(ab) && fabs(fabs(arg(ac / ab)) - pi / 5) < 1e-9)
+        return trianguloDeRueda(0);
+
+    complex<double> giro = polar(1 / abs(ac), -0.5 * (arg(ab) + arg(ac)));
+    triangulo t = { 0, complex<double>(0, 0), ab * giro, ac * giro };
+    return t;
+}
+
+static complex<double> evaluarPunto(const PuntoRegla& p, const complex<double> v[3]) {
+    complex<double> r = v[p.origen];
+    if (p.divisor != 0)
+        r += (v[p.hacia] - v[p.origen]) / p.divisor;
+    if (p.divisor2 != 0)
+        r += (v[p.hacia2] - v[p.origen]) / p.divisor2;
+    return r;
+}
+
+static double area(const complex<double>& a, const complex<double>& b, const complex<double>& c) {
+    return 0.5 * fabs((conj(b - a) * (c - a)).imag());
+}
+
+bool validarReglas(const ReglasSustitucion& reglas, string* error) {
+    const double TOLERANCIA = 1e-9;
+    char mensaje[256];
+    auto fallar = [&](const char* texto) {
+        if (error)
+            *error = string(reglas.nombre) + ": " + texto;
+        return false;
+    };
+    if (reglas.numTipos < 1 || reglas.numTipos > MAX_TIPOS_SUSTITUCION || reglas.factor <= 1)
+        return fallar("número de tipos o factor inválido");
+
+    for (int p = 0; p < reglas.numTipos; p++) {
+        if (reglas.numHijos[p] < 1 || reglas.numHijos[p] > MAX_HIJOS_SUSTITUCION)
+            return fallar("número de hijos inválido");
+        triangulo padre = prototipo(reglas, p);
+        const complex<double> v[3] = { padre.A, padre.B, padre.C };
+        double areaPadre = area(v[0], v[1], v[2]), suma = 0;
+        for (int k = 0; k < reglas.numHijos[p]; k++) {
+            const HijoRegla& hijo = reglas.hijos[p][k];
+            if (hijo.tipo < 0 || hijo.tipo >= reglas.numTipos)
+                return fallar("tipo de hijo inválido");
+            triangulo forma = prototipo(reglas, hijo.tipo);
+            const complex<double> f[3] = { forma.A, forma.B, forma.C };
+            complex<double> h[3];
+            for (int j = 0; j < 3; j++) {
+                const PuntoRegla& pr = hijo.v[j];
+                if (pr.origen < 0 || pr.origen > 2 || pr.hacia < 0 || pr.hacia > 2 || pr.hacia2 < 0 || pr.hacia2 > 2)
+                    return fallar("vértice de padre inválido");
+                h[j] = evaluarPunto(pr, v);
+                // Dentro del padre: las tres coordenadas baricéntricas entre 0 y 1.
+                double b0 = area(h[j], v[1], v[2]) / areaPadre, b1 = area(v[0], h[j], v[2]) / areaPadre,
+                    b2 = area(v[0], v[1], h[j]) / areaPadre;
+                if (fabs(b0 + b1 + b2 - 1) > TOLERANCIA) {
+                    snprintf(mensaje, sizeof(mensaje), "el hijo %d del tipo %d se sale del padre", k, p);
+                    return fallar(mensaje);
+                }
+            }
+            for (int j = 0; j < 3; j++) {
+                double lado = abs(h[(j + 1) % 3] - h[j]), esperado = abs(f[(j + 1) % 3] - f[j]) / reglas.factor;
+                if (fabs(lado - esperado) > TOLERANCIA * max(1.0, esperado)) {
+                    snprintf(mensaje, sizeof(mensaje), "el hijo %d del tipo %d no es su prototipo reducido (lado %d: %g en lugar de %g)",
+                        k, p, j, lado, esperado);
+                    return fallar(mensaje);
+                }
+            }
+            suma += area(h[0], h[1], h[2]);
+        }
+        if (fabs(suma - areaPadre) > TOLERANCIA * areaPadre) {
+            snprintf(mensaje, sizeof(mensaje), "los hijos del tipo %d cubren %g del área %g del padre", p, suma, areaPadre);
+            return fallar(mensaje);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+/*
+* Reglas de sustitución como datos. Una teselación por sustitución con triángulos se
+* describe con sus prototipos, el factor de escala y, para cada tipo, dónde quedan sus
+* hijos; a partir de esa descripción se instancia en tiempo de compilación un kernel de
+* subdivisión especializado, igual de rápido que el escrito a mano para Penrose.
+*/
+#ifndef SUSTITUCION_H
+#define SUSTITUCION_H
+
+#include <string>
+
+#include "Penrose.h"
+
+// Los triángulos siguen siendo de dos tipos (ceros y unos, que se dibujan con dos
+// colores), así que caben en GeneracionT y en ArenaTriangulosT.
+const int MAX_TIPOS_SUSTITUCION = 2;
+const int MAX_HIJOS_SUSTITUCION = 8;
+
+// Vértices del padre.
+enum VerticePadre {
+    VERTICE_A = 0,
+    VERTICE_B,
+    VERTICE_C
+};
+
+// Un vértice de un hijo en términos de los del padre:
+//   origen + (hacia - origen) / divisor + (hacia2 - origen) / divisor2
+// donde un divisor 0 quita su término. Con un solo término es el punto que divide la
+// arista de origen a hacia, que es lo que usan casi todas las reglas; el segundo
+// permite cualquier punto del plano del padre. Se divide (en lugar de multiplicar por la
+// fracción) para que las reglas de Penrose den exactamente los mismos vértices que
+// subdividir().
+struct PuntoRegla {
+    int origen;
+    int hacia;
+    double divisor;
+    int hacia2;
+    double divisor2;
+};
+
+constexpr PuntoRegla vertice(int v) {
+    return PuntoRegla{ v, v, 0, v, 0 };
+}
+constexpr PuntoRegla haciaVertice(int origen, int hacia, double divisor) {
+    return PuntoRegla{ origen, hacia, divisor, origen, 0 };
+}
+constexpr PuntoRegla haciaDosVertices(int origen, int hacia, double divisor, int hacia2, double divisor2) {
+    return PuntoRegla{ origen, hacia, divisor, hacia2, divisor2 };
+}
+
+struct HijoRegla {
+    int tipo;
+    PuntoRegla v[3];    // Sus vértices A, B y C
+};
+
+// Un conjunto de reglas. Los prototipos fijan la forma y el tamaño relativo de los
+// tipos: al subdividir, cada hijo de tipo t es su prototipo reducido 'factor' veces
+// (reflejado o no), con los vértices en el mismo orden; validarReglas() lo revisa.
+struct ReglasSustitucion {
+    const char* nombre;
+    const char* descripcion;
+    int numTipos;
+    double factor;
+    double prototipos[MAX_TIPOS_SUSTITUCION][6];   // Ax, Ay, Bx, By, Cx, Cy
+    int numHijos[MAX_TIPOS_SUSTITUCION];
+    HijoRegla hijos[MAX_TIPOS_SUSTITUCION][MAX_HIJOS_SUSTITUCION];
+};
+
+// Reglas con kernel compilado, por nombre: "p3" (rombos, las mismas de subdividir()),
+// "p2" (cometas y dardos) y "molinete" (el pinwheel de Conway y Radin, de un solo tipo).
+// Regresa nullptr si no hay reglas con ese nombre.
+const ReglasSustitucion* buscarReglas(const char* nombre);
+// Nombres de todas, separados por comas, para los mensajes.
+std::string nombresDeReglas();
+
+// Revisa que cada hijo sea su prototipo reducido 'factor' veces, que quede dentro del
+// padre y que las áreas de los hijos sumen la del padre (o sea, que lo cubran sin
+// encimarse). Si algo no cuadra regresa false y lo describe en 'error'.
+bool validarReglas(const ReglasSustitucion& reglas, std::string* error = nullptr);
+
+// Prototipo de un tipo como triángulo.
+triangulo prototipo(const ReglasSustitucion& reglas, int tipo);
+
+// Triángulo con el que empieza el sector 0 de la rueda. Si el tipo cero tiene 36 grados
+// en A y AB = AC (como en P3 y P2) es trianguloDeRueda(0) y los diez sectores forman la
+// rueda; si no, es el prototipo del tipo cero con A en el origen, AC de 1 y el ángulo de
+// A partido por el eje x, y entre los sectores quedan huecos o se enciman.
+triangulo semillaDeSector(const ReglasSustitucion& reglas);
+
+// Kernel especializado de unas reglas de buscarReglas() para coordenadas de tipo S
+// (double, float o Fijo32), para pasárselo a ArenaTriangulosT. Como el de subdividir(),
+// cada tipo de padre se procesa en un solo ciclo sin ramas, vectorizado, y los hijos
+// quedan en bloques contiguos: para cada tipo de hijo, un bloque por cada (tipo del
+// padre, número de hijo) en ese orden, con el hijo del padre i en la posición i.
+template <typename S>
+const KernelSustitucionT<S>* kernelSustitucion(const ReglasSustitucion& reglas);
+
+#endif
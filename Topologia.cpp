@@ -0,0 +1,164 @@
+/*
+* Topología de la teselación.
+*/
+#include "Topologia.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+const uint32_t TopologiaTeselacion::SIN_VECINO;
+
+// Media arista: la opuesta a una esquina, con la llave de sus dos vértices (el menor
+// arriba).
+struct MediaArista {
+    uint64_t llave;
+    uint32_t esquina;
+};
+
+static void minimoAtomico(atomic<uint32_t>& a, uint32_t v) {
+    uint32_t actual = a.load(memory_order_relaxed);
+    while (v < actual && !a.compare_exchange_weak(actual, v, memory_order_relaxed)) {
+    }
+}
+
+TopologiaTeselacion::TopologiaTeselacion(const VerticeEmpacado* vertices, size_t numVertices, const uint32_t* indices,
+    size_t numIndices, PoolHilos& hilos) {
+    const size_t n = numIndices / 3;
+    const size_t numPedazos = min<size_t>(4 * (size_t)hilos.tamano(), (3 * n + numVertices) / 4096 + 1);
+
+    // 1. Los vértices con la misma posición (de distinta clase) se unen en el de menor
+    //    índice: ordenados por posición e índice, es el primero de cada tramo.
+    vector<uint64_t> posiciones(numVertices);
+    const size_t tamV = (numVertices + numPedazos - 1) / numPedazos;
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        for (size_t v = p * tamV; v < min(numVertices, (p + 1) * tamV); v++) {
+            uint32_t pos = ((uint32_t)(uint16_t)vertices[v].x << 16) | (uint16_t)vertices[v].y;
+            posiciones[v] = ((uint64_t)pos << 32) | v;
+        }
+    });
+    ordenarParalelo(posiciones, hilos, [](uint64_t a, uint64_t b) { return a < b; });
+    representante.resize(numVertices);
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        size_t inicio = min(numVertices, p * tamV), fin = min(numVertices, (p + 1) * tamV);
+        if (inicio == fin)
+            return;
+        // El tramo puede empezar en el pedazo anterior.
+        size_t primero = inicio;
+        while (primero > 0 && posiciones[primero - 1] >> 32 == posiciones[inicio] >> 32)
+            primero--;
+        uint32_t rep = (uint32_t)posiciones[primero];
+        for (size_t i = inicio; i < fin; i++) {
+            if (posiciones[i] >> 32 != posiciones[primero] >> 32) {
+                primero = i;
+                rep = (uint32_t)posiciones[i];
+            }
+            representante[(uint32_t)posiciones[i]] = rep;
+        }
+    });
+    vector<uint64_t>().swap(posiciones);
+
+    // 2. Esquinas en sentido contrario a las manecillas, con los vértices unidos, y la
+    //    media arista opuesta a cada una.
+    esquinas.resize(3 * n);
+    vector<MediaArista> medias(3 * n);
+    const size_t tamT = (n + numPedazos - 1) / numPedazos;
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        for (size_t t = p * tamT; t < min(n, (p + 1) * tamT); t++) {
+            uint32_t v[3] = { indices[3 * t], indices[3 * t + 1], indices[3 * t + 2] };
+            const VerticeEmpacado &a = vertices[v[0]], &b = vertices[v[1]], &c = vertices[v[2]];
+            if ((int64_t)(b.x - a.x) * (c.y - a.y) - (int64_t)(b.y - a.y) * (c.x - a.x) < 0)
+                swap(v[1], v[2]);
+            for (int k = 0; k < 3; k++)
+                esquinas[3 * t + k] = representante[v[k]];
+            for (int k = 0; k < 3; k++) {
+                uint32_t d = esquinas[3 * t + (k + 1) % 3], h = esquinas[3 * t + (k + 2) % 3];
+                MediaArista m = { ((uint64_t)min(d, h) << 32) | max(d, h), (uint32_t)(3 * t + k) };
+                medias[3 * t + k] = m;
+            }
+        }
+    });
+
+    // 3. Las medias aristas con la misma llave quedan juntas; si son exactamente dos y
+    //    van en sentidos contrarios, sus esquinas son opuestas.
+    ordenarParalelo(medias, hilos, [](const MediaArista& a, const MediaArista& b) { return a.llave < b.llave; });
+    opuestas.assign(3 * n, SIN_VECINO);
+    const size_t numMedias = medias.size();
+    const size_t tamM = (numMedias + numPedazos - 1) / numPedazos;
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        for (size_t i = p * tamM; i < min(numMedias, (p + 1) * tamM); i++) {
+            if (i > 0 && medias[i - 1].llave == medias[i].llave)
+                continue;   // No empieza tramo
+            if (i + 1 >= numMedias || medias[i + 1].llave != medias[i].llave)
+                continue;   // Borde
+            if (i + 2 < numMedias && medias[i + 2].llave == medias[i].llave)
+                continue;   // Más de dos triángulos
+            uint32_t c1 = medias[i].esquina, c2 = medias[i + 1].esquina;
+            if (esquinas[siguiente(c1)] != esquinas[previa(c2)])
+                continue;   // Misma orientación
+            opuestas[c1] = c2;
+            opuestas[c2] = c1;
+        }
+    });
+    vector<MediaArista>().swap(medias);
+
+    // 4. Una esquina por vértice: la de menor número, o si el vértice está en el borde,
+    //    la menor de las que empiezan un abanico.
+    vector<atomic<uint32_t> > cualquiera(numVertices), deBorde(numVertices);
+    for (size_t v = 0; v < numVertices; v++) {
+        cualquiera[v].store(SIN_VECINO, memory_order_relaxed);
+        deBorde[v].store(SIN_VECINO, memory_order_relaxed);
+    }
+    hilos.paraCada(numPedazos, [&](size_t p) {
+        for (size_t c = 3 * p * tamT; c < min(3 * n, 3 * (p + 1) * tamT); c++) {
+            uint32_t v = esquinas[c];
+            minimoAtomico(cualquiera[v], (uint32_t)c);
+            if (girarDerecha((uint32_t)c) == SIN_VECINO)
+                minimoAtomico(deBorde[v], (uint32_t)c);
+        }
+    });
+    esquinaDeVertice.resize(numVertices);
+    for (size_t v = 0; v < numVertices; v++) {
+        uint32_t b = deBorde[v].load(memory_order_relaxed);
+        esquinaDeVertice[v] = b != SIN_VECINO ? b : cualquiera[v].load(memory_order_relaxed);
+    }
+
+    // 5. Los contornos del borde, que son pocos: el borde crece como la raíz del número
+    //    de triángulos.
+    vector<bool> visitada;
+    primerDeContorno.push_back(0);
+    for (size_t c = 0; c < 3 * n; c++) {
+        if (opuestas[c] != SIN_VECINO)
+            continue;
+        if (visitada.empty())
+            visitada.assign(3 * n, false);
+        if (visitada[c])
+            continue;
+        uint32_t e = (uint32_t)c;
+        do {
+            visitada[e] = true;
+            esquinasDeBorde.push_back(e);
+            e = siguienteEnBorde(e);
+        } while (e != SIN_VECINO && !visitada[e]);
+        primerDeContorno.push_back((uint32_t)esquinasDeBorde.size());
+    }
+}
+
+uint32_t TopologiaTeselacion::siguienteEnBorde(uint32_t c) const {
+    // La arista de c llega a vertice(previa(c)); la siguiente sale de él, del último
+    // triángulo de su abanico en el sentido de las manecillas.
+    uint32_t d = previa(c);
+    for (size_t vueltas = 0; vueltas < esquinas.size(); vueltas++) {
+        uint32_t sig = girarDerecha(d);
+        if (sig == SIN_VECINO)
+            return previa(d);
+        d = sig;
+    }
+    return SIN_VECINO;
+}
+
+size_t TopologiaTeselacion::bytes() const {
+    return (esquinas.capacity() + opuestas.capacity() + representante.capacity() + esquinaDeVertice.capacity() +
+        esquinasDeBorde.capacity() + primerDeContorno.capacity()) * sizeof(uint32_t);
+}
@@ -0,0 +1,114 @@
+/*
+* Topología de la teselación: tabla de esquinas construida a partir del buffer soldado,
+* con consultas de vecinos, estrella de un vértice y contornos del borde en tiempo
+* constante (o proporcional al grado del vértice, que en Penrose es acotado).
+*/
+#ifndef TOPOLOGIA_H
+#define TOPOLOGIA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hilos.h"
+#include "Vertice.h"
+
+// Tabla de esquinas: la esquina c = 3 * t + k es el k-ésimo vértice del triángulo t, y
+// su lado opuesto es la arista entre las otras dos esquinas. Cada esquina guarda la
+// esquina opuesta del triángulo vecino del otro lado de esa arista, así que los vecinos
+// y el recorrido alrededor de un vértice no necesitan buscar nada.
+//
+// Los triángulos conservan su número del buffer de entrada (el color del triángulo t
+// sigue siendo la clase de sus vértices en ese buffer), pero sus esquinas se reordenan
+// para que todos queden en sentido contrario a las manecillas del reloj. Los vértices
+// se identifican por posición: el soldador suelda por clase, así que un punto donde se
+// tocan los dos colores tiene un índice por color; aquí los dos se cuentan como el mismo
+// vértice (el de menor índice) y los triángulos de distinto color también son vecinos.
+//
+// Se construye en paralelo ordenando llaves: las posiciones para unir los vértices y
+// las aristas para emparejar las esquinas. Una arista que comparten más de dos
+// triángulos, o dos con la misma orientación, se toma como borde.
+class TopologiaTeselacion {
+public:
+    static const uint32_t SIN_VECINO = 0xFFFFFFFFu;
+
+    TopologiaTeselacion(const VerticeEmpacado* vertices, size_t numVertices, const uint32_t* indices, size_t numIndices,
+        PoolHilos& hilos);
+
+    size_t numTriangulos() const { return esquinas.size() / 3; }
+    size_t numVertices() const { return esquinaDeVertice.size(); }
+
+    static uint32_t triangulo(uint32_t c) { return c / 3; }
+    static uint32_t siguiente(uint32_t c) { return c % 3 == 2 ? c - 2 : c + 1; }
+    static uint32_t previa(uint32_t c) { return c % 3 == 0 ? c + 2 : c - 1; }
+
+    // Vértice de la esquina c (ya unido con los de la misma posición).
+    uint32_t vertice(uint32_t c) const { return esquinas[c]; }
+    // Vértice que representa a un índice del buffer de entrada.
+    uint32_t unido(uint32_t v) const { return representante[v]; }
+
+    // Esquina del vecino al otro lado de la arista opuesta a c, o SIN_VECINO en el borde.
+    uint32_t opuesta(uint32_t c) const { return opuestas[c]; }
+    // Triángulo al otro lado de la arista opuesta a la esquina k de t, o SIN_VECINO.
+    uint32_t vecino(uint32_t t, int k) const {
+        uint32_t o = opuestas[3 * t + k];
+        return o == SIN_VECINO ? SIN_VECINO : o / 3;
+    }
+
+    // La esquina del mismo vértice en el triángulo siguiente alrededor de él, en sentido
+    // contrario a las manecillas (o en el sentido de ellas), o SIN_VECINO si ahí está el
+    // borde.
+    uint32_t girarIzquierda(uint32_t c) const {
+        uint32_t o = opuestas[siguiente(c)];
+        return o == SIN_VECINO ? SIN_VECINO : siguiente(o);
+    }
+    uint32_t girarDerecha(uint32_t c) const {
+        uint32_t o = opuestas[previa(c)];
+        return o == SIN_VECINO ? SIN_VECINO : previa(o);
+    }
+
+    // Una esquina del vértice v (unido), o SIN_VECINO si no es representante o no está en
+    // ningún triángulo. Si v está en el borde es la primera en sentido contrario a las
+    // manecillas, así que girando a la izquierda desde ella se recorre toda su estrella.
+    uint32_t esquinaDe(uint32_t v) const { return esquinaDeVertice[v]; }
+    bool enBorde(uint32_t v) const {
+        uint32_t c = esquinaDeVertice[v];
+        return c != SIN_VECINO && girarDerecha(c) == SIN_VECINO;
+    }
+
+    // Llama f(c) con cada esquina del vértice v, en sentido contrario a las manecillas. Si
+    // el borde toca a v dos veces (un pellizco) sólo recorre el primer abanico.
+    template <class F>
+    void estrella(uint32_t v, F f) const {
+        uint32_t inicio = esquinaDeVertice[v];
+        if (inicio == SIN_VECINO)
+            return;
+        uint32_t c = inicio;
+        do {
+            f(c);
+            c = girarIzquierda(c);
+        } while (c != SIN_VECINO && c != inicio);
+    }
+
+    // Contornos del borde. Una esquina de borde es una cuya arista opuesta no tiene
+    // vecino; esa arista va de vertice(siguiente(c)) a vertice(previa(c)) con la
+    // teselación a la izquierda. Cada contorno es la lista de sus esquinas de borde en
+    // orden: el exterior en sentido contrario a las manecillas y los hoyos al revés.
+    size_t numContornos() const { return primerDeContorno.size() - 1; }
+    const uint32_t* contorno(size_t i) const { return &esquinasDeBorde[primerDeContorno[i]]; }
+    size_t tamContorno(size_t i) const { return primerDeContorno[i + 1] - primerDeContorno[i]; }
+    // La esquina de borde que sigue a c en su contorno.
+    uint32_t siguienteEnBorde(uint32_t c) const;
+
+    size_t bytes() const;
+
+private:
+    std::vector<uint32_t> esquinas;
+    std::vector<uint32_t> opuestas;
+    std::vector<uint32_t> representante;
+    std::vector<uint32_t> esquinaDeVertice;
+    std::vector<uint32_t> esquinasDeBorde;
+    std::vector<uint32_t> primerDeContorno;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+* Envolturas mínimas sobre los registros vectoriales (AVX, SSE2 o escalar, según lo que
+* tenga habilitado el compilador) para escribir cada kernel de subdivisión una sola vez.
+* Sólo la incluyen los .cpp de los kernels.
+*/
+#ifndef VECTORES_SIMD_H
+#define VECTORES_SIMD_H
+
+#include <cstdint>
+
+#include "Penrose.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PENROSE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PENROSE_SSE2
+#endif
+
+// Todas las cargas son no alineadas porque los bloques de hijos empiezan en
+// desplazamientos arbitrarios (numCeros, numCeros + numUnos, ...).
+template <typename S>
+struct VecEscalar {
+    typedef S Elem;
+    typedef S T;
+    static const int ancho = 1;
+    static T cargar(const S* p) { return *p; }
+    static void guardar(S* p, T v) { *p = v; }
+    static T sumar(T a, T b) { return a + b; }
+    static T restar(T a, T b) { return a - b; }
+    // Se divide entre goldenRatio (en lugar de multiplicar por su inverso) para que en
+    // double el resultado sea exactamente el mismo que el de la versión con
+    // complex<double>.
+    static T entrePhi(T d) { return d / (S)goldenRatio; }
+    static T dividir(T d, double divisor) { return d / (S)divisor; }
+};
+
+// 1 / phi en punto fijo.
+static const int64_t INV_PHI_FIJO = (int64_t)(1.0 / goldenRatio * (double)(1 << Fijo32::BITS) + 0.5);
+
+template <>
+struct VecEscalar<Fijo32> {
+    typedef Fijo32 Elem;
+    typedef Fijo32 T;
+    static const int ancho = 1;
+    static T cargar(const Fijo32* p) { return *p; }
+    static void guardar(Fijo32* p, T v) { *p = v; }
+    static T sumar(T a, T b) { T r = { a.v + b.v }; return r; }
+    static T restar(T a, T b) { T r = { a.v - b.v }; return r; }
+    // Producto de 64 bits redondeado al más cercano.
+    static T entrePhi(T d) {
+        T r = { (int32_t)(((int64_t)d.v * INV_PHI_FIJO + ((int64_t)1 << (Fijo32::BITS - 1))) >> Fijo32::BITS) };
+        return r;
+    }
+    // Igual, con el inverso calculado como INV_PHI_FIJO. Con un divisor constante el
+    // compilador lo calcula de antemano.
+    static T dividir(T d, double divisor) {
+        const int64_t inverso = (int64_t)(1.0 / divisor * (double)(1 << Fijo32::BITS) + 0.5);
+        T r = { (int32_t)(((int64_t)d.v * inverso + ((int64_t)1 << (Fijo32::BITS - 1))) >> Fijo32::BITS) };
+        return r;
+    }
+};
+
+#if defined(PENROSE_AVX)
+struct VecSimdDouble {
+    typedef double Elem;
+    typedef __m256d T;
+    static const int ancho = 4;
+    static T cargar(const double* p) { return _mm256_loadu_pd(p); }
+    static void guardar(double* p, T v) { _mm256_storeu_pd(p, v); }
+    static T sumar(T a, T b) { return _mm256_add_pd(a, b); }
+    static T restar(T a, T b) { return _mm256_sub_pd(a, b); }
+    static T entrePhi(T d) { return _mm256_div_pd(d, _mm256_set1_pd(goldenRatio)); }
+    static T dividir(T d, double divisor) { return _mm256_div_pd(d, _mm256_set1_pd(divisor)); }
+};
+struct VecSimdFloat {
+    typedef float Elem;
+    typedef __m256 T;
+    static const int ancho = 8;
+    static T cargar(const float* p) { return _mm256_loadu_ps(p); }
+    static void guardar(float* p, T v) { _mm256_storeu_ps(p, v); }
+    static T sumar(T a, T b) { return _mm256_add_ps(a, b); }
+    static T restar(T a, T b) { return _mm256_sub_ps(a, b); }
+    static T entrePhi(T d) { return _mm256_div_ps(d, _mm256_set1_ps((float)goldenRatio)); }
+    static T dividir(T d, double divisor) { return _mm256_div_ps(d, _mm256_set1_ps((float)divisor)); }
+};
+#elif defined(PENROSE_SSE2)
+struct VecSimdDouble {
+    typedef double Elem;
+    typedef __m128d T;
+    static const int ancho = 2;
+    static T cargar(const double* p) { return _mm_loadu_pd(p); }
+    static void guardar(double* p, T v) { _mm_storeu_pd(p, v); }
+    static T sumar(T a, T b) { return _mm_add_pd(a, b); }
+    static T restar(T a, T b) { return _mm_sub_pd(a, b); }
+    static T entrePhi(T d) { return _mm_div_pd(d, _mm_set1_pd(goldenRatio)); }
+    static T dividir(T d, double divisor) { return _mm_div_pd(d, _mm_set1_pd(divisor)); }
+};
+struct VecSimdFloat {
+    typedef float Elem;
+    typedef __m128 T;
+    static const int ancho = 4;
+    static T cargar(const float* p) { return _mm_loadu_ps(p); }
+    static void guardar(float* p, T v) { _mm_storeu_ps(p, v); }
+    static T sumar(T a, T b) { return _mm_add_ps(a, b); }
+    static T restar(T a, T b) { return _mm_sub_ps(a, b); }
+    static T entrePhi(T d) { return _mm_div_ps(d, _mm_set1_ps((float)goldenRatio)); }
+    static T dividir(T d, double divisor) { return _mm_div_ps(d, _mm_set1_ps((float)divisor)); }
+};
+#else
+typedef VecEscalar<double> VecSimdDouble;
+typedef VecEscalar<float> VecSimdFloat;
+#endif
+
+// Envoltura vectorial de cada tipo de coordenada. El punto fijo necesita productos de
+// 64 bits, que SSE2 no tiene por carril, así que va en escalar.
+template <typename S> struct VecDe { typedef VecEscalar<S> Simd; };
+template <> struct VecDe<double> { typedef VecSimdDouble Simd; };
+template <> struct VecDe<float> { typedef VecSimdFloat Simd; };
+
+#endif
@@ -0,0 +1,63 @@
+/*
+* Formato de vértice empacado que comparten el render de OpenGL y el rasterizador por
+* software.
+*/
+#ifndef VERTICE_H
+#define VERTICE_H
+
+#include <cmath>
+#include <cstdint>
+
+// Clases de color. El color de cada vértice ya no es un uniform que se cambia entre
+// llamadas de dibujo sino un índice a una tabla de colores, así que la teselación y el
+// protagonista caben en un solo buffer y se dibujan con una sola llamada.
+enum ClaseColor {
+    CLASE_CEROS = 0,            // Triángulos tipo cero de la teselación principal
+    CLASE_UNOS,                 // Triángulos tipo uno de la teselación principal
+    CLASE_CEROS_PROTAG,         // Triángulos tipo cero del protagonista
+    CLASE_UNOS_PROTAG,          // Triángulos tipo uno del protagonista
+    CLASE_OJOS_BLANCOS,
+    CLASE_OJOS_NEGROS,
+    NUM_CLASES
+};
+
+// Las clases de la teselación principal usan la transformación 0; las del protagonista
+// (incluidos sus ojos), la 1.
+inline int transformacionDeClase(int clase) { return clase >= CLASE_CEROS_PROTAG ? 1 : 0; }
+
+// Todos los vértices caen en [-1, 1] (la semilla está en el círculo unitario), así que
+// la posición se guarda en punto fijo de 16 bits: x = x_real * ESCALA_VERTICE. Eso da
+// una resolución de 3e-5, muy por debajo de un pixel aun con el zoom de la última fase.
+// Con la clase, el borde y el relleno son 8 bytes por vértice, contra 12 de (x, y, z) en
+// float.
+const float ESCALA_VERTICE = 32767.0f;
+
+struct VerticeEmpacado {
+    int16_t x;
+    int16_t y;
+    uint8_t clase;
+    uint8_t borde;          // BordeSector (Penrose.h) de los vértices de la teselación
+    uint8_t relleno[2];
+};
+
+inline VerticeEmpacado empacarVertice(double x, double y, int clase) {
+    VerticeEmpacado v;
+    v.x = (int16_t)std::lround(x * ESCALA_VERTICE);
+    v.y = (int16_t)std::lround(y * ESCALA_VERTICE);
+    v.clase = (uint8_t)clase;
+    v.borde = 0;
+    v.relleno[0] = v.relleno[1] = 0;
+    return v;
+}
+
+// Vértice de la teselación refinada según la vista (Refinamiento.h): la posición ya va
+// en coordenadas de recorte, en float, porque con el acercamiento sin límite no cabe en
+// el punto fijo de VerticeEmpacado. Se dibuja con refinado.vs. 12 bytes.
+struct VerticeRefinado {
+    float x;
+    float y;
+    uint8_t clase;
+    uint8_t relleno[3];
+};
+
+#endif
@@ -0,0 +1,18 @@
+#version 330 core
+// Pedazo del explorador (Explorador.h): los vertices vienen relativos a la esquina del
+// pedazo, que se lleva a la camara en double antes de mandarse, asi que float alcanza
+// aunque la camara este muy lejos del origen.
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in uint aClase;
+
+uniform vec2 desplazamiento;   // Esquina del pedazo menos la camara
+uniform float escala;          // Unidades de recorte por unidad del plano
+uniform vec3 colores[6];
+
+flat out vec3 ourColor;
+
+void main()
+{
+    gl_Position = vec4((aPos + desplazamiento) * escala, 0.0, 1.0);
+    ourColor = colores[aClase];
+}
\ No newline at end of file
@@ -5,10 +5,19 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+// Typed handle to a uniform location. Get it once with Shader::uniform<T>() and pass it
+// to the set* overloads in the render loop so no name lookup happens per frame.
+template <typename T>
+struct Uniform
+{
+    GLint location = -1;
+};
+
 class Shader
 {
 public:
@@ -68,7 +77,8 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-
+        // 3. cache the location of every active uniform
+        cacheUniformLocations();
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -76,66 +86,149 @@ public:
     {
         glUseProgram(ID);
     }
-    // utility uniform functions
+    // uniform locations
+    // ------------------------------------------------------------------------
+    // location of an active uniform from the cache filled at link time, or -1 if the
+    // program has no such uniform (glUniform* calls with location -1 are ignored)
+    GLint location(const std::string& name) const
+    {
+        auto it = uniformLocations.find(name);
+        return it != uniformLocations.end() ? it->second : -1;
+    }
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const
+    {
+        Uniform<T> u;
+        u.location = location(name);
+        return u;
+    }
+    // typed setters that take a cached handle
+    // ------------------------------------------------------------------------
+    void set(Uniform<int> u, int value) const
+    {
+        glUniform1i(u.location, value);
+    }
+    void set(Uniform<float> u, float value) const
+    {
+        glUniform1f(u.location, value);
+    }
+    void set(Uniform<glm::vec2> u, const glm::vec2& value) const
+    {
+        glUniform2fv(u.location, 1, &value[0]);
+    }
+    void set(Uniform<glm::vec3> u, const glm::vec3& value) const
+    {
+        glUniform3fv(u.location, 1, &value[0]);
+    }
+    void set(Uniform<glm::vec3> u, const float value[3]) const
+    {
+        glUniform3fv(u.location, 1, value);
+    }
+    void set(Uniform<glm::vec4> u, const glm::vec4& value) const
+    {
+        glUniform4fv(u.location, 1, &value[0]);
+    }
+    void set(Uniform<glm::mat4> u, const glm::mat4& mat) const
+    {
+        glUniformMatrix4fv(u.location, 1, GL_FALSE, &mat[0][0]);
+    }
+    // uniform arrays: 'count' consecutive elements starting at the handle's location
+    void set(Uniform<glm::vec3> u, const float (*values)[3], GLsizei count) const
+    {
+        glUniform3fv(u.location, count, &values[0][0]);
+    }
+    void set(Uniform<glm::mat4> u, const glm::mat4* mats, GLsizei count) const
+    {
+        glUniformMatrix4fv(u.location, count, GL_FALSE, &mats[0][0][0]);
+    }
+    // utility uniform functions (by name, resolved through the cache)
     // ------------------------------------------------------------------------
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(location(name), (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(location(name), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(location(name), value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string& name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform2fv(location(name), 1, &value[0]);
     }
     void setVec2(const std::string& name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(location(name), x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(location(name), 1, &value[0]);
     }
     void setVec3(const std::string& name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(location(name), x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string& name, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4fv(location(name), 1, &value[0]);
     }
     void setVec4(const std::string& name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(location(name), x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string& name, const glm::mat2& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string& name, const glm::mat3& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    // asks the linked program for all of its active uniforms. Arrays are reported as
+    // "name[0]"; they are stored under both "name[0]" and "name".
+    // ------------------------------------------------------------------------
+    void cacheUniformLocations()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+            std::string uniformName(name.c_str(), length);
+            GLint loc = glGetUniformLocation(ID, uniformName.c_str());
+            if (loc < 0)
+                continue; // uniforms inside uniform blocks have no location
+            uniformLocations[uniformName] = loc;
+            size_t bracket = uniformName.find('[');
+            if (bracket != std::string::npos)
+                uniformLocations[uniformName.substr(0, bracket)] = loc;
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,63 @@
+#version 330 core
+// Prototipo de la teselacion memoizada (Instancias.h): cada instancia es un triangulo
+// grueso y cada vertice del prototipo se coloca dentro de el.
+layout (location = 0) in vec2 aPos;         // (u, v) en punto fijo
+layout (location = 1) in uint aClase;
+layout (location = 2) in uint aTipo;        // TipoVerticePrototipo
+layout (location = 3) in vec2 aEsquinaA;    // Por instancia, en punto fijo del sector 0
+layout (location = 4) in vec2 aEsquinaB;
+layout (location = 5) in vec2 aEsquinaC;
+layout (location = 6) in uvec3 aBordes;     // BordeSector de cada esquina
+
+uniform mat4 transform[2];
+uniform vec3 colores[6];
+uniform mat4 matSector;
+uniform int sector;
+
+flat out vec3 ourColor;
+
+// Igual que en proyecto1.vs: las esquinas en el borde del sector van sobre su rayo.
+vec2 aSector(vec2 q, uint borde)
+{
+    vec2 p = q / 32767.0;
+    if (borde == 0u)
+        return (matSector * vec4(p, 0.0, 1.0)).xy;
+    bool inferior = (borde == 1u) != (sector % 2 == 1);
+    int rayo = ((inferior ? sector - 1 : sector) + 10) % 10;
+    float angulo = float(2 * rayo + 1) * 3.14159265 / 10.0;
+    return length(p) * vec2(cos(angulo), sin(angulo));
+}
+
+void main()
+{
+    vec2 a = aSector(aEsquinaA, aBordes.x);
+    vec2 b = aSector(aEsquinaB, aBordes.y);
+    vec2 c = aSector(aEsquinaC, aBordes.z);
+
+    // Las esquinas se copian tal cual y los vertices de una arista se calculan solo con
+    // sus dos extremos con una formula simetrica: desde el triangulo vecino la arista va
+    // al reves y s cambia de signo, asi que los dos dan el mismo punto y no hay grietas.
+    vec2 p;
+    vec2 e0;
+    vec2 e1;
+    float q = -1.0;
+    if (aTipo == 1u) p = a;
+    else if (aTipo == 2u) p = b;
+    else if (aTipo == 3u) p = c;
+    else if (aTipo == 4u) { e0 = a; e1 = b; q = aPos.x; }
+    else if (aTipo == 5u) { e0 = b; e1 = c; q = aPos.y; }
+    else if (aTipo == 6u) { e0 = c; e1 = a; q = 32767.0 - aPos.y; }
+    else p = a + (aPos.x / 32767.0) * (b - a) + (aPos.y / 32767.0) * (c - a);
+    if (q >= 0.0) {
+        float s = (2.0 * q - 32767.0) / 65534.0;
+        p = 0.5 * (e0 + e1) + s * (e1 - e0);
+    }
+
+    // El sector 0 es el protagonista.
+    uint clase = aClase;
+    if (sector == 0 && clase < 2u)
+        clase += 2u;
+    int t = clase >= 2u ? 1 : 0;
+    gl_Position = transform[t] * vec4(p, 0.0, 1.0);
+    ourColor = colores[clase];
+}
\ No newline at end of file
@@ -1,9 +1,49 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in uint aClase;
+layout (location = 2) in uint aBorde;
 
-uniform mat4 transform;
+uniform mat4 transform[2];
+uniform vec3 colores[6];
+// La teselacion se sube una sola vez (el sector 0) y se dibuja con 10 instancias; cada
+// instancia la lleva a su sector con sectores[] (matrizSector() en Penrose.h).
+uniform mat4 sectores[10];
+uniform int primerSector;
+
+flat out vec3 ourColor;
+
+// Rayo de la rueda en el que queda el borde del sector (rayoDeBorde() en Penrose.cpp).
+int rayoDeBorde(int sector, uint borde)
+{
+    bool inferior = (borde == 1u) != (sector % 2 == 1);
+    return ((inferior ? sector - 1 : sector) + 10) % 10;
+}
 
 void main()
 {
-    gl_Position = transform * vec4(aPos, 1.0);
+    // La instancia i dibuja el sector (i + primerSector) % 10. Con primerSector = 1 el
+    // sector 0 sale al final, encima de los demas: es el protagonista, asi que sus
+    // clases 0 y 1 se cambian por las del protagonista.
+    int sector = (gl_InstanceID + primerSector) % 10;
+    uint clase = aClase;
+    if (sector == 0 && clase < 2u)
+        clase += 2u;
+
+    // La posicion viene en punto fijo (ESCALA_VERTICE en Vertice.h). Los vertices que
+    // comparten dos sectores se ponen sobre su rayo con la misma cuenta en los dos, para
+    // que no queden grietas entre ellos.
+    vec2 p = aPos / 32767.0;
+    vec4 pos;
+    if (aBorde != 0u) {
+        float angulo = float(2 * rayoDeBorde(sector, aBorde) + 1) * 3.14159265 / 10.0;
+        pos = vec4(length(p) * vec2(cos(angulo), sin(angulo)), 0.0, 1.0);
+    }
+    else {
+        pos = sectores[sector] * vec4(p, 0.0, 1.0);
+    }
+
+    // Las clases 0 y 1 son de la teselacion principal; las demas, del protagonista.
+    int t = clase >= 2u ? 1 : 0;
+    gl_Position = transform[t] * pos;
+    ourColor = colores[clase];
 }
\ No newline at end of file
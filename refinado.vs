@@ -0,0 +1,15 @@
+#version 330 core
+// Teselacion refinada segun la vista (Refinamiento.h): los vertices ya vienen en
+// coordenadas de recorte.
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in uint aClase;
+
+uniform vec3 colores[6];
+
+flat out vec3 ourColor;
+
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    ourColor = colores[aClase];
+}
\ No newline at end of file